@@ -0,0 +1,252 @@
+#include "autoplay.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+enum plan_state { PLAN_IDLE, PLAN_ASKED, PLAN_ANSWERED };
+
+/* the solver on a thread of its own, one board at a time */
+struct autoplay_planner {
+	solver s;
+	pdb_set pdb;
+	bool have_pdb;
+	int rows;
+	int cols;
+	std::mutex lock;
+	std::condition_variable wake;
+	plan_state state;
+	int tiles[SOLVER_MAX_CELLS]; // the board asked for, and answered
+	solver_result plan;
+	bool solved;
+	double seconds; // solving, all boards
+	bool quit;
+	std::thread worker;
+};
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+static void planner_main( autoplay_planner *p ) {
+	std::unique_lock<std::mutex> guard( p->lock );
+	while ( !p->quit ) {
+		if ( PLAN_ASKED != p->state ) {
+			p->wake.wait( guard );
+			continue;
+		}
+		board b;
+		bool ok = board_init( &b, p->rows, p->cols, p->tiles );
+		guard.unlock();
+		double start = now_seconds();
+		solver_result plan;
+		ok = ok && solver_solve( &p->s, &b, &plan );
+		double seconds = now_seconds() - start;
+		if ( b.tiles ) {
+			board_free( &b );
+		}
+		guard.lock();
+		p->plan = plan;
+		p->solved = ok;
+		p->seconds += seconds;
+		p->state = PLAN_ANSWERED;
+	}
+}
+
+bool autoplay_init( autoplay *a, const game *g, double rate, unsigned long long max_moves,
+										unsigned long long seed ) {
+	a->rate = rate > 0.0 ? rate : 0.0;
+	a->max_moves = max_moves;
+	a->dist = g->have_dist ? &g->dist : NULL;
+	a->planner = NULL;
+	if ( !board_init( &a->b, g->b.rows, g->b.cols, g->b.tiles ) ) {
+		return false;
+	}
+	if ( !a->dist ) {
+		autoplay_planner *p = new autoplay_planner;
+		if ( !solver_init( &p->s, g->b.rows, g->b.cols ) ) {
+			delete p;
+			board_free( &a->b );
+			return false;
+		}
+		// without them a 4x4 plan expands several times the nodes
+		int n = g->b.rows * g->b.cols;
+		p->have_pdb = false;
+		if ( n > DISTANCE_TABLE_MAX_CELLS && n <= PDB_MAX_CELLS ) {
+			char file_name[64];
+			sprintf( file_name, AUTOPLAY_PDB_FILE, g->b.rows, g->b.cols );
+			p->have_pdb = pdb_open( &p->pdb, file_name, g->b.rows, g->b.cols );
+			if ( p->have_pdb ) {
+				solver_set_pdb( &p->s, &p->pdb );
+			} else {
+				fprintf( stderr, "no %s, run pdb_build %i %i %s for faster autoplay\n", file_name,
+								 g->b.rows, g->b.cols, file_name );
+			}
+		}
+		p->rows = g->b.rows;
+		p->cols = g->b.cols;
+		p->state = PLAN_IDLE;
+		p->solved = false;
+		p->seconds = 0.0;
+		p->quit = false;
+		p->worker = std::thread( planner_main, p );
+		a->planner = p;
+	}
+	a->plan.length = 0;
+	a->plan_next = 0;
+	rng_seed( &a->r, seed );
+	a->walk_left = 0;
+	a->last_dir = -1;
+	a->start_time = 0.0;
+	a->paused = 0.0;
+	a->wait_start = -1.0;
+	a->started = false;
+	a->fed = 0;
+	a->solves = 0;
+	a->plan_seconds = 0.0;
+	a->done = false;
+	a->failed = false;
+	return true;
+}
+
+void autoplay_free( autoplay *a ) {
+	autoplay_planner *p = a->planner;
+	if ( p ) {
+		{
+			std::lock_guard<std::mutex> guard( p->lock );
+			p->quit = true;
+		}
+		// a solve under way finishes first
+		p->wake.notify_one();
+		p->worker.join();
+		if ( p->have_pdb ) {
+			pdb_close( &p->pdb );
+		}
+		delete p;
+		a->planner = NULL;
+	}
+	board_free( &a->b );
+}
+
+/* the planner's answer for a->b into a->plan, if it has one. otherwise asks
+for a->b when the planner is free and returns false */
+static bool take_plan( autoplay *a ) {
+	autoplay_planner *p = a->planner;
+	bool asked = false;
+	{
+		std::lock_guard<std::mutex> guard( p->lock );
+		if ( PLAN_ANSWERED == p->state ) {
+			p->state = PLAN_IDLE;
+			bool same = 0 == memcmp( p->tiles, a->b.tiles, a->b.n * sizeof( int ) );
+			a->plan_seconds = p->seconds;
+			if ( same && !p->solved ) {
+				fprintf( stderr, "ERROR: autoplay could not solve the %ix%i board\n", a->b.rows,
+								 a->b.cols );
+				a->failed = true;
+				a->done = true;
+				return false;
+			}
+			if ( same ) {
+				a->plan = p->plan;
+				a->plan_next = 0;
+				return true;
+			}
+			// planned for a board the player has moved on from
+		}
+		if ( PLAN_IDLE == p->state ) {
+			memcpy( p->tiles, a->b.tiles, a->b.n * sizeof( int ) );
+			p->state = PLAN_ASKED;
+			asked = true;
+		}
+	}
+	if ( asked ) {
+		p->wake.notify_one();
+	}
+	return false;
+}
+
+static bool next_move( autoplay *a, board_dir *dir ) {
+	if ( 0 == a->walk_left && board_is_solved( &a->b ) ) {
+		a->solves++;
+		if ( 0 == a->max_moves ) {
+			a->done = true;
+			return false;
+		}
+		a->walk_left = AUTOPLAY_WALK_MOVES;
+		a->last_dir = -1;
+	}
+	if ( a->walk_left > 0 ) {
+		// any move but the one undoing the last
+		int d;
+		do {
+			d = (int)rng_below( &a->r, 4 );
+		} while ( ( d ^ 1 ) == a->last_dir || board_move_source( &a->b, (board_dir)d ) < 0 );
+		a->last_dir = d;
+		a->walk_left--;
+		*dir = (board_dir)d;
+		return true;
+	}
+	if ( a->dist ) {
+		return distance_table_best_move( a->dist, &a->b, dir );
+	}
+	if ( a->plan_next >= a->plan.length && !take_plan( a ) ) {
+		return false;
+	}
+	*dir = a->plan.moves[a->plan_next++];
+	return true;
+}
+
+int autoplay_feed( autoplay *a, const board *b, double now, board_dir *dirs, int max_dirs ) {
+	if ( a->done ) {
+		return 0;
+	}
+	if ( 0 != memcmp( a->b.tiles, b->tiles, b->n * sizeof( int ) ) ) {
+		// moved under us: plan from where the board really is
+		board_free( &a->b );
+		if ( !board_init( &a->b, b->rows, b->cols, b->tiles ) ) {
+			a->failed = true;
+			a->done = true;
+			return 0;
+		}
+		a->plan.length = 0;
+		a->plan_next = 0;
+		a->walk_left = 0;
+	}
+	if ( !a->started ) {
+		a->started = true;
+		a->start_time = now;
+	}
+	long long due = max_dirs;
+	if ( a->rate > 0.0 ) {
+		// the first move at once, then on the clock. a late frame catches up,
+		// but the clock stands still while the planner works
+		double clock = ( a->wait_start >= 0.0 ? a->wait_start : now ) - a->start_time - a->paused;
+		due = (long long)( clock * a->rate ) + 1 - (long long)a->fed;
+		due = due < max_dirs ? due : max_dirs;
+	}
+	int count = 0;
+	while ( count < due ) {
+		if ( a->max_moves > 0 && a->fed == a->max_moves ) {
+			a->done = true;
+			break;
+		}
+		board_dir dir;
+		if ( !next_move( a, &dir ) ) {
+			if ( !a->done && a->wait_start < 0.0 ) {
+				a->wait_start = now;
+			}
+			break;
+		}
+		if ( a->wait_start >= 0.0 ) {
+			a->paused += now - a->wait_start;
+			a->wait_start = -1.0;
+		}
+		board_move( &a->b, dir );
+		dirs[count++] = dir;
+		a->fed++;
+	}
+	return count;
+}
@@ -0,0 +1,62 @@
+/******************************************************************************\
+| Autoplay: the computer plays, through the same keys a player presses.       |
+| autoplay_feed() hands out the moves due by a time at a fixed rate (or as    |
+| many as asked for, unthrottled), and the caller turns them into arrow key  |
+| events on the input queue, so they go through input_poll(), game_move() and |
+| the renderer exactly like typed ones. Moves are optimal: one lookup each in |
+| the distance table when the game has one, otherwise a plan from the solver |
+| for the whole board, with the pattern databases from pdb_build on boards   |
+| too big for a distance table. The solver runs on its own thread, as a hard  |
+| board can take seconds: no moves are handed out until the plan is ready, so |
+| the wait does not count against the rate. Given a move count it keeps going |
+| past the goal, a random walk away and a solve back, as a demo and a         |
+| throughput benchmark.                                                       |
+\******************************************************************************/
+#ifndef _AUTOPLAY_H_
+#define _AUTOPLAY_H_
+
+#include "game.h"
+#include "rng.h"
+#include "solver.h"
+
+#define AUTOPLAY_RATE 4.0				// moves per second by default
+#define AUTOPLAY_WALK_MOVES 40 // away from the goal between solves
+#define AUTOPLAY_PDB_FILE "puzzle%ix%i.patdb" // rows, cols
+
+struct autoplay_planner;
+
+struct autoplay {
+	double rate;									// moves per second, 0 for as many as asked for
+	unsigned long long max_moves; // 0 to stop at the goal
+	board b;											// where the moves handed out so far leave the board
+	const distance_table *dist;		// NULL to plan with the solver
+	autoplay_planner *planner;		// the solver's thread, NULL with a distance table
+	solver_result plan;
+	int plan_next;
+	rng r;
+	int walk_left;
+	int last_dir;
+	double start_time; // of the first move
+	double paused;		 // seconds waiting on the planner, off the rate's clock
+	double wait_start; // of the wait on the planner going on, -1 for none
+	bool started;
+	unsigned long long fed;
+	unsigned long long solves;
+	double plan_seconds; // spent in the solver, on its thread
+	bool done;
+	bool failed; // the solver could not solve the board
+};
+
+/* plays game 'g' from its current board. 'seed' is for the walks */
+bool autoplay_init( autoplay *a, const game *g, double rate, unsigned long long max_moves,
+										unsigned long long seed );
+
+void autoplay_free( autoplay *a );
+
+/* the moves due by time 'now', at most 'max_dirs'. 'b' is the board they are
+played on: if it is not where the last moves left it (the player moved too)
+the plan starts again from it. never waits on the solver: while it plans
+there are no moves */
+int autoplay_feed( autoplay *a, const board *b, double now, board_dir *dirs, int max_dirs );
+
+#endif
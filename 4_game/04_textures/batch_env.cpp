@@ -0,0 +1,227 @@
+#include "batch_env.h"
+#include "board.h"
+#include "scramble.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/* uniformly random solvable board into slot i, from chunk 'r's stream */
+static void scramble_board( batch_env *e, int i, rng *r ) {
+	int n = e->n;
+	int tiles[BATCH_ENV_MAX_CELLS];
+	scramble_uniform( r, e->rows, e->cols, tiles );
+	int blank = 0;
+	while ( tiles[blank] != n - 1 ) {
+		blank++;
+	}
+	int manhattan = 0;
+	for ( int s = 0; s < n; s++ ) {
+		manhattan += e->md[tiles[s] * BATCH_ENV_MAX_CELLS + s];
+	}
+	e->tiles[i] = bitboard64_from_tiles( tiles, n );
+	e->blank[i] = (unsigned char)blank;
+	e->manhattan[i] = (unsigned char)manhattan;
+	e->steps[i] = 0;
+}
+
+/* the move itself for boards begin..end-1, no bookkeeping */
+static void move_boards( batch_env *e, int begin, int end ) {
+	const unsigned char *actions = e->actions;
+	int i = begin;
+#ifdef __AVX2__
+	const __m256i nibble = _mm256_set1_epi64x( 0xF );
+	const __m256i blank_ids = _mm256_set1_epi64x( e->n - 1 );
+	const __m256i md_row = _mm256_set1_epi64x( BATCH_ENV_MAX_CELLS );
+	// byte 0 of each 32 bit lane to the bottom 4 bytes
+	const __m128i pack_bytes = _mm_setr_epi8( 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+																						-1, -1, -1 );
+	for ( ; i + 4 <= end; i += 4 ) {
+		int blank4, action4;
+		memcpy( &blank4, &e->blank[i], 4 );
+		memcpy( &action4, &actions[i], 4 );
+		__m256i blank = _mm256_cvtepu8_epi64( _mm_cvtsi32_si128( blank4 ) );
+		__m256i action = _mm256_cvtepu8_epi64( _mm_cvtsi32_si128( action4 ) );
+		__m256i index = _mm256_add_epi64( _mm256_slli_epi64( blank, 2 ), action );
+		__m128i from32 = _mm256_i64gather_epi32( e->from, index, 4 );
+		__m256i from = _mm256_cvtepi32_epi64( from32 );
+		__m256i from_shift = _mm256_slli_epi64( from, 2 );
+		__m256i blank_shift = _mm256_slli_epi64( blank, 2 );
+
+		__m256i t = _mm256_loadu_si256( (const __m256i *)&e->tiles[i] );
+		__m256i tile = _mm256_and_si256( _mm256_srlv_epi64( t, from_shift ), nibble );
+		// tile goes where the blank was and the blank to 'from'. both nibbles
+		// flip by tile ^ blank id, which is 0 for an illegal move
+		__m256i x = _mm256_xor_si256( tile, blank_ids );
+		t = _mm256_xor_si256( t, _mm256_xor_si256( _mm256_sllv_epi64( x, from_shift ),
+																							 _mm256_sllv_epi64( x, blank_shift ) ) );
+		_mm256_storeu_si256( (__m256i *)&e->tiles[i], t );
+
+		__m256i tile_row = _mm256_mul_epu32( tile, md_row );
+		__m128i md_to = _mm256_i64gather_epi32( e->md, _mm256_add_epi64( tile_row, blank ), 4 );
+		__m128i md_from = _mm256_i64gather_epi32( e->md, _mm256_add_epi64( tile_row, from ), 4 );
+		int manhattan4;
+		memcpy( &manhattan4, &e->manhattan[i], 4 );
+		__m128i manhattan = _mm_cvtepu8_epi32( _mm_cvtsi32_si128( manhattan4 ) );
+		manhattan = _mm_add_epi32( manhattan, _mm_sub_epi32( md_to, md_from ) );
+		manhattan4 = _mm_cvtsi128_si32( _mm_shuffle_epi8( manhattan, pack_bytes ) );
+		memcpy( &e->manhattan[i], &manhattan4, 4 );
+		blank4 = _mm_cvtsi128_si32( _mm_shuffle_epi8( from32, pack_bytes ) );
+		memcpy( &e->blank[i], &blank4, 4 );
+	}
+#endif
+	for ( ; i < end; i++ ) {
+		int blank = e->blank[i];
+		int from = e->from[blank * 4 + actions[i]];
+		int tile = bitboard64_tile( e->tiles[i], from );
+		e->tiles[i] = bitboard64_move( e->tiles[i], e->n, blank, from );
+		e->manhattan[i] = (unsigned char)( e->manhattan[i] + e->md[tile * BATCH_ENV_MAX_CELLS + blank] -
+																			 e->md[tile * BATCH_ENV_MAX_CELLS + from] );
+		e->blank[i] = (unsigned char)from;
+	}
+}
+
+static void step_chunk( void *arg, int worker ) {
+	batch_env_task *task = (batch_env_task *)arg;
+	batch_env *e = task->env;
+	move_boards( e, task->begin, task->end );
+	for ( int i = task->begin; i < task->end; i++ ) {
+		// Manhattan distance 0 means every tile is home, the blank included
+		int solved = 0 == e->manhattan[i];
+		e->steps[i]++;
+		e->solved[i] = (unsigned char)solved;
+		e->reward[i] = BATCH_ENV_STEP_REWARD + solved * BATCH_ENV_SOLVE_REWARD;
+		e->done[i] = (unsigned char)( solved | ( e->steps[i] >= e->max_steps ) );
+		if ( e->done[i] ) {
+			scramble_board( e, i, &e->rngs[task->chunk] );
+		}
+	}
+}
+
+static void reset_chunk( void *arg, int worker ) {
+	batch_env_task *task = (batch_env_task *)arg;
+	for ( int i = task->begin; i < task->end; i++ ) {
+		scramble_board( task->env, i, &task->env->rngs[task->chunk] );
+	}
+}
+
+/* runs 'fn' on every chunk, on the pool if there is more than one */
+static void for_each_chunk( batch_env *e, task_fn fn ) {
+	if ( 1 == e->chunk_count ) {
+		fn( &e->tasks[0], 0 );
+		return;
+	}
+	for ( int c = 0; c < e->chunk_count; c++ ) {
+		thread_pool_submit( e->pool, fn, &e->tasks[c] );
+	}
+	thread_pool_wait( e->pool );
+}
+
+bool batch_env_init( batch_env *e, int rows, int cols, int count, int max_steps,
+										 unsigned long long seed, int threads ) {
+	memset( e, 0, sizeof( batch_env ) );
+	if ( rows < 2 || cols < 2 || rows * cols > BATCH_ENV_MAX_CELLS || count < 1 ) {
+		fprintf( stderr, "ERROR: batch_env takes boards from 2x2 to %i cells\n",
+						 BATCH_ENV_MAX_CELLS );
+		return false;
+	}
+	// the step counters are 16 bit
+	if ( max_steps < 1 || max_steps > USHRT_MAX ) {
+		fprintf( stderr, "ERROR: batch_env takes 1 to %i steps before a reset, not %i\n", USHRT_MAX,
+						 max_steps );
+		return false;
+	}
+	e->rows = rows;
+	e->cols = cols;
+	e->n = rows * cols;
+	e->count = count;
+	e->max_steps = max_steps;
+	// the tables come from a board so the moves mean the same as in the game
+	board b;
+	board_init( &b, rows, cols, NULL );
+	for ( int blank = 0; blank < e->n; blank++ ) {
+		b.blank = blank;
+		for ( int action = 0; action < 4; action++ ) {
+			int from = board_move_source( &b, (board_dir)action );
+			e->from[blank * 4 + action] = from < 0 ? blank : from;
+		}
+	}
+	board_free( &b );
+	for ( int tile = 0; tile < e->n - 1; tile++ ) {
+		for ( int slot = 0; slot < e->n; slot++ ) {
+			e->md[tile * BATCH_ENV_MAX_CELLS + slot] =
+				abs( tile / cols - slot / cols ) + abs( tile % cols - slot % cols );
+		}
+	}
+
+	e->chunk_count = ( count + BATCH_ENV_CHUNK - 1 ) / BATCH_ENV_CHUNK;
+	e->tiles = (bitboard64 *)malloc( count * sizeof( bitboard64 ) );
+	e->blank = (unsigned char *)malloc( count );
+	e->manhattan = (unsigned char *)malloc( count );
+	e->steps = (unsigned short *)malloc( count * sizeof( unsigned short ) );
+	e->reward = (float *)calloc( count, sizeof( float ) );
+	e->done = (unsigned char *)calloc( count, 1 );
+	e->solved = (unsigned char *)calloc( count, 1 );
+	e->rngs = (rng *)malloc( e->chunk_count * sizeof( rng ) );
+	e->tasks = (batch_env_task *)malloc( e->chunk_count * sizeof( batch_env_task ) );
+	e->pool = e->chunk_count > 1 ? thread_pool_create( threads ) : NULL;
+	if ( !e->tiles || !e->blank || !e->manhattan || !e->steps || !e->reward || !e->done ||
+			 !e->solved || !e->rngs || !e->tasks || ( e->chunk_count > 1 && !e->pool ) ) {
+		fprintf( stderr, "ERROR: could not allocate %i boards\n", count );
+		batch_env_free( e );
+		return false;
+	}
+	for ( int c = 0; c < e->chunk_count; c++ ) {
+		rng_seed( &e->rngs[c], seed + (unsigned long long)c );
+		e->tasks[c].env = e;
+		e->tasks[c].chunk = c;
+		e->tasks[c].begin = c * BATCH_ENV_CHUNK;
+		e->tasks[c].end = c + 1 < e->chunk_count ? ( c + 1 ) * BATCH_ENV_CHUNK : count;
+	}
+	batch_env_reset( e );
+	return true;
+}
+
+void batch_env_free( batch_env *e ) {
+	if ( e->pool ) {
+		thread_pool_destroy( e->pool );
+	}
+	free( e->tiles );
+	free( e->blank );
+	free( e->manhattan );
+	free( e->steps );
+	free( e->reward );
+	free( e->done );
+	free( e->solved );
+	free( e->rngs );
+	free( e->tasks );
+	memset( e, 0, sizeof( batch_env ) );
+}
+
+void batch_env_reset( batch_env *e ) { for_each_chunk( e, reset_chunk ); }
+
+void batch_env_step( batch_env *e, const unsigned char *actions ) {
+	e->actions = actions;
+	for_each_chunk( e, step_chunk );
+}
+
+bool batch_env_check( const batch_env *e ) {
+	for ( int i = 0; i < e->count; i++ ) {
+		unsigned int seen = 0;
+		int manhattan = 0;
+		for ( int slot = 0; slot < e->n; slot++ ) {
+			int tile = batch_env_tile( e, i, slot );
+			seen |= 1u << tile;
+			manhattan += e->md[tile * BATCH_ENV_MAX_CELLS + slot];
+		}
+		if ( seen != ( 1u << e->n ) - 1 || batch_env_tile( e, i, e->blank[i] ) != e->n - 1 ||
+				 manhattan != e->manhattan[i] ) {
+			fprintf( stderr, "ERROR: batch_env board %i is inconsistent\n", i );
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,83 @@
+/******************************************************************************\
+| Batch environment for training move-selection agents.                       |
+| Holds many boards (up to 4x4) as structure of arrays: every board is one    |
+| bitboard64 (tile nibbles, slot s in bits 4s..4s+3) plus byte arrays       |
+| for the blank slot, Manhattan distance and step count. batch_env_step()     |
+| applies one action per board branch-free (an illegal move takes the blank   |
+| as its own source and changes nothing), four boards at a time with AVX2     |
+| when the compiler targets it, keeps the Manhattan distances up to date      |
+| incrementally and writes the rewards and done flags. Boards that finish are |
+| reset straight away with a fresh uniformly random solvable scramble.        |
+| The boards are cut into fixed chunks, each with its own random stream, and  |
+| the chunks are stepped on the thread pool, so the results do not depend on  |
+| the number of threads.                                                       |
+\******************************************************************************/
+#ifndef _BATCH_ENV_H_
+#define _BATCH_ENV_H_
+
+#include "bitboard.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+#define BATCH_ENV_MAX_CELLS 16
+#define BATCH_ENV_CHUNK 4096 // boards per task and per random stream
+#define BATCH_ENV_STEP_REWARD -1.0f
+#define BATCH_ENV_SOLVE_REWARD 10.0f // on top of the step reward
+
+struct batch_env;
+
+struct batch_env_task {
+	batch_env *env;
+	int chunk;
+	int begin;
+	int end;
+};
+
+struct batch_env {
+	int rows;
+	int cols;
+	int n;
+	int count;
+	int max_steps; // a board that has not been solved by then is reset. at most 65535
+	// per board
+	bitboard64 *tiles;
+	unsigned char *blank;
+	unsigned char *manhattan;
+	unsigned short *steps;
+	float *reward;				// of the last step
+	unsigned char *done;	// last step solved the board or ran out of steps
+	unsigned char *solved; // last step solved the board
+	// lookup tables, int so the AVX2 path can gather from them
+	int from[BATCH_ENV_MAX_CELLS * 4];									 // [blank * 4 + action], blank if illegal
+	int md[BATCH_ENV_MAX_CELLS * BATCH_ENV_MAX_CELLS]; // [tile * 16 + slot], 0 for the blank
+	const unsigned char *actions;											 // of the step being run
+	rng *rngs;																				 // one per chunk
+	batch_env_task *tasks;
+	int chunk_count;
+	thread_pool *pool;
+};
+
+/* 'count' rows x cols boards, all scrambled. 'max_steps' from 1 to 65535.
+'threads' 0 for one per hardware thread */
+bool batch_env_init( batch_env *e, int rows, int cols, int count, int max_steps,
+										 unsigned long long seed, int threads );
+
+void batch_env_free( batch_env *e );
+
+/* fresh scrambles for every board */
+void batch_env_reset( batch_env *e );
+
+/* applies actions[i] (a board_dir) to board i, for every board, then fills
+reward, solved and done and resets the boards that are done */
+void batch_env_step( batch_env *e, const unsigned char *actions );
+
+/* tile in 'slot' of board i */
+inline int batch_env_tile( const batch_env *e, int i, int slot ) {
+	return bitboard64_tile( e->tiles[i], slot );
+}
+
+/* is the state of every board consistent (tiles a permutation, blank and
+Manhattan distance right)? O(count * n), for tests and benchmarks */
+bool batch_env_check( const batch_env *e );
+
+#endif
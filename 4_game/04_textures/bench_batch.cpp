@@ -0,0 +1,87 @@
+/******************************************************************************\
+| Throughput of the batch environment.                                         |
+|   ./bench_batch [boards] [steps] [rows] [cols]                                |
+| Steps 100000 4x4 boards (by default) with random actions on 1, 2, 4 ...     |
+| threads up to the hardware thread count and prints board-steps per second.  |
+| The checksum of the final boards must be the same on every line: the       |
+| random streams belong to chunks of boards, not to threads.                  |
+\******************************************************************************/
+#include "batch_env.h"
+#include "rng.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#define ACTION_SETS 16
+#define MAX_STEPS 400
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+int main( int argc, char **argv ) {
+	int boards = argc > 1 ? atoi( argv[1] ) : 100000;
+	int steps = argc > 2 ? atoi( argv[2] ) : 200;
+	int rows = argc > 3 ? atoi( argv[3] ) : 4;
+	int cols = argc > 4 ? atoi( argv[4] ) : 4;
+	int max_threads = (int)std::thread::hardware_concurrency();
+	if ( max_threads < 1 ) {
+		max_threads = 1;
+	}
+	// the agent's side: a few sets of random actions, used in turn
+	unsigned char *actions = (unsigned char *)malloc( (size_t)ACTION_SETS * boards );
+	if ( !actions ) {
+		fprintf( stderr, "ERROR: could not allocate the actions\n" );
+		return 1;
+	}
+	rng r;
+	rng_seed( &r, 7 );
+	for ( long long i = 0; i < (long long)ACTION_SETS * boards; i++ ) {
+		actions[i] = (unsigned char)( rng_next( &r ) & 3 );
+	}
+#ifdef __AVX2__
+	const char *path = "AVX2";
+#else
+	const char *path = "scalar";
+#endif
+	printf( "%i %ix%i boards, %i steps, %s moves\n", boards, rows, cols, steps, path );
+	printf( "%8s %12s %18s %10s %18s\n", "threads", "seconds", "board-steps/s", "solves",
+					"checksum" );
+	for ( int threads = 1;; threads *= 2 ) {
+		if ( threads > max_threads ) {
+			threads = max_threads;
+		}
+		batch_env e;
+		if ( !batch_env_init( &e, rows, cols, boards, MAX_STEPS, 1, threads ) ) {
+			return 1;
+		}
+		unsigned long long solves = 0;
+		double start = now_seconds();
+		for ( int s = 0; s < steps; s++ ) {
+			batch_env_step( &e, &actions[(size_t)( s % ACTION_SETS ) * boards] );
+			// reading the results is part of a step for an agent too
+			for ( int i = 0; i < boards; i++ ) {
+				solves += e.solved[i];
+			}
+		}
+		double seconds = now_seconds() - start;
+		unsigned long long checksum = 0;
+		for ( int i = 0; i < boards; i++ ) {
+			checksum = checksum * 31 + e.tiles[i];
+		}
+		printf( "%8i %12.3f %18.0f %10llu %18llx\n", threads, seconds,
+						(double)boards * steps / seconds, solves, checksum );
+		bool ok = batch_env_check( &e );
+		batch_env_free( &e );
+		if ( !ok ) {
+			return 1;
+		}
+		if ( threads == max_threads ) {
+			break;
+		}
+	}
+	free( actions );
+	return 0;
+}
@@ -0,0 +1,156 @@
+/******************************************************************************\
+| Packed boards against the plain int array board.                             |
+|   ./bench_bitboard [moves]                                                   |
+| Walks a 4x4 and a 5x5 board through the same random moves three ways and   |
+| evaluates Manhattan distance + linear conflicts after every move:          |
+|  naive    board_move() and a straightforward loop over board::tiles         |
+|  tiles    board_move() and the table driven bitboard_tiles_heuristic()     |
+|  packed   bitboard64 (4x4) or bitboard128 (5x5) moves and SIMD evaluation  |
+| The sums of the estimates must agree on every line.                        |
+\******************************************************************************/
+#include "bitboard.h"
+#include "board.h"
+#include "rng.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/* Manhattan distance + linear conflicts the obvious way */
+static int naive_heuristic( const board *b ) {
+	int h = 0;
+	for ( int slot = 0; slot < b->n; slot++ ) {
+		int tile = b->tiles[slot];
+		if ( tile != b->n - 1 ) {
+			h += abs( tile / b->cols - slot / b->cols ) + abs( tile % b->cols - slot % b->cols );
+		}
+	}
+	// a pair of tiles in their goal line but the wrong way round costs 2 more.
+	// removing the fewest tiles that leave no such pair gives the line's cost
+	for ( int kind = 0; kind < 2; kind++ ) {
+		int lines = 0 == kind ? b->rows : b->cols;
+		int length = 0 == kind ? b->cols : b->rows;
+		for ( int line = 0; line < lines; line++ ) {
+			int goals[BITBOARD_MAX_SIDE];
+			int count = 0;
+			for ( int k = 0; k < length; k++ ) {
+				int slot = 0 == kind ? line * b->cols + k : k * b->cols + line;
+				int tile = b->tiles[slot];
+				if ( tile == b->n - 1 ) {
+					continue;
+				}
+				int tile_line = 0 == kind ? tile / b->cols : tile % b->cols;
+				if ( tile_line == line ) {
+					goals[count++] = 0 == kind ? tile % b->cols : tile / b->cols;
+				}
+			}
+			int lis[BITBOARD_MAX_SIDE];
+			int longest = 0;
+			for ( int i = 0; i < count; i++ ) {
+				lis[i] = 1;
+				for ( int j = 0; j < i; j++ ) {
+					if ( goals[j] < goals[i] && lis[j] + 1 > lis[i] ) {
+						lis[i] = lis[j] + 1;
+					}
+				}
+				if ( lis[i] > longest ) {
+					longest = lis[i];
+				}
+			}
+			h += 2 * ( count - longest );
+		}
+	}
+	return h;
+}
+
+static void report( const char *name, int rows, int cols, int moves, double seconds,
+										unsigned long long sum ) {
+	printf( "%ix%i %-8s %10.2f %14llu\n", rows, cols, name, seconds * 1e9 / moves, sum );
+}
+
+static bool bench_size( int rows, int cols, const unsigned char *dirs, int moves ) {
+	bitboard_tables t;
+	board b;
+	if ( !bitboard_tables_init( &t, rows, cols ) || !board_init( &b, rows, cols, NULL ) ) {
+		fprintf( stderr, "ERROR: could not set up a %ix%i board\n", rows, cols );
+		return false;
+	}
+	unsigned long long sums[3] = { 0, 0, 0 };
+
+	double start = now_seconds();
+	for ( int i = 0; i < moves; i++ ) {
+		board_move( &b, (board_dir)dirs[i] );
+		board_clear_dirty( &b );
+		sums[0] += naive_heuristic( &b );
+	}
+	report( "naive", rows, cols, moves, now_seconds() - start, sums[0] );
+
+	board_free( &b );
+	board_init( &b, rows, cols, NULL );
+	start = now_seconds();
+	for ( int i = 0; i < moves; i++ ) {
+		board_move( &b, (board_dir)dirs[i] );
+		board_clear_dirty( &b );
+		sums[1] += bitboard_tiles_heuristic( &t, b.tiles );
+	}
+	report( "tiles", rows, cols, moves, now_seconds() - start, sums[1] );
+
+	board_free( &b );
+	board_init( &b, rows, cols, NULL );
+	int blank = b.blank;
+	start = now_seconds();
+	if ( b.n <= 16 ) {
+		bitboard64 packed = bitboard64_from_tiles( b.tiles, b.n );
+		for ( int i = 0; i < moves; i++ ) {
+			int from = t.from[blank][dirs[i]];
+			packed = bitboard64_move( packed, b.n, blank, from );
+			blank = from;
+			sums[2] += bitboard64_heuristic( &t, packed );
+		}
+	} else {
+		bitboard128 packed = bitboard128_from_tiles( b.tiles, b.n );
+		for ( int i = 0; i < moves; i++ ) {
+			int from = t.from[blank][dirs[i]];
+			bitboard128_move( &packed, b.n, blank, from );
+			blank = from;
+			sums[2] += bitboard128_heuristic( &t, &packed );
+		}
+	}
+	report( b.n <= 16 ? "packed64" : "packed128", rows, cols, moves, now_seconds() - start,
+					sums[2] );
+	board_free( &b );
+
+	if ( sums[0] != sums[1] || sums[0] != sums[2] ) {
+		fprintf( stderr, "ERROR: the %ix%i estimates do not agree\n", rows, cols );
+		return false;
+	}
+	return true;
+}
+
+int main( int argc, char **argv ) {
+	int moves = argc > 1 ? atoi( argv[1] ) : 10000000;
+	unsigned char *dirs = (unsigned char *)malloc( moves );
+	if ( !dirs ) {
+		fprintf( stderr, "ERROR: could not allocate %i moves\n", moves );
+		return 1;
+	}
+	rng r;
+	rng_seed( &r, 13 );
+	for ( int i = 0; i < moves; i++ ) {
+		dirs[i] = (unsigned char)( rng_next( &r ) & 3 );
+	}
+#ifdef BITBOARD_SIMD
+	const char *path = "SSSE3";
+#else
+	const char *path = "scalar";
+#endif
+	printf( "%i random moves, %s evaluation\n", moves, path );
+	printf( "%-12s %10s %14s\n", "board", "ns/move", "sum" );
+	bool ok = bench_size( 4, 4, dirs, moves ) && bench_size( 5, 5, dirs, moves );
+	free( dirs );
+	return ok ? 0 : 1;
+}
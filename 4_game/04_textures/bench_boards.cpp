@@ -0,0 +1,101 @@
+/******************************************************************************\
+| Frame time benchmark for the wall renderer: 1, 100, 10 000 and 100 000     |
+| 3x3 boards on screen at once. Every frame a fixed number of boards make a    |
+| random move and one board is hidden or shown again, so the CPU work and the |
+| uploads per frame stay the same whatever the board count; only the GPU has |
+| more to draw. Reports the CPU time to issue a frame (updates and the one    |
+| multi-draw), the whole frame time with the GPU finished, and the bytes       |
+| uploaded per frame.                                                          |
+| For numbers under Mesa's software rasteriser run it as                       |
+|   LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./bench_boards             |
+\******************************************************************************/
+#include "gl_utils.h"
+#include "board.h"
+#include "wall_renderer.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int g_gl_width = 640;
+int g_gl_height = 480;
+GLFWwindow *g_window = NULL;
+
+#define WARMUP_FRAMES 20
+#define TIMED_FRAMES 200
+#define MOVES_PER_FRAME 16
+
+int main() {
+	restart_gl_log();
+	if ( !start_gl( "bench_boards" ) ) {
+		return 1;
+	}
+	// we want to time the draw, not wait on the display refresh
+	glfwSwapInterval( 0 );
+	GLuint programme = create_programme_from_files( "wall_vs.glsl", "test_fs.glsl" );
+	glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
+	glEnable( GL_DEPTH_TEST );
+
+	const GLubyte *gl_renderer = glGetString( GL_RENDERER );
+	printf( "renderer: %s\n", gl_renderer );
+	printf( "%10s %12s %14s %14s %14s\n", "boards", "tiles", "cpu ms/frame", "ms/frame",
+					"bytes/frame" );
+
+	int counts[] = { 1, 100, 10000, 100000 };
+	int n_counts = sizeof( counts ) / sizeof( counts[0] );
+	srand( 1 );
+	for ( int c = 0; c < n_counts; c++ ) {
+		int count = counts[c];
+		board *boards = (board *)malloc( count * sizeof( board ) );
+		for ( int i = 0; i < count; i++ ) {
+			if ( !board_init( &boards[i], 3, 3, NULL ) ) {
+				fprintf( stderr, "ERROR: could not create board %i\n", i );
+				return 1;
+			}
+		}
+		wall_renderer r;
+		if ( !wall_renderer_init( &r, boards, count, programme ) ) {
+			return 1;
+		}
+		double start = 0.0;
+		double cpu = 0.0;
+		unsigned long long bytes = 0;
+		for ( int frame = 0; frame < WARMUP_FRAMES + TIMED_FRAMES; frame++ ) {
+			if ( WARMUP_FRAMES == frame ) {
+				glFinish();
+				start = glfwGetTime();
+				bytes = r.bytes_uploaded;
+			}
+			double now = glfwGetTime();
+			for ( int m = 0; m < MOVES_PER_FRAME; m++ ) {
+				int i = rand() % count;
+				while ( !board_move( &boards[i], (board_dir)( rand() % 4 ) ) ) {
+				}
+				wall_renderer_update( &r, i, &boards[i], now );
+			}
+			// one board blinks, to patch a command every frame
+			wall_renderer_show( &r, frame % count, frame % 2 == 1 );
+			glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+			wall_renderer_draw( &r, now );
+			if ( frame >= WARMUP_FRAMES ) {
+				cpu += glfwGetTime() - now;
+			}
+			glfwSwapBuffers( g_window );
+			glfwPollEvents();
+		}
+		glFinish();
+		double ms = ( glfwGetTime() - start ) * 1000.0 / TIMED_FRAMES;
+		double cpu_ms = cpu * 1000.0 / TIMED_FRAMES;
+		int per_frame = (int)( ( r.bytes_uploaded - bytes ) / TIMED_FRAMES );
+		printf( "%10i %12i %14.3f %14.3f %14i\n", count, 9 * count, cpu_ms, ms, per_frame );
+		gl_log( "bench_boards %i: %.3f cpu ms/frame, %.3f ms/frame\n", count, cpu_ms, ms );
+		wall_renderer_free( &r );
+		for ( int i = 0; i < count; i++ ) {
+			board_free( &boards[i] );
+		}
+		free( boards );
+	}
+
+	glfwTerminate();
+	return 0;
+}
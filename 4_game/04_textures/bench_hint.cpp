@@ -0,0 +1,139 @@
+/******************************************************************************\
+| Hint engine latency, without a window.                                      |
+|   ./bench_hint [boards] [think seconds]                                     |
+| For random 3x3 boards and 4x4 boards a random walk away from the goal, asks  |
+| for a hint and waits for the answer to be proven optimal (or the think time |
+| to run out), then follows the hints to the goal as a player would. Prints   |
+| the time to the first and to the optimal answer, the time to an answer after |
+| following a hint (the tree carried over), and the cost of a read.          |
+\******************************************************************************/
+#include "hint.h"
+#include "rng.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+static void random_walk( board *b, rng *r, int moves ) {
+	int done = 0;
+	int last = -1;
+	while ( done < moves ) {
+		int dir = (int)rng_below( r, 4 );
+		if ( ( dir ^ 1 ) == last ) {
+			continue; // don't undo the move before
+		}
+		if ( board_move( b, (board_dir)dir ) ) {
+			last = dir;
+			done++;
+		}
+	}
+}
+
+/* polls for an answer, a proven optimal one if 'optimal'. false on timeout */
+static bool wait_for( hint_engine *h, hint *out, bool optimal, double timeout ) {
+	double start = now_seconds();
+	while ( now_seconds() - start < timeout ) {
+		if ( hint_engine_read( h, out ) && ( !optimal || out->optimal ) ) {
+			return true;
+		}
+		std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+	}
+	return false;
+}
+
+static void bench_size( int rows, int cols, int walk, int boards, double think ) {
+	hint_options options;
+	options.think_seconds = think;
+	options.max_nodes = HINT_MAX_NODES;
+	hint_engine *h = hint_engine_create( rows, cols, &options );
+	if ( !h ) {
+		return;
+	}
+	rng r;
+	rng_seed( &r, 1 );
+	board b;
+	board_init( &b, rows, cols, NULL );
+	int followed = 0;
+	int wrong = 0;
+	double follow_sum = 0.0;
+	double follow_max = 0.0;
+	for ( int i = 0; i < boards; i++ ) {
+		random_walk( &b, &r, walk );
+		if ( board_is_solved( &b ) ) {
+			continue;
+		}
+		hint first;
+		hint_engine_set_board( h, &b );
+		if ( !wait_for( h, &first, true, think + 1.0 ) ) {
+			wait_for( h, &first, false, 0.0 );
+		}
+		// follow the hints to the goal
+		int moves_left = first.optimal ? first.moves : -1;
+		while ( !board_is_solved( &b ) ) {
+			hint next;
+			if ( !hint_engine_read( h, &next ) || !board_move( &b, next.dir ) ) {
+				wrong++;
+				break;
+			}
+			if ( board_is_solved( &b ) ) {
+				break;
+			}
+			double start = now_seconds();
+			hint_engine_set_board( h, &b );
+			if ( !wait_for( h, &next, moves_left > 0, think + 1.0 ) ) {
+				wrong++;
+				break;
+			}
+			double latency = now_seconds() - start;
+			follow_sum += latency;
+			follow_max = latency > follow_max ? latency : follow_max;
+			followed++;
+			if ( moves_left > 0 && next.moves != --moves_left ) {
+				wrong++; // the optimal plan must shrink by one move a step
+			}
+		}
+	}
+
+	// a read is what the render loop pays every frame
+	hint out;
+	int reads = 1000000;
+	volatile int hits = 0;
+	double start = now_seconds();
+	for ( int i = 0; i < reads; i++ ) {
+		hits += hint_engine_read( h, &out ) ? 1 : 0;
+	}
+	double read_ns = ( now_seconds() - start ) * 1e9 / reads;
+
+	hint_stats stats;
+	hint_engine_stats( h, &stats );
+	printf( "%ix%i, %i boards (walks of %i moves):\n", rows, cols, boards, walk );
+	printf( "  first answer   %8.3f ms mean %8.3f ms max\n",
+					1000.0 * stats.first_answer_seconds_sum / ( stats.answered ? stats.answered : 1 ),
+					1000.0 * stats.first_answer_seconds_max );
+	printf( "  optimal        %8.3f ms mean, %llu of %llu boards\n",
+					1000.0 * stats.optimal_seconds_sum / ( stats.optimal ? stats.optimal : 1 ), stats.optimal,
+					stats.boards );
+	printf( "  after a move   %8.3f ms mean %8.3f ms max over %i followed hints\n",
+					1000.0 * follow_sum / ( followed ? followed : 1 ), 1000.0 * follow_max, followed );
+	printf( "  read           %8.2f ns\n", read_ns );
+	printf( "  %llu nodes in the tree, %llu expanded, %i resets\n", stats.nodes, stats.expanded,
+					stats.resets );
+	if ( wrong ) {
+		fprintf( stderr, "ERROR: %i hints were missing or not on an optimal path\n", wrong );
+	}
+	board_free( &b );
+	hint_engine_destroy( h );
+}
+
+int main( int argc, char **argv ) {
+	int boards = argc > 1 ? atoi( argv[1] ) : 20;
+	double think = argc > 2 ? atof( argv[2] ) : HINT_THINK_SECONDS;
+	bench_size( 3, 3, 200, boards, think );
+	bench_size( 4, 4, 40, boards, think );
+	return 0;
+}
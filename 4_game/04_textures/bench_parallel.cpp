@@ -0,0 +1,142 @@
+/******************************************************************************\
+| Thread scaling report for solver_solve_parallel().                           |
+|   ./bench_parallel [instance file] [4x4 pattern database] [split depth]      |
+| The instance file uses the same Korf format as bench_solver; without one (or |
+| with -) a few hard 4x4 boards are made by long random walks. Each is solved  |
+| with 1, 2, 4 ... threads up to the hardware thread count and the wall time  |
+| and speed-up over one thread are printed. Every parallel solution must be   |
+| as short as solver_solve()'s, or the run fails.                              |
+\******************************************************************************/
+#include "board.h"
+#include "solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define MAX_BOARDS 100
+#define GENERATED_BOARDS 4
+#define MAX_LINE 512
+
+/* Korf's boards have the blank first, see bench_solver.cpp */
+static void korf_to_board( const int *korf, int n, int *tiles ) {
+	for ( int pos = 0; pos < n; pos++ ) {
+		tiles[n - 1 - pos] = n - 1 - korf[pos];
+	}
+}
+
+static int load_boards( const char *file_name, int boards[][16] ) {
+	FILE *file = fopen( file_name, "r" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open instance file %s\n", file_name );
+		return 0;
+	}
+	int count = 0;
+	char line[MAX_LINE];
+	while ( count < MAX_BOARDS && fgets( line, MAX_LINE, file ) ) {
+		int values[17];
+		int n_values = 0;
+		for ( char *tok = strtok( line, " \t\r\n" ); tok && n_values < 17;
+					tok = strtok( NULL, " \t\r\n" ) ) {
+			values[n_values++] = atoi( tok );
+		}
+		if ( n_values >= 16 ) {
+			korf_to_board( values + ( n_values - 16 ), 16, boards[count++] );
+		}
+	}
+	fclose( file );
+	return count;
+}
+
+/* random walks until the heuristic says the board is deep enough */
+static int generate_boards( const solver *s, int boards[][16] ) {
+	srand( 2024 );
+	for ( int i = 0; i < GENERATED_BOARDS; i++ ) {
+		board b;
+		board_init( &b, 4, 4, NULL );
+		do {
+			for ( int k = 0; k < 1000; k++ ) {
+				board_move( &b, (board_dir)( rand() % 4 ) );
+			}
+		} while ( solver_heuristic( s, b.tiles ) < 46 );
+		memcpy( boards[i], b.tiles, sizeof( boards[i] ) );
+		board_free( &b );
+	}
+	return GENERATED_BOARDS;
+}
+
+int main( int argc, char **argv ) {
+	static int boards[MAX_BOARDS][16];
+	solver s;
+	solver_init( &s, 4, 4 );
+	pdb_set pdb;
+	bool have_pdb = argc > 2 && pdb_open( &pdb, argv[2], 4, 4 );
+	if ( have_pdb ) {
+		solver_set_pdb( &s, &pdb );
+	}
+	bool use_file = argc > 1 && 0 != strcmp( argv[1], "-" );
+	int count = use_file ? load_boards( argv[1], boards ) : generate_boards( &s, boards );
+	if ( 0 == count ) {
+		return 1;
+	}
+	int split_depth = argc > 3 ? atoi( argv[3] ) : 10;
+	int max_threads = (int)std::thread::hardware_concurrency();
+	if ( max_threads < 1 ) {
+		max_threads = 1;
+	}
+	printf( "%i boards, split depth %i, %s, up to %i threads\n", count, split_depth,
+					have_pdb ? "pattern databases" : "linear conflicts", max_threads );
+
+	// the serial lengths every parallel one is held to
+	static int optimal[MAX_BOARDS];
+	for ( int i = 0; i < count; i++ ) {
+		board b;
+		board_init( &b, 4, 4, boards[i] );
+		solver_result r;
+		optimal[i] = solver_solve( &s, &b, &r ) ? r.length : -1;
+		board_free( &b );
+	}
+
+	bool all_optimal = true;
+	double base_seconds = 0.0;
+	for ( int threads = 1;; threads *= 2 ) {
+		if ( threads > max_threads ) {
+			threads = max_threads;
+		}
+		solver_parallel_options options;
+		options.threads = threads;
+		options.split_depth = split_depth;
+		options.tt_log2_slots = 22;
+		double seconds = 0.0;
+		unsigned long long nodes = 0;
+		for ( int i = 0; i < count; i++ ) {
+			board b;
+			board_init( &b, 4, 4, boards[i] );
+			solver_result r;
+			if ( !solver_solve_parallel( &s, &b, &options, &r ) ) {
+				fprintf( stderr, "ERROR: board %i not solved\n", i );
+				all_optimal = false;
+			} else if ( r.length != optimal[i] ) {
+				fprintf( stderr, "ERROR: board %i solved in %i moves with %i threads, serial %i\n", i,
+								 r.length, threads, optimal[i] );
+				all_optimal = false;
+			}
+			seconds += r.seconds;
+			nodes += r.nodes;
+			board_free( &b );
+		}
+		if ( 1 == threads ) {
+			base_seconds = seconds;
+		}
+		printf( "%3i threads: %9.3f s, %14llu nodes, %7.2f Mnodes/s, speed-up %5.2fx\n", threads,
+						seconds, nodes, nodes / seconds / 1e6, base_seconds / seconds );
+		fflush( stdout );
+		if ( threads == max_threads ) {
+			break;
+		}
+	}
+	if ( have_pdb ) {
+		pdb_close( &pdb );
+	}
+	return all_optimal ? 0 : 1;
+}
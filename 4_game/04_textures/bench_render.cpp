@@ -0,0 +1,82 @@
+/******************************************************************************\
+| Frame time benchmark for the instanced board renderer.                       |
+| Draws boards from 3x3 up to 1024x1024 with one move per frame, so several    |
+| slides overlap, and reports the average CPU+GPU time per frame and the bytes |
+| uploaded per move.                                                           |
+| For numbers under Mesa's software rasteriser run it as                       |
+|   LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./bench_render             |
+\******************************************************************************/
+#include "gl_utils.h"
+#include "board.h"
+#include "board_renderer.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int g_gl_width = 640;
+int g_gl_height = 480;
+GLFWwindow *g_window = NULL;
+
+#define WARMUP_FRAMES 20
+#define TIMED_FRAMES 200
+
+int main() {
+	restart_gl_log();
+	if ( !start_gl( "bench_render" ) ) {
+		return 1;
+	}
+	// we want to time the draw, not wait on the display refresh
+	glfwSwapInterval( 0 );
+	GLuint programme = create_programme_from_files( "test_vs.glsl", "test_fs.glsl" );
+	glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
+	glEnable( GL_DEPTH_TEST );
+
+	const GLubyte *gl_renderer = glGetString( GL_RENDERER );
+	printf( "renderer: %s\n", gl_renderer );
+	printf( "%10s %12s %14s %14s\n", "board", "tiles", "ms/frame", "bytes/move" );
+
+	int sizes[] = { 3, 4, 8, 32, 128, 256, 512, 1024 };
+	int n_sizes = sizeof( sizes ) / sizeof( sizes[0] );
+	srand( 1 );
+	for ( int s = 0; s < n_sizes; s++ ) {
+		int dim = sizes[s];
+		board b;
+		if ( !board_init( &b, dim, dim, NULL ) ) {
+			fprintf( stderr, "ERROR: could not create %ix%i board\n", dim, dim );
+			return 1;
+		}
+		board_renderer r;
+		if ( !board_renderer_init( &r, &b, programme ) ) {
+			return 1;
+		}
+		double start = 0.0;
+		for ( int frame = 0; frame < WARMUP_FRAMES + TIMED_FRAMES; frame++ ) {
+			if ( WARMUP_FRAMES == frame ) {
+				glFinish();
+				start = glfwGetTime();
+			}
+			// one random legal move per frame, like a fast player
+			while ( !board_move( &b, (board_dir)( rand() % 4 ) ) ) {
+			}
+			double now = glfwGetTime();
+			board_renderer_update( &r, &b, now );
+			glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+			board_renderer_draw( &r, now );
+			glfwSwapBuffers( g_window );
+			glfwPollEvents();
+		}
+		glFinish();
+		double ms = ( glfwGetTime() - start ) * 1000.0 / TIMED_FRAMES;
+		char name[32];
+		sprintf( name, "%ix%i", dim, dim );
+		// a move uploads the instance of the tile that slid and of the blank
+		printf( "%10s %12i %14.3f %14i\n", name, b.n, ms, (int)( 2 * sizeof( tile_instance ) ) );
+		gl_log( "bench_render %s: %.3f ms/frame\n", name, ms );
+		board_renderer_free( &r );
+		board_free( &b );
+	}
+
+	glfwTerminate();
+	return 0;
+}
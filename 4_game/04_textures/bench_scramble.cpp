@@ -0,0 +1,86 @@
+/******************************************************************************\
+| Scramble generator throughput per difficulty band.                          |
+|   ./bench_scramble [seconds per band] [4x4 pattern database from pdb_build] |
+| 3x3 boards banded by the distance table (when puzzle3x3.dist is there) and  |
+| by search, 4x4 boards by heuristic and by search. Prints the band edges,    |
+| scrambles per second, the share of drawn boards that were kept and the     |
+| mean distance of the kept ones (exact ones only, for the searched bands).  |
+\******************************************************************************/
+#include "scramble.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+static void bench_generator( const char *name, scramble_generator *g, double seconds ) {
+	const char *band_names[] = { "any", "easy", "medium", "hard" };
+	printf( "%s: easy <= %i, hard >= %i\n", name, g->easy_max, g->hard_min );
+	for ( int band = SCRAMBLE_ANY; band <= SCRAMBLE_HARD; band++ ) {
+		g->drawn = 0;
+		g->kept = 0;
+		int tiles[SOLVER_MAX_CELLS];
+		long long distance_sum = 0;
+		int distance_count = 0;
+		bool ok = true;
+		double start = now_seconds();
+		double elapsed = 0.0;
+		while ( elapsed < seconds ) {
+			int distance;
+			scramble_next( g, (scramble_band)band, tiles, &distance );
+			ok = ok && scramble_is_solvable( tiles, g->rows, g->cols );
+			if ( distance >= 0 ) {
+				distance_sum += distance;
+				distance_count++;
+			}
+			elapsed = now_seconds() - start;
+		}
+		printf( "  %-7s %12.0f scrambles/s %6.1f%% kept   mean distance ", band_names[band],
+						g->kept / elapsed, 100.0 * g->kept / g->drawn );
+		if ( distance_count > 0 ) {
+			printf( "%5.1f\n", (double)distance_sum / distance_count );
+		} else {
+			printf( "    -\n" );
+		}
+		if ( !ok ) {
+			fprintf( stderr, "ERROR: %s generated an unsolvable board\n", name );
+		}
+	}
+}
+
+int main( int argc, char **argv ) {
+	double seconds = argc > 1 ? atof( argv[1] ) : 2.0;
+	const char *pdb_file_name = argc > 2 ? argv[2] : NULL;
+
+	solver s3;
+	solver s4;
+	if ( !solver_init( &s3, 3, 3 ) || !solver_init( &s4, 4, 4 ) ) {
+		return 1;
+	}
+	scramble_generator g;
+	distance_table dist;
+	if ( distance_table_open( &dist, "puzzle3x3.dist", 3, 3 ) ) {
+		scramble_init( &g, 3, 3, 1, SCRAMBLE_EXACT, &s3, &dist );
+		bench_generator( "3x3 exact, distance table", &g, seconds );
+		distance_table_close( &dist );
+	}
+	scramble_init( &g, 3, 3, 1, SCRAMBLE_EXACT, &s3, NULL );
+	bench_generator( "3x3 exact, search", &g, seconds );
+
+	pdb_set pdb;
+	if ( pdb_file_name && pdb_open( &pdb, pdb_file_name, 4, 4 ) ) {
+		solver_set_pdb( &s4, &pdb );
+	}
+	scramble_init( &g, 4, 4, 1, SCRAMBLE_HEURISTIC, &s4, NULL );
+	bench_generator( "4x4 heuristic", &g, seconds );
+	scramble_init( &g, 4, 4, 1, SCRAMBLE_EXACT, &s4, NULL );
+	bench_generator( s4.pdb ? "4x4 exact, search with pattern databases" : "4x4 exact, search", &g,
+									 seconds );
+	if ( s4.pdb ) {
+		pdb_close( &pdb );
+	}
+	return 0;
+}
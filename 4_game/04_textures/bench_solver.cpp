@@ -0,0 +1,135 @@
+/******************************************************************************\
+| Benchmark for the IDA* solver.                                               |
+| Solves a batch of random 3x3 boards, then every 4x4 instance in a Korf-style |
+| instance file -- one board per line, 16 numbers with 0 as the blank and the  |
+| goal 0 1 2 ... 15, optionally preceded by an instance number. The standard   |
+| set is the 100 instances from Korf's 1985 IDA* paper:                        |
+|   ./bench_solver korf100.txt [4x4 pattern database from pdb_build]           |
+| Prints moves, nodes and time for every instance plus totals and nodes/sec.  |
+\******************************************************************************/
+#include "board.h"
+#include "solver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_3X3_BOARDS 1000
+#define MAX_LINE 512
+
+/* Korf's goal has the blank in the top left and tile k in slot k. turning his
+boards 180 degrees maps that goal onto ours (tile k in slot k, blank last) and
+keeps every move legal, so solution lengths are the same */
+static void korf_to_board( const int *korf, int n, int *tiles ) {
+	for ( int pos = 0; pos < n; pos++ ) {
+		tiles[n - 1 - pos] = n - 1 - korf[pos];
+	}
+}
+
+/* scramble with a random walk that never undoes the previous move */
+static void random_walk( board *b, int moves ) {
+	int prev = -1;
+	static const int reverse[4] = { BOARD_DOWN, BOARD_UP, BOARD_RIGHT, BOARD_LEFT };
+	for ( int i = 0; i < moves; ) {
+		int dir = rand() % 4;
+		if ( prev >= 0 && dir == reverse[prev] ) {
+			continue;
+		}
+		if ( board_move( b, (board_dir)dir ) ) {
+			prev = dir;
+			i++;
+		}
+	}
+}
+
+static void bench_3x3() {
+	solver s;
+	solver_init( &s, 3, 3 );
+	unsigned long long nodes = 0;
+	double seconds = 0.0;
+	int total_moves = 0;
+	srand( 1 );
+	for ( int i = 0; i < RANDOM_3X3_BOARDS; i++ ) {
+		board b;
+		board_init( &b, 3, 3, NULL );
+		random_walk( &b, 200 );
+		solver_result r;
+		if ( !solver_solve( &s, &b, &r ) ) {
+			fprintf( stderr, "ERROR: 3x3 board %i not solved\n", i );
+		}
+		nodes += r.nodes;
+		seconds += r.seconds;
+		total_moves += r.length;
+		board_free( &b );
+	}
+	printf( "3x3: %i random boards, mean %.1f moves, mean %.1f us/board, %.2f Mnodes/s\n",
+					RANDOM_3X3_BOARDS, (double)total_moves / RANDOM_3X3_BOARDS,
+					seconds * 1e6 / RANDOM_3X3_BOARDS, seconds > 0.0 ? nodes / seconds / 1e6 : 0.0 );
+}
+
+static void bench_4x4( const char *file_name, const char *pdb_file_name ) {
+	FILE *file = fopen( file_name, "r" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open instance file %s\n", file_name );
+		return;
+	}
+	solver s;
+	solver_init( &s, 4, 4 );
+	pdb_set pdb;
+	bool have_pdb = pdb_file_name && pdb_open( &pdb, pdb_file_name, 4, 4 );
+	if ( have_pdb ) {
+		solver_set_pdb( &s, &pdb );
+		printf( "4x4 heuristic: max( linear conflicts, %i pattern databases )\n", pdb.pattern_count );
+	}
+	unsigned long long nodes = 0;
+	double seconds = 0.0;
+	int count = 0;
+	char line[MAX_LINE];
+	printf( "%5s %6s %16s %10s\n", "#", "moves", "nodes", "seconds" );
+	while ( fgets( line, MAX_LINE, file ) ) {
+		int values[17];
+		int n_values = 0;
+		for ( char *tok = strtok( line, " \t\r\n" ); tok && n_values < 17;
+					tok = strtok( NULL, " \t\r\n" ) ) {
+			values[n_values++] = atoi( tok );
+		}
+		if ( n_values < 16 ) {
+			continue; // blank or comment line
+		}
+		int *korf = values + ( n_values - 16 ); // skip the instance number
+		int tiles[16];
+		korf_to_board( korf, 16, tiles );
+		board b;
+		if ( !board_init( &b, 4, 4, tiles ) ) {
+			fprintf( stderr, "ERROR: bad instance on line %i\n", count + 1 );
+			continue;
+		}
+		solver_result r;
+		count++;
+		if ( !solver_solve( &s, &b, &r ) ) {
+			fprintf( stderr, "ERROR: instance %i not solved\n", count );
+		}
+		printf( "%5i %6i %16llu %10.3f\n", count, r.length, r.nodes, r.seconds );
+		fflush( stdout );
+		nodes += r.nodes;
+		seconds += r.seconds;
+		board_free( &b );
+	}
+	fclose( file );
+	if ( have_pdb ) {
+		pdb_close( &pdb );
+	}
+	if ( count > 0 ) {
+		printf( "4x4: %i instances, %llu nodes, %.2f s wall, %.2f Mnodes/s\n", count, nodes,
+						seconds, seconds > 0.0 ? nodes / seconds / 1e6 : 0.0 );
+	}
+}
+
+int main( int argc, char **argv ) {
+	bench_3x3();
+	if ( argc > 1 ) {
+		bench_4x4( argv[1], argc > 2 ? argv[2] : NULL );
+	} else {
+		printf( "usage: %s korf100.txt [pdb file] to also run the 4x4 instances\n", argv[0] );
+	}
+	return 0;
+}
@@ -0,0 +1,252 @@
+#include "bitboard.h"
+#include "board.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef BITBOARD_SIMD
+#include <tmmintrin.h>
+#endif
+
+/* 2 * ( tiles in the line - longest run of them already in goal order ) */
+static int line_cost( int index, int length ) {
+	int goals[BITBOARD_MAX_SIDE];
+	int count = 0;
+	for ( int k = 0; k < length; k++ ) {
+		int code = ( index >> ( 3 * k ) ) & 7;
+		if ( code > 0 ) {
+			goals[count++] = code - 1;
+		}
+	}
+	int lis[BITBOARD_MAX_SIDE];
+	int longest = 0;
+	for ( int i = 0; i < count; i++ ) {
+		lis[i] = 1;
+		for ( int j = 0; j < i; j++ ) {
+			if ( goals[j] < goals[i] && lis[j] + 1 > lis[i] ) {
+				lis[i] = lis[j] + 1;
+			}
+		}
+		if ( lis[i] > longest ) {
+			longest = lis[i];
+		}
+	}
+	return 2 * ( count - longest );
+}
+
+bool bitboard_tables_init( bitboard_tables *t, int rows, int cols ) {
+	memset( t, 0, sizeof( bitboard_tables ) );
+	if ( rows < 2 || cols < 2 || rows > BITBOARD_MAX_SIDE || cols > BITBOARD_MAX_SIDE ) {
+		return false;
+	}
+	t->rows = rows;
+	t->cols = cols;
+	t->n = rows * cols;
+	board b;
+	if ( !board_init( &b, rows, cols, NULL ) ) {
+		return false;
+	}
+	for ( int slot = 0; slot < t->n; slot++ ) {
+		b.blank = slot;
+		for ( int dir = 0; dir < 4; dir++ ) {
+			int from = board_move_source( &b, (board_dir)dir );
+			t->from[slot][dir] = (signed char)( from < 0 ? slot : from );
+		}
+		t->slot_row[slot] = (unsigned char)( slot / cols );
+		t->slot_col[slot] = (unsigned char)( slot % cols );
+		t->slot_used[slot] = 0xFF;
+		if ( slot < t->n - 1 ) {
+			t->goal_row[slot] = (unsigned char)( slot / cols );
+			t->goal_col[slot] = (unsigned char)( slot % cols );
+		}
+	}
+	board_free( &b );
+
+	memset( t->gather_a, 0x80, sizeof( t->gather_a ) );
+	memset( t->gather_b, 0x80, sizeof( t->gather_b ) );
+	for ( int kind = 0; kind < 2; kind++ ) {
+		int lines = 0 == kind ? rows : cols;
+		int length = 0 == kind ? cols : rows;
+		for ( int line = 0; line < lines; line++ ) {
+			for ( int k = 0; k < length; k++ ) {
+				int slot = 0 == kind ? line * cols + k : k * cols + line;
+				int byte = ( line & 1 ) * 8 + k;
+				if ( slot < 16 ) {
+					t->gather_a[kind][line / 2][byte] = (unsigned char)slot;
+				} else {
+					t->gather_b[kind][line / 2][byte] = (unsigned char)( slot - 16 );
+				}
+			}
+		}
+	}
+	for ( int index = 0; index < BITBOARD_LC_ENTRIES; index++ ) {
+		t->lc[index] = (unsigned char)line_cost( index, BITBOARD_MAX_SIDE );
+	}
+	return true;
+}
+
+/*--------------------------------- fallback ---------------------------------*/
+static int tiles_evaluate( const bitboard_tables *t, const int *tiles, bool conflicts ) {
+	int md = 0;
+	int row_index[BITBOARD_MAX_SIDE] = { 0 };
+	int col_index[BITBOARD_MAX_SIDE] = { 0 };
+	for ( int slot = 0; slot < t->n; slot++ ) {
+		int tile = tiles[slot];
+		if ( tile == t->n - 1 ) {
+			continue;
+		}
+		int row = t->slot_row[slot], col = t->slot_col[slot];
+		int goal_row = t->goal_row[tile], goal_col = t->goal_col[tile];
+		md += abs( goal_row - row ) + abs( goal_col - col );
+		if ( goal_row == row ) {
+			row_index[row] |= ( goal_col + 1 ) << ( 3 * col );
+		}
+		if ( goal_col == col ) {
+			col_index[col] |= ( goal_row + 1 ) << ( 3 * row );
+		}
+	}
+	if ( !conflicts ) {
+		return md;
+	}
+	int lc = 0;
+	for ( int row = 0; row < t->rows; row++ ) {
+		lc += t->lc[row_index[row]];
+	}
+	for ( int col = 0; col < t->cols; col++ ) {
+		lc += t->lc[col_index[col]];
+	}
+	return md + lc;
+}
+
+int bitboard_tiles_manhattan( const bitboard_tables *t, const int *tiles ) {
+	return tiles_evaluate( t, tiles, false );
+}
+
+int bitboard_tiles_heuristic( const bitboard_tables *t, const int *tiles ) {
+	return tiles_evaluate( t, tiles, true );
+}
+
+/*----------------------------------- SIMD -----------------------------------*/
+#ifdef BITBOARD_SIMD
+static inline __m128i load16( const unsigned char *p ) { return _mm_loadu_si128( (const __m128i *)p ); }
+
+/* 16 nibbles to 16 bytes, low nibble first */
+static inline __m128i unpack_nibbles( unsigned long long w ) {
+	__m128i v = _mm_loadl_epi64( (const __m128i *)&w );
+	__m128i low = _mm_set1_epi8( 0x0F );
+	return _mm_unpacklo_epi8( _mm_and_si128( v, low ), _mm_and_si128( _mm_srli_epi16( v, 4 ), low ) );
+}
+
+/* 16 bits to 16 bytes of 16 or 0 */
+static inline __m128i unpack_bit4( unsigned int bits ) {
+	const __m128i spread = _mm_setr_epi8( 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1 );
+	const __m128i select = _mm_setr_epi8( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+																				-128 );
+	__m128i v = _mm_and_si128( _mm_shuffle_epi8( _mm_cvtsi32_si128( (int)bits ), spread ), select );
+	return _mm_and_si128( _mm_cmpeq_epi8( v, select ), _mm_set1_epi8( 16 ) );
+}
+
+/* table[tile] for tile ids up to 31: pshufb only looks at the low 4 bits */
+static inline __m128i lookup32( const unsigned char *table, __m128i tiles ) {
+	const __m128i bit4 = _mm_set1_epi8( 16 );
+	__m128i high = _mm_cmpeq_epi8( _mm_and_si128( tiles, bit4 ), bit4 );
+	return _mm_or_si128( _mm_andnot_si128( high, _mm_shuffle_epi8( load16( table ), tiles ) ),
+											 _mm_and_si128( high, _mm_shuffle_epi8( load16( table + 16 ), tiles ) ) );
+}
+
+/* Manhattan distance and line codes of 16 slots starting at 'first' */
+static inline int slots_evaluate( const bitboard_tables *t, __m128i tiles, int first,
+																	__m128i *row_codes, __m128i *col_codes ) {
+	__m128i used = _mm_andnot_si128( _mm_cmpeq_epi8( tiles, _mm_set1_epi8( (char)( t->n - 1 ) ) ),
+																	 load16( t->slot_used + first ) );
+	__m128i goal_row = lookup32( t->goal_row, tiles );
+	__m128i goal_col = lookup32( t->goal_col, tiles );
+	__m128i slot_row = load16( t->slot_row + first );
+	__m128i slot_col = load16( t->slot_col + first );
+	__m128i distance = _mm_add_epi8( _mm_abs_epi8( _mm_sub_epi8( goal_row, slot_row ) ),
+																	 _mm_abs_epi8( _mm_sub_epi8( goal_col, slot_col ) ) );
+	__m128i sums = _mm_sad_epu8( _mm_and_si128( distance, used ), _mm_setzero_si128() );
+	const __m128i one = _mm_set1_epi8( 1 );
+	*row_codes = _mm_and_si128( _mm_and_si128( _mm_cmpeq_epi8( goal_row, slot_row ), used ),
+															_mm_add_epi8( goal_col, one ) );
+	*col_codes = _mm_and_si128( _mm_and_si128( _mm_cmpeq_epi8( goal_col, slot_col ), used ),
+															_mm_add_epi8( goal_row, one ) );
+	return _mm_cvtsi128_si32( sums ) + _mm_cvtsi128_si32( _mm_srli_si128( sums, 8 ) );
+}
+
+/* sum of the line costs of the rows (kind 0) or columns (kind 1) */
+static inline int lines_evaluate( const bitboard_tables *t, int kind, __m128i codes_a,
+																	__m128i codes_b ) {
+	// code k of a line times 8^k, summed per 8 byte line
+	const __m128i weight_pairs = _mm_setr_epi8( 1, 8, 1, 8, 1, 8, 1, 8, 1, 8, 1, 8, 1, 8, 1, 8 );
+	const __m128i weight_quads = _mm_setr_epi16( 1, 64, 1, 64, 1, 64, 1, 64 );
+	int lines = 0 == kind ? t->rows : t->cols;
+	int cost = 0;
+	for ( int reg = 0; reg < ( lines + 1 ) / 2; reg++ ) {
+		__m128i line = _mm_or_si128( _mm_shuffle_epi8( codes_a, load16( t->gather_a[kind][reg] ) ),
+																 _mm_shuffle_epi8( codes_b, load16( t->gather_b[kind][reg] ) ) );
+		__m128i quads = _mm_madd_epi16( _mm_maddubs_epi16( line, weight_pairs ), weight_quads );
+		// codes 0..3 are in the low dword of each line, code 4 in the high one
+		__m128i index = _mm_and_si128( _mm_or_si128( quads, _mm_srli_epi64( quads, 20 ) ),
+																	 _mm_set1_epi64x( BITBOARD_LC_ENTRIES - 1 ) );
+		cost += t->lc[_mm_cvtsi128_si32( index )] + t->lc[_mm_cvtsi128_si32( _mm_srli_si128( index, 8 ) )];
+	}
+	return cost;
+}
+#endif
+
+/*------------------------------------ 64 ------------------------------------*/
+static int evaluate64( const bitboard_tables *t, bitboard64 b, bool conflicts ) {
+#ifdef BITBOARD_SIMD
+	__m128i row_codes, col_codes;
+	int md = slots_evaluate( t, unpack_nibbles( b ), 0, &row_codes, &col_codes );
+	if ( !conflicts ) {
+		return md;
+	}
+	__m128i none = _mm_setzero_si128();
+	return md + lines_evaluate( t, 0, row_codes, none ) + lines_evaluate( t, 1, col_codes, none );
+#else
+	int tiles[16];
+	for ( int slot = 0; slot < t->n; slot++ ) {
+		tiles[slot] = bitboard64_tile( b, slot );
+	}
+	return tiles_evaluate( t, tiles, conflicts );
+#endif
+}
+
+int bitboard64_manhattan( const bitboard_tables *t, bitboard64 b ) {
+	return evaluate64( t, b, false );
+}
+
+int bitboard64_heuristic( const bitboard_tables *t, bitboard64 b ) {
+	return evaluate64( t, b, true );
+}
+
+/*----------------------------------- 128 ------------------------------------*/
+static int evaluate128( const bitboard_tables *t, const bitboard128 *b, bool conflicts ) {
+#ifdef BITBOARD_SIMD
+	unsigned int bit4 = (unsigned int)( b->hi >> 36 );
+	__m128i tiles_a = _mm_or_si128( unpack_nibbles( b->lo ), unpack_bit4( bit4 & 0xFFFF ) );
+	__m128i tiles_b =
+		_mm_or_si128( unpack_nibbles( b->hi & 0xFFFFFFFFFULL ), unpack_bit4( bit4 >> 16 ) );
+	__m128i rows_a, cols_a, rows_b, cols_b;
+	int md = slots_evaluate( t, tiles_a, 0, &rows_a, &cols_a ) +
+					 slots_evaluate( t, tiles_b, 16, &rows_b, &cols_b );
+	if ( !conflicts ) {
+		return md;
+	}
+	return md + lines_evaluate( t, 0, rows_a, rows_b ) + lines_evaluate( t, 1, cols_a, cols_b );
+#else
+	int tiles[BITBOARD_MAX_CELLS];
+	for ( int slot = 0; slot < t->n; slot++ ) {
+		tiles[slot] = bitboard128_tile( b, slot );
+	}
+	return tiles_evaluate( t, tiles, conflicts );
+#endif
+}
+
+int bitboard128_manhattan( const bitboard_tables *t, const bitboard128 *b ) {
+	return evaluate128( t, b, false );
+}
+
+int bitboard128_heuristic( const bitboard_tables *t, const bitboard128 *b ) {
+	return evaluate128( t, b, true );
+}
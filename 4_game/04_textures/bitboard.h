@@ -0,0 +1,123 @@
+/******************************************************************************\
+| Packed board encodings with branch-free moves and SIMD heuristics.           |
+|  bitboard64   up to 4x4: tile in slot s in bits 4s..4s+3                    |
+|  bitboard128  up to 5x5: the low 4 bits of every slot's tile as nibbles     |
+|               (slots 0..15 in lo, 16..24 in hi bits 0..35) and bit 4 of     |
+|               every slot's tile in hi bits 36..60                           |
+|  int tiles[]  the general fallback, same layout as board::tiles            |
+| A move xors tile ^ blank id into the two slots involved; with 'from' equal  |
+| to the blank (an illegal move in bitboard_tables::from) that is a no-op.   |
+| Manhattan distance plus linear conflicts is evaluated with SSSE3: the tiles  |
+| are unpacked to one byte per slot, their goal rows and columns come from     |
+| pshufb lookups, and every row and column is boiled down (pshufb gather,     |
+| pmaddubsw, pmaddwd) to an index into a table of that line's conflict cost.   |
+| Without SSSE3 the same tables are walked in scalar code.                    |
+\******************************************************************************/
+#ifndef _BITBOARD_H_
+#define _BITBOARD_H_
+
+#if defined( __SSSE3__ ) || defined( __AVX__ )
+#define BITBOARD_SIMD 1
+#endif
+
+#define BITBOARD_MAX_SIDE 5
+#define BITBOARD_MAX_CELLS 25
+#define BITBOARD_LINE_REGS 3 // lines two to a register, 5 of them at most
+// a line is up to 5 codes of 3 bits, see bitboard_tables::lc
+#define BITBOARD_LC_ENTRIES 32768
+
+typedef unsigned long long bitboard64;
+
+struct bitboard128 {
+	unsigned long long lo;
+	unsigned long long hi;
+};
+
+/* everything that depends on the board size */
+struct bitboard_tables {
+	int rows;
+	int cols;
+	int n;
+	// slot that slides into a blank at [blank][board_dir], the blank if none
+	signed char from[BITBOARD_MAX_CELLS][4];
+	// shuffle tables, by tile id (low 16, high 16) and by slot
+	unsigned char goal_row[32];
+	unsigned char goal_col[32];
+	unsigned char slot_row[32];
+	unsigned char slot_col[32];
+	unsigned char slot_used[32]; // 0xFF for slots on the board
+	// pshufb controls that lay the per-slot codes out as lines, 8 bytes per
+	// line: rows first, then columns. 'a' picks from slots 0..15, 'b' 16..31
+	unsigned char gather_a[2][BITBOARD_LINE_REGS][16];
+	unsigned char gather_b[2][BITBOARD_LINE_REGS][16];
+	// extra moves of one line, 2 * ( tiles in it - longest run in goal order ).
+	// index: code of position k in bits 3k..3k+2, where the code is 0 for a
+	// tile that does not belong to the line and 1 + its goal position if it does
+	unsigned char lc[BITBOARD_LC_ENTRIES];
+};
+
+bool bitboard_tables_init( bitboard_tables *t, int rows, int cols );
+
+/*------------------------------------ 64 ------------------------------------*/
+inline int bitboard64_tile( bitboard64 b, int slot ) { return (int)( ( b >> ( 4 * slot ) ) & 0xF ); }
+
+inline bitboard64 bitboard64_from_tiles( const int *tiles, int n ) {
+	bitboard64 b = 0;
+	for ( int slot = 0; slot < n; slot++ ) {
+		b |= (bitboard64)tiles[slot] << ( 4 * slot );
+	}
+	return b;
+}
+
+/* the tile in 'from' moves into 'blank', n - 1 is the blank's id */
+inline bitboard64 bitboard64_move( bitboard64 b, int n, int blank, int from ) {
+	bitboard64 x = ( ( b >> ( 4 * from ) ) & 0xF ) ^ (bitboard64)( n - 1 );
+	return b ^ ( x << ( 4 * from ) ) ^ ( x << ( 4 * blank ) );
+}
+
+int bitboard64_manhattan( const bitboard_tables *t, bitboard64 b );
+
+/* Manhattan distance + linear conflicts */
+int bitboard64_heuristic( const bitboard_tables *t, bitboard64 b );
+
+/*----------------------------------- 128 ------------------------------------*/
+inline int bitboard128_tile( const bitboard128 *b, int slot ) {
+	// the nibble word without a branch: lo for slots below 16, hi from there
+	unsigned long long high_half = (unsigned long long)( slot >> 4 );
+	unsigned long long nibbles = ( b->lo & ( high_half - 1 ) ) | ( b->hi & ( 0 - high_half ) );
+	return (int)( ( ( nibbles >> ( 4 * ( slot & 15 ) ) ) & 0xF ) |
+								( ( ( b->hi >> ( 36 + slot ) ) & 1 ) << 4 ) );
+}
+
+/* xor 'x' into the tile of 'slot' */
+inline void bitboard128_flip( bitboard128 *b, int slot, unsigned long long x ) {
+	unsigned long long high_half = (unsigned long long)( slot >> 4 );
+	unsigned long long nibble = ( x & 0xF ) << ( 4 * ( slot & 15 ) );
+	b->lo ^= nibble & ( high_half - 1 );
+	b->hi ^= ( nibble & ( 0 - high_half ) ) | ( ( x >> 4 ) << ( 36 + slot ) );
+}
+
+inline bitboard128 bitboard128_from_tiles( const int *tiles, int n ) {
+	bitboard128 b = { 0, 0 };
+	for ( int slot = 0; slot < n; slot++ ) {
+		bitboard128_flip( &b, slot, (unsigned long long)tiles[slot] );
+	}
+	return b;
+}
+
+inline void bitboard128_move( bitboard128 *b, int n, int blank, int from ) {
+	unsigned long long x = (unsigned long long)( bitboard128_tile( b, from ) ^ ( n - 1 ) );
+	bitboard128_flip( b, from, x );
+	bitboard128_flip( b, blank, x );
+}
+
+int bitboard128_manhattan( const bitboard_tables *t, const bitboard128 *b );
+
+int bitboard128_heuristic( const bitboard_tables *t, const bitboard128 *b );
+
+/*--------------------------------- fallback ---------------------------------*/
+int bitboard_tiles_manhattan( const bitboard_tables *t, const int *tiles );
+
+int bitboard_tiles_heuristic( const bitboard_tables *t, const int *tiles );
+
+#endif
@@ -0,0 +1,143 @@
+#include "board.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool board_is_permutation( const int *tiles, int n ) {
+	unsigned char *seen = (unsigned char *)calloc( n, 1 );
+	if ( !seen ) {
+		return false;
+	}
+	bool ok = true;
+	for ( int i = 0; i < n && ok; i++ ) {
+		ok = tiles[i] >= 0 && tiles[i] < n && !seen[tiles[i]];
+		if ( ok ) {
+			seen[tiles[i]] = 1;
+		}
+	}
+	free( seen );
+	return ok;
+}
+
+bool board_init( board *b, int rows, int cols, const int *tiles ) {
+	memset( b, 0, sizeof( board ) );
+	if ( rows < 2 || cols < 2 ) {
+		return false;
+	}
+	// anything else puts a tile id past the end of the renderer's arrays
+	if ( tiles && !board_is_permutation( tiles, rows * cols ) ) {
+		return false;
+	}
+	b->rows = rows;
+	b->cols = cols;
+	b->n = rows * cols;
+	b->tiles = (int *)malloc( b->n * sizeof( int ) );
+	if ( !b->tiles ) {
+		return false;
+	}
+	b->blank = -1;
+	b->correct = 0;
+	for ( int i = 0; i < b->n; i++ ) {
+		b->tiles[i] = tiles ? tiles[i] : i;
+		if ( b->tiles[i] == b->n - 1 ) {
+			b->blank = i;
+		}
+		if ( b->tiles[i] == i ) {
+			b->correct++;
+		}
+	}
+	if ( b->blank < 0 ) {
+		board_free( b );
+		return false;
+	}
+	// the renderer does a full upload when it is created, so start clean
+	b->dirty_count = 0;
+	b->dirty_all = false;
+	return true;
+}
+
+void board_free( board *b ) {
+	free( b->tiles );
+	b->tiles = NULL;
+	b->n = 0;
+}
+
+int board_move_source( const board *b, board_dir dir ) {
+	int row = b->blank / b->cols;
+	int col = b->blank % b->cols;
+	int from = -1;
+	// the tile that slides UP into the blank is the one below it, etc.
+	switch ( dir ) {
+	case BOARD_UP:
+		if ( row < b->rows - 1 ) {
+			from = b->blank + b->cols;
+		}
+		break;
+	case BOARD_DOWN:
+		if ( row > 0 ) {
+			from = b->blank - b->cols;
+		}
+		break;
+	case BOARD_LEFT:
+		if ( col < b->cols - 1 ) {
+			from = b->blank + 1;
+		}
+		break;
+	case BOARD_RIGHT:
+		if ( col > 0 ) {
+			from = b->blank - 1;
+		}
+		break;
+	}
+	return from;
+}
+
+bool board_move( board *b, board_dir dir ) {
+	int from = board_move_source( b, dir );
+	if ( from < 0 ) {
+		return false;
+	}
+	// only the two slots that swap contents can change the count
+	b->correct -= ( b->tiles[from] == from ) + ( b->blank == b->n - 1 );
+	b->tiles[b->blank] = b->tiles[from];
+	b->tiles[from] = b->n - 1;
+	b->correct += ( b->tiles[b->blank] == b->blank ) + ( from == b->n - 1 );
+	// slots may already be dirty if several moves happen between uploads
+	int touched[2] = { b->blank, from };
+	for ( int i = 0; i < 2 && !b->dirty_all; i++ ) {
+		bool seen = false;
+		for ( int j = 0; j < b->dirty_count; j++ ) {
+			if ( b->dirty[j] == touched[i] ) {
+				seen = true;
+			}
+		}
+		if ( seen ) {
+			continue;
+		}
+		if ( b->dirty_count < BOARD_MAX_DIRTY ) {
+			b->dirty[b->dirty_count++] = touched[i];
+		} else {
+			b->dirty_all = true; // too many to track, renderer re-uploads the lot
+		}
+	}
+	b->blank = from;
+	return true;
+}
+
+void board_set( board *b, const int *tiles ) {
+	b->correct = 0;
+	for ( int i = 0; i < b->n; i++ ) {
+		b->tiles[i] = tiles[i];
+		if ( b->tiles[i] == b->n - 1 ) {
+			b->blank = i;
+		}
+		if ( b->tiles[i] == i ) {
+			b->correct++;
+		}
+	}
+	b->dirty_all = true;
+}
+
+void board_clear_dirty( board *b ) {
+	b->dirty_count = 0;
+	b->dirty_all = false;
+}
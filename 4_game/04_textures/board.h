@@ -0,0 +1,60 @@
+/******************************************************************************\
+| Sliding puzzle board model.                                                  |
+| The board is just a permutation of tile ids laid out row by row plus the     |
+| slot that currently holds the blank. Tile id 'n - 1' is the blank and tile   |
+| 'i' belongs in slot 'i', so the solved board is the identity permutation.    |
+| Nothing in here knows about GL -- the renderer reads the dirty slot list     |
+| after a move and uploads only those quads.                                   |
+\******************************************************************************/
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+// a move touches two slots (the tile and the blank). keep room for a few moves
+// between uploads before falling back to re-uploading everything
+#define BOARD_MAX_DIRTY 16
+
+// direction the *tile* slides into the blank, same as the arrow key pressed
+enum board_dir { BOARD_UP = 0, BOARD_DOWN, BOARD_LEFT, BOARD_RIGHT };
+
+struct board {
+	int rows;
+	int cols;
+	int n;			 // rows * cols
+	int *tiles;	 // tiles[slot] = tile id. tile id n - 1 is the blank
+	int blank;	 // slot currently holding the blank
+	int correct; // slots holding their own tile, the blank included
+	int dirty[BOARD_MAX_DIRTY];
+	int dirty_count;
+	bool dirty_all; // dirty[] overflowed
+};
+
+/* allocate a rows x cols board. if 'tiles' is NULL the board starts solved,
+otherwise it is copied in and must be a permutation of 0..n-1: false if it
+is not, so tiles read from a file can be handed straight in */
+bool board_init( board *b, int rows, int cols, const int *tiles );
+
+/* every id 0..n-1 exactly once */
+bool board_is_permutation( const int *tiles, int n );
+
+void board_free( board *b );
+
+/* slot of the tile that would slide into the blank in direction 'dir', or -1
+if there is no tile on that side */
+int board_move_source( const board *b, board_dir dir );
+
+/* slide the tile next to the blank in direction 'dir'. returns false and
+leaves the board untouched if there is no tile on that side */
+bool board_move( board *b, board_dir dir );
+
+/* replaces every tile at once, for a jump through the undo history. 'tiles'
+must be a permutation of 0..n-1. marks the whole board dirty */
+void board_set( board *b, const int *tiles );
+
+/* forget the slots touched since the last call. the renderer calls this once
+it has uploaded them */
+void board_clear_dirty( board *b );
+
+/* O(1): every move keeps the count of tiles in their home slot up to date */
+inline bool board_is_solved( const board *b ) { return b->correct == b->n; }
+
+#endif
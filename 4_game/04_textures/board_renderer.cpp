@@ -0,0 +1,191 @@
+#include "board_renderer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+bool board_renderer_init( board_renderer *r, const board *b, GLuint programme ) {
+	// corners of the unit quad, top left going clock-wise. y grows downwards
+	// here, same as slot rows, and the vertex shader flips it into clip space
+	float quad[] = {
+		0.0f, 0.0f, // top left
+		1.0f, 0.0f, // top right
+		1.0f, 1.0f, // bottom right
+		0.0f, 1.0f	// bottom left
+	};
+	unsigned int indices[] = {
+		0, 1, 2, // first triangle
+		0, 2, 3	 // second triangle
+	};
+
+	r->programme = programme;
+	r->instance_count = b->n;
+	r->reveal_blank = false;
+	r->highlight_tile = -1;
+	r->slide_seconds = (float)BOARD_RENDERER_SLIDE_SECONDS;
+	r->last_slide_end = 0.0;
+	r->instances = (tile_instance *)malloc( b->n * sizeof( tile_instance ) );
+	if ( !r->instances ) {
+		fprintf( stderr, "ERROR: could not allocate %i tile instances\n", b->n );
+		return false;
+	}
+	// every tile at rest in its slot: a slide that ended long ago
+	for ( int slot = 0; slot < b->n; slot++ ) {
+		tile_instance *t = &r->instances[b->tiles[slot]];
+		t->from_slot = slot;
+		t->to_slot = slot;
+		t->start_time = -r->slide_seconds;
+	}
+
+	glGenVertexArrays( 1, &r->vao );
+	glGenBuffers( 1, &r->quad_vbo );
+	glGenBuffers( 1, &r->quad_ebo );
+	glGenBuffers( 1, &r->tile_vbo );
+	glBindVertexArray( r->vao );
+
+	glBindBuffer( GL_ARRAY_BUFFER, r->quad_vbo );
+	glBufferData( GL_ARRAY_BUFFER, sizeof( quad ), quad, GL_STATIC_DRAW );
+	// corner attribute
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof( float ), (void *)0 );
+	glEnableVertexAttribArray( 0 );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, r->quad_ebo );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( indices ), indices, GL_STATIC_DRAW );
+
+	// tile instances, advanced once per instance. allocated once here, moves
+	// only ever go through glBufferSubData()
+	glBindBuffer( GL_ARRAY_BUFFER, r->tile_vbo );
+	glBufferData( GL_ARRAY_BUFFER, b->n * sizeof( tile_instance ), r->instances,
+								GL_DYNAMIC_DRAW );
+	// from and to slot attribute
+	glVertexAttribIPointer( 1, 2, GL_INT, sizeof( tile_instance ), (void *)0 );
+	glVertexAttribDivisor( 1, 1 );
+	glEnableVertexAttribArray( 1 );
+	// start time attribute
+	glVertexAttribPointer( 2, 1, GL_FLOAT, GL_FALSE, sizeof( tile_instance ),
+												 (void *)( 2 * sizeof( GLint ) ) );
+	glVertexAttribDivisor( 2, 1 );
+	glEnableVertexAttribArray( 2 );
+
+	r->board_size_loc = glGetUniformLocation( programme, "board_size" );
+	r->reveal_blank_loc = glGetUniformLocation( programme, "reveal_blank" );
+	r->time_loc = glGetUniformLocation( programme, "time" );
+	r->slide_seconds_loc = glGetUniformLocation( programme, "slide_seconds" );
+	r->highlight_tile_loc = glGetUniformLocation( programme, "highlight_tile" );
+	r->atlas_origin_loc = glGetUniformLocation( programme, "atlas_origin" );
+	r->atlas_step_loc = glGetUniformLocation( programme, "atlas_step" );
+	r->atlas_tile_loc = glGetUniformLocation( programme, "atlas_tile" );
+	if ( r->board_size_loc < 0 || r->time_loc < 0 ) {
+		fprintf( stderr, "ERROR: board uniforms not found in shader programme %u\n", programme );
+		return false;
+	}
+	glUseProgram( programme );
+	glUniform2i( r->board_size_loc, b->cols, b->rows );
+	glUniform1i( r->reveal_blank_loc, 0 );
+	glUniform1f( r->slide_seconds_loc, r->slide_seconds );
+	glUniform1i( r->highlight_tile_loc, -1 );
+	// until there is an atlas, tiles are cut edge to edge from the texture
+	glUniform2f( r->atlas_origin_loc, 0.0f, 0.0f );
+	glUniform2f( r->atlas_step_loc, 1.0f / b->cols, 1.0f / b->rows );
+	glUniform2f( r->atlas_tile_loc, 1.0f / b->cols, 1.0f / b->rows );
+	return true;
+}
+
+void board_renderer_free( board_renderer *r ) {
+	glDeleteBuffers( 1, &r->tile_vbo );
+	glDeleteBuffers( 1, &r->quad_ebo );
+	glDeleteBuffers( 1, &r->quad_vbo );
+	glDeleteVertexArrays( 1, &r->vao );
+	free( r->instances );
+	r->instances = NULL;
+}
+
+/* queue a slide of 'tile' to 'slot' and upload its instance */
+static void slide_tile( board_renderer *r, int tile, int slot, double start ) {
+	tile_instance *t = &r->instances[tile];
+	t->from_slot = t->to_slot;
+	t->to_slot = slot;
+	t->start_time = (float)start;
+	if ( start + r->slide_seconds > r->last_slide_end ) {
+		r->last_slide_end = start + r->slide_seconds;
+	}
+	glBufferSubData( GL_ARRAY_BUFFER, tile * sizeof( tile_instance ), sizeof( tile_instance ), t );
+}
+
+void board_renderer_update( board_renderer *r, board *b, double now ) {
+	if ( !b->dirty_all && 0 == b->dirty_count ) {
+		return;
+	}
+	glBindBuffer( GL_ARRAY_BUFFER, r->tile_vbo );
+	if ( b->dirty_all ) {
+		// lost track of the order, so put every tile straight where it is
+		for ( int slot = 0; slot < b->n; slot++ ) {
+			tile_instance *t = &r->instances[b->tiles[slot]];
+			t->from_slot = slot;
+			t->to_slot = slot;
+			t->start_time = (float)( now - r->slide_seconds );
+		}
+		glBufferSubData( GL_ARRAY_BUFFER, 0, b->n * sizeof( tile_instance ), r->instances );
+		board_clear_dirty( b );
+		return;
+	}
+	int moved_tile = -1;
+	int moved_count = 0;
+	for ( int i = 0; i < b->dirty_count; i++ ) {
+		int slot = b->dirty[i];
+		int tile = b->tiles[slot];
+		if ( tile == b->n - 1 || r->instances[tile].to_slot == slot ) {
+			continue;
+		}
+		// a tile still sliding goes on from where that slide ends
+		double start = r->instances[tile].start_time + r->slide_seconds;
+		slide_tile( r, tile, slot, start > now ? start : now );
+		moved_tile = tile;
+		moved_count++;
+	}
+	int blank = b->n - 1;
+	if ( r->instances[blank].to_slot != b->blank ) {
+		// the blank is drawn behind the tiles. sliding it the opposite way at
+		// the same time as the one tile that moved keeps the two slots covered
+		double start = now;
+		if ( 1 == moved_count ) {
+			start = r->instances[moved_tile].start_time;
+		}
+		slide_tile( r, blank, b->blank, start );
+	}
+	board_clear_dirty( b );
+}
+
+bool board_renderer_animating( const board_renderer *r, double now ) {
+	return now < r->last_slide_end;
+}
+
+void board_renderer_reveal_blank( board_renderer *r ) {
+	r->reveal_blank = true;
+	glUseProgram( r->programme );
+	glUniform1i( r->reveal_blank_loc, 1 );
+}
+
+void board_renderer_highlight( board_renderer *r, int tile ) {
+	if ( tile == r->highlight_tile ) {
+		return;
+	}
+	r->highlight_tile = tile;
+	glUseProgram( r->programme );
+	glUniform1i( r->highlight_tile_loc, tile );
+}
+
+void board_renderer_use_atlas( board_renderer *r, const tile_atlas *a ) {
+	// the cells are a regular grid, so tile 0's rectangle and the cell size
+	// give every other tile's
+	const float *uv = a->uvs;
+	glUseProgram( r->programme );
+	glUniform2f( r->atlas_origin_loc, uv[0], uv[1] );
+	glUniform2f( r->atlas_step_loc, (float)a->cell_px / a->width, (float)a->cell_px / a->height );
+	glUniform2f( r->atlas_tile_loc, uv[2] - uv[0], uv[3] - uv[1] );
+}
+
+void board_renderer_draw( const board_renderer *r, double now ) {
+	glUseProgram( r->programme );
+	glUniform1f( r->time_loc, (float)now );
+	glBindVertexArray( r->vao );
+	glDrawElementsInstanced( GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, r->instance_count );
+}
@@ -0,0 +1,77 @@
+/******************************************************************************\
+| Draws a board of any size with a single instanced draw call.                 |
+| There is one unit quad on the GPU and one instance per *tile*: the slot it  |
+| slides from, the slot it slides to and the time the slide starts. The vertex |
+| shader works out where the tile is from a per-frame time uniform, so a move  |
+| uploads one 12 byte instance for the tile that moved (and one for the blank) |
+| and frames in the middle of a slide touch no buffers at all. Every tile has |
+| its own start time, so any number of them can be sliding at once.           |
+\******************************************************************************/
+#ifndef _BOARD_RENDERER_H_
+#define _BOARD_RENDERER_H_
+
+#include "board.h"
+#include "tile_atlas.h"
+#include <GL/glew.h>
+
+#define BOARD_RENDERER_SLIDE_SECONDS 0.12
+
+// per-instance vertex data, one per tile id
+struct tile_instance {
+	GLint from_slot;
+	GLint to_slot;
+	GLfloat start_time; // seconds on the clock passed to update and draw
+};
+
+struct board_renderer {
+	GLuint vao;
+	GLuint quad_vbo;
+	GLuint quad_ebo;
+	GLuint tile_vbo; // one tile_instance per tile id, divisor 1
+	GLuint programme;
+	GLint board_size_loc;
+	GLint reveal_blank_loc;
+	GLint time_loc;
+	GLint slide_seconds_loc;
+	GLint highlight_tile_loc;
+	GLint atlas_origin_loc;
+	GLint atlas_step_loc;
+	GLint atlas_tile_loc;
+	int instance_count;
+	tile_instance *instances; // copy of tile_vbo. to_slot is where the tile ends up
+	float slide_seconds;
+	double last_slide_end; // no tile moves on screen after this time
+	bool reveal_blank;		 // draw the missing tile instead of the blank
+	int highlight_tile;		 // tile id drawn tinted, -1 for none
+};
+
+/* uploads the unit quad and every tile of 'b' at rest. 'programme' is the
+linked test_vs.glsl/test_fs.glsl pair, used for the board size uniforms */
+bool board_renderer_init( board_renderer *r, const board *b, GLuint programme );
+
+void board_renderer_free( board_renderer *r );
+
+/* starts a slide at time 'now' for every tile in a slot the board marked
+dirty and clears the board's dirty list. does nothing if no slot changed.
+a tile still sliding starts its next slide when the current one ends. call it
+after every move for the tiles to take the same path as on the board */
+void board_renderer_update( board_renderer *r, board *b, double now );
+
+/* is any tile still on its way at time 'now'? */
+bool board_renderer_animating( const board_renderer *r, double now );
+
+/* show the last tile in the blank slot, for when the puzzle is solved */
+void board_renderer_reveal_blank( board_renderer *r );
+
+/* tint tile id 'tile' (the hint), -1 for none. sets a uniform only when it
+changes */
+void board_renderer_highlight( board_renderer *r, int tile );
+
+/* takes the tiles' texture coordinates from 'a', uploaded to the bound
+texture, instead of cutting the whole texture into rows x cols */
+void board_renderer_use_atlas( board_renderer *r, const tile_atlas *a );
+
+/* draws the board as it looks at time 'now'. only sets the time uniform */
+void board_renderer_draw( const board_renderer *r, double now );
+
+#endif
@@ -0,0 +1,156 @@
+/******************************************************************************\
+| Builds the exact distance table for distance_table_open().                   |
+|   ./dist_build <rows> <cols> <output file>                                   |
+|   ./dist_build 3 3 puzzle3x3.dist                                           |
+| Breadth first search from the goal over every solvable state, one byte per  |
+| state while building, then packed to 4 bits. Boards up to 12 cells whose     |
+| distances stay within 31 moves fit: 2x3 and 3x3 (2x4 and up go past that,  |
+| dist_build_ext builds those).                                               |
+\******************************************************************************/
+#include "distance_table.h"
+#include "perm_rank.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNSEEN 0xFF
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/* plain FIFO BFS. the queue holds state indices, each is enqueued once */
+static bool build( int rows, int cols, unsigned char *depth, unsigned long long states,
+									 int *max_distance ) {
+	int n = rows * cols;
+	unsigned int *queue = (unsigned int *)malloc( states * sizeof( unsigned int ) );
+	if ( !queue ) {
+		fprintf( stderr, "ERROR: could not allocate the queue\n" );
+		return false;
+	}
+	memset( depth, UNSEEN, states );
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	for ( int i = 0; i < n; i++ ) {
+		tiles[i] = i;
+	}
+	unsigned long long head = 0, tail = 0;
+	unsigned int goal = (unsigned int)distance_table_index( rows, cols, tiles );
+	depth[goal] = 0;
+	queue[tail++] = goal;
+	unsigned long long level_count[256] = { 0 };
+	*max_distance = 0;
+	while ( head < tail ) {
+		unsigned int state = queue[head++];
+		int d = depth[state];
+		level_count[d]++;
+		*max_distance = d;
+		distance_table_unindex( rows, cols, state, tiles );
+		int blank = 0;
+		while ( tiles[blank] != n - 1 ) {
+			blank++;
+		}
+		int neighbours[4] = { blank - cols, blank + cols, blank % cols > 0 ? blank - 1 : -1,
+													blank % cols < cols - 1 ? blank + 1 : -1 };
+		for ( int i = 0; i < 4; i++ ) {
+			int from = neighbours[i];
+			if ( from < 0 || from >= n ) {
+				continue;
+			}
+			tiles[blank] = tiles[from];
+			tiles[from] = n - 1;
+			unsigned int next = (unsigned int)distance_table_index( rows, cols, tiles );
+			tiles[from] = tiles[blank];
+			tiles[blank] = n - 1;
+			if ( UNSEEN == depth[next] ) {
+				if ( d + 1 > DISTANCE_TABLE_MAX_DISTANCE ) {
+					fprintf( stderr, "ERROR: distances go past %i moves, too many for 4 bits\n",
+									 DISTANCE_TABLE_MAX_DISTANCE );
+					free( queue );
+					return false;
+				}
+				depth[next] = (unsigned char)( d + 1 );
+				queue[tail++] = next;
+			}
+		}
+	}
+	free( queue );
+	if ( tail != states ) {
+		fprintf( stderr, "ERROR: reached %llu of %llu states\n", tail, states );
+		return false;
+	}
+	for ( int d = 0; d <= *max_distance; d++ ) {
+		printf( "  %2i moves: %llu states\n", d, level_count[d] );
+	}
+	return true;
+}
+
+int main( int argc, char **argv ) {
+	if ( argc < 4 ) {
+		fprintf( stderr, "usage: %s <rows> <cols> <output file>\n", argv[0] );
+		return 1;
+	}
+	int rows = atoi( argv[1] );
+	int cols = atoi( argv[2] );
+	const char *file_name = argv[3];
+	if ( rows < 2 || cols < 2 || rows * cols > DISTANCE_TABLE_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: board must be between 2x2 and %i cells\n",
+						 DISTANCE_TABLE_MAX_CELLS );
+		return 1;
+	}
+	unsigned long long states = distance_table_state_count( rows, cols );
+	unsigned char *depth = (unsigned char *)malloc( states );
+	if ( !depth ) {
+		fprintf( stderr, "ERROR: could not allocate %llu bytes\n", states );
+		return 1;
+	}
+	printf( "building %ix%i: %llu states\n", rows, cols, states );
+	double start = now_seconds();
+	distance_table_header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, DISTANCE_TABLE_MAGIC, sizeof( DISTANCE_TABLE_MAGIC ) );
+	header.rows = rows;
+	header.cols = cols;
+	header.states = states;
+	if ( !build( rows, cols, depth, states, &header.max_distance ) ) {
+		return 1;
+	}
+	// pack floor( d / 2 ) in place, two states per byte
+	unsigned long long bytes = ( states + 1 ) / 2;
+	for ( unsigned long long i = 0; i < bytes; i++ ) {
+		int lo = depth[2 * i] >> 1;
+		int hi = 2 * i + 1 < states ? depth[2 * i + 1] >> 1 : 0;
+		depth[i] = (unsigned char)( lo | ( hi << 4 ) );
+	}
+	printf( "built in %.3f s, hardest states %i moves\n", now_seconds() - start,
+					header.max_distance );
+
+	FILE *file = fopen( file_name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		return 1;
+	}
+	fwrite( &header, sizeof( header ), 1, file );
+	fwrite( depth, 1, bytes, file );
+	fclose( file );
+	free( depth );
+	printf( "%s is %.1f KB\n", file_name, ( sizeof( header ) + bytes ) / 1024.0 );
+
+	// read it back: every state one move from its best move, all lookups O(1)
+	distance_table t;
+	if ( !distance_table_open( &t, file_name, rows, cols ) ) {
+		return 1;
+	}
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	long long sum = 0;
+	start = now_seconds();
+	for ( unsigned long long i = 0; i < states; i++ ) {
+		distance_table_unindex( rows, cols, i, tiles );
+		sum += distance_table_lookup( &t, tiles );
+	}
+	printf( "lookup: %.1f ns per state (unindex included), mean distance %.2f\n",
+					( now_seconds() - start ) * 1e9 / states, (double)sum / states );
+	distance_table_close( &t );
+	return 0;
+}
@@ -0,0 +1,519 @@
+/******************************************************************************\
+| Builds exact distance tables too big for dist_build, on disk.               |
+|   ./dist_build_ext <rows> <cols> <output file> [memory MB]                  |
+|   ./dist_build_ext 3 4 puzzle3x4.dist                                      |
+| Breadth first search from the goal with delayed duplicate detection: the   |
+| frontier of every layer is a sorted file of state indices, read in chunks. |
+| Its neighbours that are not in an earlier layer go into a sort buffer of   |
+| 'memory' MB (64 by default), which is radix sorted, deduplicated and       |
+| written out as a run whenever it fills. Merging the runs gives the next    |
+| frontier, sorted and without duplicates. The only per-state memory is the |
+| table being built, 2 bits of distance mod 3 per state (60 MB for 3x4).     |
+| After every layer the table and the layer counts go to a checkpoint file;  |
+| run the same command again after a crash and it carries on from there.    |
+| Reports the I/O volume and throughput and the peak resident set size.     |
+\******************************************************************************/
+#include "distance_table.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define CHECKPOINT_MAGIC "PUZBFS1"
+#define UNSEEN 3 // 2 bit entry of a state no layer has reached yet
+#define DEFAULT_MEMORY_MB 64
+#define READ_CHUNK 65536 // indices read at a time from a frontier or run file
+#define MAX_RUNS 256
+#define MAX_DEPTH 256
+
+/* the table and the layer counts after 'depth' layers are done. the sorted
+states of layer 'depth' are in the frontier file of that depth */
+struct checkpoint_header {
+	char magic[8];
+	int rows;
+	int cols;
+	unsigned long long states;
+	int depth;
+	int reserved;
+	unsigned long long level_count[MAX_DEPTH];
+};
+
+struct io_stats {
+	unsigned long long bytes_read;
+	unsigned long long bytes_written;
+	double seconds;
+};
+
+struct run_reader {
+	FILE *file;
+	unsigned int buffer[READ_CHUNK];
+	size_t count;
+	size_t pos;
+};
+
+static io_stats g_io;
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+static bool write_bytes( FILE *file, const void *data, size_t size ) {
+	double start = now_seconds();
+	bool ok = fwrite( data, 1, size, file ) == size;
+	g_io.seconds += now_seconds() - start;
+	g_io.bytes_written += size;
+	return ok;
+}
+
+static size_t read_bytes( FILE *file, void *data, size_t size ) {
+	double start = now_seconds();
+	size_t got = fread( data, 1, size, file );
+	g_io.seconds += now_seconds() - start;
+	g_io.bytes_read += got;
+	return got;
+}
+
+static double peak_rss_mb() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) );
+	return counters.PeakWorkingSetSize / ( 1024.0 * 1024.0 );
+#else
+	struct rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+	return usage.ru_maxrss / ( 1024.0 * 1024.0 ); // bytes
+#else
+	return usage.ru_maxrss / 1024.0; // KB
+#endif
+#endif
+}
+
+static inline int entry_get( const unsigned char *table, unsigned long long i ) {
+	return ( table[i >> 2] >> ( ( i & 3 ) << 1 ) ) & 3;
+}
+
+static inline void entry_set( unsigned char *table, unsigned long long i, int value ) {
+	int shift = (int)( ( i & 3 ) << 1 );
+	table[i >> 2] = (unsigned char)( ( table[i >> 2] & ~( 3 << shift ) ) | ( value << shift ) );
+}
+
+static void frontier_name( char *name, const char *output, int depth ) {
+	sprintf( name, "%s.frontier%i", output, depth );
+}
+
+static void run_name( char *name, const char *output, int run ) {
+	sprintf( name, "%s.run%i", output, run );
+}
+
+/* LSD radix sort on 11 bit digits. returns whichever buffer ends up sorted */
+static unsigned int *radix_sort( unsigned int *keys, unsigned int *scratch, size_t count ) {
+	static size_t offsets[2048];
+	for ( int shift = 0; shift < 32; shift += 11 ) {
+		memset( offsets, 0, sizeof( offsets ) );
+		for ( size_t i = 0; i < count; i++ ) {
+			offsets[( keys[i] >> shift ) & 2047]++;
+		}
+		size_t sum = 0;
+		for ( int d = 0; d < 2048; d++ ) {
+			size_t c = offsets[d];
+			offsets[d] = sum;
+			sum += c;
+		}
+		for ( size_t i = 0; i < count; i++ ) {
+			scratch[offsets[( keys[i] >> shift ) & 2047]++] = keys[i];
+		}
+		unsigned int *t = keys;
+		keys = scratch;
+		scratch = t;
+	}
+	return keys;
+}
+
+/* sorts and deduplicates the buffer into the next run file */
+static bool flush_run( const char *output, unsigned int *buffer, unsigned int *scratch,
+											 size_t count, int *run_count ) {
+	if ( *run_count >= MAX_RUNS ) {
+		fprintf( stderr, "ERROR: more than %i runs in a layer, give it more memory\n", MAX_RUNS );
+		return false;
+	}
+	unsigned int *sorted = radix_sort( buffer, scratch, count );
+	size_t unique = 0;
+	for ( size_t i = 0; i < count; i++ ) {
+		if ( 0 == unique || sorted[i] != sorted[unique - 1] ) {
+			sorted[unique++] = sorted[i];
+		}
+	}
+	char name[1024];
+	run_name( name, output, ( *run_count )++ );
+	FILE *file = fopen( name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", name );
+		return false;
+	}
+	bool ok = write_bytes( file, sorted, unique * sizeof( unsigned int ) );
+	ok = 0 == fclose( file ) && ok;
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: could not write %s\n", name );
+	}
+	return ok;
+}
+
+/* neighbours of every state of layer 'depth' that no layer has reached yet,
+into sorted runs of unique states */
+static bool expand_layer( int rows, int cols, const char *output, int depth,
+													const unsigned char *table, unsigned int *buffer, unsigned int *scratch,
+													size_t capacity, int *run_count ) {
+	int n = rows * cols;
+	char name[1024];
+	frontier_name( name, output, depth );
+	FILE *frontier = fopen( name, "rb" );
+	if ( !frontier ) {
+		fprintf( stderr, "ERROR: could not open %s\n", name );
+		return false;
+	}
+	static unsigned int chunk[READ_CHUNK];
+	size_t count = 0;
+	*run_count = 0;
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	size_t got;
+	while ( ( got = read_bytes( frontier, chunk, sizeof( chunk ) ) / sizeof( unsigned int ) ) > 0 ) {
+		for ( size_t c = 0; c < got; c++ ) {
+			distance_table_unindex( rows, cols, chunk[c], tiles );
+			int blank = 0;
+			while ( tiles[blank] != n - 1 ) {
+				blank++;
+			}
+			int neighbours[4] = { blank - cols, blank + cols, blank % cols > 0 ? blank - 1 : -1,
+														blank % cols < cols - 1 ? blank + 1 : -1 };
+			for ( int i = 0; i < 4; i++ ) {
+				int from = neighbours[i];
+				if ( from < 0 || from >= n ) {
+					continue;
+				}
+				tiles[blank] = tiles[from];
+				tiles[from] = n - 1;
+				unsigned long long state = distance_table_index( rows, cols, tiles );
+				tiles[from] = tiles[blank];
+				tiles[blank] = n - 1;
+				// the graph is bipartite: a neighbour is in layer depth - 1, which
+				// the table knows, or depth + 1
+				if ( UNSEEN != entry_get( table, state ) ) {
+					continue;
+				}
+				buffer[count++] = (unsigned int)state;
+				if ( count == capacity ) {
+					if ( !flush_run( output, buffer, scratch, count, run_count ) ) {
+						fclose( frontier );
+						return false;
+					}
+					count = 0;
+				}
+			}
+		}
+	}
+	fclose( frontier );
+	return count > 0 ? flush_run( output, buffer, scratch, count, run_count ) : true;
+}
+
+static bool run_next( run_reader *r, unsigned int *value ) {
+	if ( r->pos == r->count ) {
+		r->count = read_bytes( r->file, r->buffer, sizeof( r->buffer ) ) / sizeof( unsigned int );
+		r->pos = 0;
+		if ( 0 == r->count ) {
+			return false;
+		}
+	}
+	*value = r->buffer[r->pos++];
+	return true;
+}
+
+/* k-way merge of the runs into the frontier of layer depth + 1, marking
+its states in the table. returns the layer's size, or -1 on an error */
+static long long merge_runs( const char *output, int depth, unsigned char *table, int run_count,
+														 unsigned int *out_buffer, size_t out_capacity ) {
+	run_reader *readers = (run_reader *)malloc( ( run_count > 0 ? run_count : 1 ) * sizeof( run_reader ) );
+	unsigned int heads[MAX_RUNS];
+	bool live[MAX_RUNS];
+	char name[1024];
+	if ( !readers ) {
+		fprintf( stderr, "ERROR: could not allocate %i run readers\n", run_count );
+		return -1;
+	}
+	bool ok = true;
+	for ( int r = 0; r < run_count; r++ ) {
+		run_name( name, output, r );
+		readers[r].file = fopen( name, "rb" );
+		readers[r].count = 0;
+		readers[r].pos = 0;
+		ok = ok && readers[r].file;
+		live[r] = readers[r].file && run_next( &readers[r], &heads[r] );
+	}
+	frontier_name( name, output, depth + 1 );
+	FILE *next = fopen( name, "wb" );
+	long long count = 0;
+	size_t out_count = 0;
+	int value = ( depth + 1 ) % 3;
+	bool have_last = false;
+	unsigned int last = 0;
+	while ( ok && next ) {
+		// fewest runs there are, a linear scan for the smallest head is fine
+		int best = -1;
+		for ( int r = 0; r < run_count; r++ ) {
+			if ( live[r] && ( best < 0 || heads[r] < heads[best] ) ) {
+				best = r;
+			}
+		}
+		if ( best < 0 ) {
+			break;
+		}
+		unsigned int state = heads[best];
+		live[best] = run_next( &readers[best], &heads[best] );
+		if ( have_last && state == last ) {
+			continue; // in more than one run
+		}
+		have_last = true;
+		last = state;
+		entry_set( table, state, value );
+		out_buffer[out_count++] = state;
+		count++;
+		if ( out_count == out_capacity ) {
+			ok = write_bytes( next, out_buffer, out_count * sizeof( unsigned int ) );
+			out_count = 0;
+		}
+	}
+	if ( ok && next && out_count > 0 ) {
+		ok = write_bytes( next, out_buffer, out_count * sizeof( unsigned int ) );
+	}
+	ok = next && 0 == fclose( next ) && ok;
+	for ( int r = 0; r < run_count; r++ ) {
+		if ( readers[r].file ) {
+			fclose( readers[r].file );
+		}
+		run_name( name, output, r );
+		remove( name );
+	}
+	free( readers );
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: merging the runs of layer %i failed\n", depth + 1 );
+		return -1;
+	}
+	return count;
+}
+
+/* writes the checkpoint next to it and then renames it over the old one, so
+a crash leaves either the old or the new checkpoint whole */
+static bool write_checkpoint( const char *output, const checkpoint_header *header,
+															const unsigned char *table, unsigned long long bytes ) {
+	char name[1024], temp_name[1024];
+	sprintf( name, "%s.checkpoint", output );
+	sprintf( temp_name, "%s.checkpoint.tmp", output );
+	FILE *file = fopen( temp_name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", temp_name );
+		return false;
+	}
+	bool ok = write_bytes( file, header, sizeof( checkpoint_header ) ) &&
+						write_bytes( file, table, bytes );
+	ok = 0 == fclose( file ) && ok;
+#ifdef _WIN32
+	remove( name ); // rename() does not replace on Windows
+#endif
+	if ( !ok || 0 != rename( temp_name, name ) ) {
+		fprintf( stderr, "ERROR: could not write %s\n", name );
+		return false;
+	}
+	return true;
+}
+
+/* picks up a checkpoint for this board, if there is one */
+static bool read_checkpoint( const char *output, checkpoint_header *header, unsigned char *table,
+														 unsigned long long bytes ) {
+	char name[1024];
+	sprintf( name, "%s.checkpoint", output );
+	FILE *file = fopen( name, "rb" );
+	if ( !file ) {
+		return false;
+	}
+	checkpoint_header saved;
+	bool ok = read_bytes( file, &saved, sizeof( saved ) ) == sizeof( saved ) &&
+						0 == memcmp( saved.magic, CHECKPOINT_MAGIC, sizeof( CHECKPOINT_MAGIC ) ) &&
+						saved.rows == header->rows && saved.cols == header->cols &&
+						saved.states == header->states && read_bytes( file, table, bytes ) == bytes;
+	fclose( file );
+	if ( ok ) {
+		*header = saved;
+	} else {
+		fprintf( stderr, "%s is for another board or damaged, starting over\n", name );
+	}
+	return ok;
+}
+
+int main( int argc, char **argv ) {
+	if ( argc < 4 ) {
+		fprintf( stderr, "usage: %s <rows> <cols> <output file> [memory MB]\n", argv[0] );
+		return 1;
+	}
+	int rows = atoi( argv[1] );
+	int cols = atoi( argv[2] );
+	const char *output = argv[3];
+	int memory_mb = argc > 4 ? atoi( argv[4] ) : DEFAULT_MEMORY_MB;
+	if ( rows < 2 || cols < 2 || rows * cols > DISTANCE_TABLE_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: board must be between 2x2 and %i cells\n",
+						 DISTANCE_TABLE_MAX_CELLS );
+		return 1;
+	}
+	if ( memory_mb < 1 ) {
+		memory_mb = DEFAULT_MEMORY_MB;
+	}
+	int n = rows * cols;
+	unsigned long long states = distance_table_state_count( rows, cols );
+	unsigned long long bytes = ( states + 3 ) / 4;
+	// the sort buffer and its radix scratch share the memory budget
+	size_t capacity = (size_t)memory_mb * 1024 * 1024 / ( 2 * sizeof( unsigned int ) );
+	unsigned char *table = (unsigned char *)malloc( bytes );
+	unsigned int *buffer = (unsigned int *)malloc( capacity * sizeof( unsigned int ) );
+	unsigned int *scratch = (unsigned int *)malloc( capacity * sizeof( unsigned int ) );
+	if ( !table || !buffer || !scratch ) {
+		fprintf( stderr, "ERROR: could not allocate the table and %i MB of sort buffers\n",
+						 memory_mb );
+		return 1;
+	}
+	printf( "building %ix%i: %llu states, %.1f MB table, %i MB sort buffers\n", rows, cols, states,
+					bytes / ( 1024.0 * 1024.0 ), memory_mb );
+	double start = now_seconds();
+
+	checkpoint_header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, CHECKPOINT_MAGIC, sizeof( CHECKPOINT_MAGIC ) );
+	header.rows = rows;
+	header.cols = cols;
+	header.states = states;
+	if ( read_checkpoint( output, &header, table, bytes ) ) {
+		printf( "resuming after layer %i\n", header.depth );
+	} else {
+		// layer 0 is the goal on its own
+		memset( table, 0xFF, bytes );
+		int tiles[DISTANCE_TABLE_MAX_CELLS];
+		for ( int i = 0; i < n; i++ ) {
+			tiles[i] = i;
+		}
+		unsigned int goal = (unsigned int)distance_table_index( rows, cols, tiles );
+		entry_set( table, goal, 0 );
+		char name[1024];
+		frontier_name( name, output, 0 );
+		FILE *file = fopen( name, "wb" );
+		bool ok = file && write_bytes( file, &goal, sizeof( goal ) );
+		ok = file && 0 == fclose( file ) && ok;
+		header.depth = 0;
+		header.level_count[0] = 1;
+		if ( !ok || !write_checkpoint( output, &header, table, bytes ) ) {
+			return 1;
+		}
+	}
+
+	for ( ;; ) {
+		double layer_start = now_seconds();
+		int run_count;
+		if ( !expand_layer( rows, cols, output, header.depth, table, buffer, scratch, capacity,
+												&run_count ) ) {
+			return 1;
+		}
+		long long count = merge_runs( output, header.depth, table, run_count, buffer, capacity );
+		if ( count < 0 ) {
+			return 1;
+		}
+		char name[1024];
+		if ( 0 == count ) {
+			frontier_name( name, output, header.depth + 1 );
+			remove( name );
+			break;
+		}
+		if ( header.depth + 1 >= MAX_DEPTH ) {
+			fprintf( stderr, "ERROR: distances go past %i moves\n", MAX_DEPTH - 1 );
+			return 1;
+		}
+		header.depth++;
+		header.level_count[header.depth] = count;
+		if ( !write_checkpoint( output, &header, table, bytes ) ) {
+			return 1;
+		}
+		// the checkpoint points at the new frontier now
+		frontier_name( name, output, header.depth - 1 );
+		remove( name );
+		printf( "  %2i moves: %llu states (%i runs, %.2f s)\n", header.depth, (unsigned long long)count,
+						run_count, now_seconds() - layer_start );
+		fflush( stdout );
+	}
+	unsigned long long total = 0;
+	for ( int d = 0; d <= header.depth; d++ ) {
+		total += header.level_count[d];
+	}
+	if ( total != states ) {
+		fprintf( stderr, "ERROR: reached %llu of %llu states\n", total, states );
+		return 1;
+	}
+
+	distance_table_header out;
+	memset( &out, 0, sizeof( out ) );
+	memcpy( out.magic, DISTANCE_TABLE_MAGIC, sizeof( DISTANCE_TABLE_MAGIC ) );
+	out.rows = rows;
+	out.cols = cols;
+	out.states = states;
+	out.max_distance = header.depth;
+	out.encoding = DISTANCE_TABLE_MOD3;
+	FILE *file = fopen( output, "wb" );
+	bool ok = file && write_bytes( file, &out, sizeof( out ) ) && write_bytes( file, table, bytes );
+	ok = file && 0 == fclose( file ) && ok;
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: could not write %s\n", output );
+		return 1;
+	}
+	char name[1024];
+	sprintf( name, "%s.checkpoint", output );
+	remove( name );
+	frontier_name( name, output, header.depth );
+	remove( name );
+	double seconds = now_seconds() - start;
+	printf( "built in %.1f s, hardest states %i moves, %s is %.1f MB\n", seconds, header.depth,
+					output, ( sizeof( out ) + bytes ) / ( 1024.0 * 1024.0 ) );
+	printf( "I/O: %.1f MB read, %.1f MB written, %.1f MB/s over %.1f s of I/O\n",
+					g_io.bytes_read / ( 1024.0 * 1024.0 ), g_io.bytes_written / ( 1024.0 * 1024.0 ),
+					( g_io.bytes_read + g_io.bytes_written ) / ( 1024.0 * 1024.0 ) /
+						( g_io.seconds > 0.0 ? g_io.seconds : 1.0 ),
+					g_io.seconds );
+	printf( "peak resident set: %.1f MB\n", peak_rss_mb() );
+	free( scratch );
+	free( buffer );
+
+	// read it back: every state but the goal has a neighbour one move nearer
+	distance_table t;
+	if ( !distance_table_open( &t, output, rows, cols ) ) {
+		return 1;
+	}
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	int samples = states < 100000 ? (int)states : 100000;
+	long long sum = 0;
+	start = now_seconds();
+	for ( int i = 0; i < samples; i++ ) {
+		distance_table_unindex( rows, cols, (unsigned long long)i * ( states / samples ), tiles );
+		int d = distance_table_lookup( &t, tiles );
+		if ( d < 0 || d > header.depth || d % 3 != entry_get( table, (unsigned long long)i * ( states / samples ) ) ) {
+			fprintf( stderr, "ERROR: state %i reads back as %i moves\n", i, d );
+			return 1;
+		}
+		sum += d;
+	}
+	printf( "lookup: %.1f us per state, mean distance of %i samples %.2f\n",
+					( now_seconds() - start ) * 1e6 / samples, samples, (double)sum / samples );
+	distance_table_close( &t );
+	free( table );
+	return 0;
+}
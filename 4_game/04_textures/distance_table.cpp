@@ -0,0 +1,199 @@
+#include "distance_table.h"
+#include "perm_rank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the other tiles' parity on a solvable board with the blank in 'blank' */
+static int tile_parity( int rows, int cols, int blank ) {
+	int n = rows * cols;
+	// whole permutation parity matches the blank's distance from slot n - 1.
+	// the blank (the largest id) sitting in 'blank' adds n - 1 - blank
+	// inversions on top of the other tiles'
+	int blank_distance = ( rows - 1 - blank / cols ) + ( cols - 1 - blank % cols );
+	return ( blank_distance + n - 1 - blank ) & 1;
+}
+
+unsigned long long distance_table_state_count( int rows, int cols ) {
+	return perm_count( rows * cols ) / 2;
+}
+
+unsigned long long distance_table_index( int rows, int cols, const int *tiles ) {
+	int n = rows * cols;
+	int others[DISTANCE_TABLE_MAX_CELLS];
+	int blank = 0;
+	for ( int slot = 0, i = 0; slot < n; slot++ ) {
+		if ( tiles[slot] == n - 1 ) {
+			blank = slot;
+		} else {
+			others[i++] = tiles[slot];
+		}
+	}
+	return (unsigned long long)blank * ( perm_count( n - 1 ) / 2 ) +
+				 perm_rank_half( others, n - 1 );
+}
+
+void distance_table_unindex( int rows, int cols, unsigned long long index, int *tiles ) {
+	int n = rows * cols;
+	unsigned long long per_blank = perm_count( n - 1 ) / 2;
+	int blank = (int)( index / per_blank );
+	int others[DISTANCE_TABLE_MAX_CELLS];
+	perm_unrank_half( index % per_blank, n - 1, tile_parity( rows, cols, blank ), others );
+	for ( int slot = 0, i = 0; slot < n; slot++ ) {
+		tiles[slot] = slot == blank ? n - 1 : others[i++];
+	}
+}
+
+bool distance_table_open( distance_table *t, const char *file_name, int rows, int cols ) {
+	memset( t, 0, sizeof( distance_table ) );
+	if ( !mapped_file_open_read( &t->file, file_name ) ) {
+		return false;
+	}
+	const distance_table_header *header = (const distance_table_header *)t->file.data;
+	if ( t->file.size < sizeof( distance_table_header ) ||
+			 0 != memcmp( header->magic, DISTANCE_TABLE_MAGIC, sizeof( DISTANCE_TABLE_MAGIC ) ) ) {
+		fprintf( stderr, "ERROR: %s is not a distance table\n", file_name );
+		distance_table_close( t );
+		return false;
+	}
+	if ( header->rows != rows || header->cols != cols ) {
+		fprintf( stderr, "ERROR: %s is for %ix%i boards, not %ix%i\n", file_name, header->rows,
+						 header->cols, rows, cols );
+		distance_table_close( t );
+		return false;
+	}
+	t->rows = rows;
+	t->cols = cols;
+	t->n = rows * cols;
+	t->states = distance_table_state_count( rows, cols );
+	t->max_distance = header->max_distance;
+	t->encoding = header->encoding;
+	if ( DISTANCE_TABLE_HALVES != t->encoding && DISTANCE_TABLE_MOD3 != t->encoding ) {
+		fprintf( stderr, "ERROR: %s has unknown entry encoding %i\n", file_name, t->encoding );
+		distance_table_close( t );
+		return false;
+	}
+	unsigned long long bytes =
+		DISTANCE_TABLE_MOD3 == t->encoding ? ( t->states + 3 ) / 4 : ( t->states + 1 ) / 2;
+	if ( header->states != t->states || sizeof( distance_table_header ) + bytes > t->file.size ) {
+		fprintf( stderr, "ERROR: %s is truncated\n", file_name );
+		distance_table_close( t );
+		return false;
+	}
+	t->entries = (const unsigned char *)t->file.data + sizeof( distance_table_header );
+	return true;
+}
+
+void distance_table_close( distance_table *t ) { mapped_file_close( &t->file ); }
+
+static inline int mod3_entry( const distance_table *t, unsigned long long index ) {
+	return ( t->entries[index >> 2] >> ( ( index & 3 ) << 1 ) ) & 3;
+}
+
+/* slot of the neighbour of 'tiles' whose distance is 'residue' mod 3 */
+static int mod3_neighbour( const distance_table *t, int *tiles, int blank, int residue ) {
+	int cols = t->cols;
+	int neighbours[4] = { blank - cols, blank + cols, blank % cols > 0 ? blank - 1 : -1,
+												blank % cols < cols - 1 ? blank + 1 : -1 };
+	for ( int i = 0; i < 4; i++ ) {
+		int from = neighbours[i];
+		if ( from < 0 || from >= t->n ) {
+			continue;
+		}
+		tiles[blank] = tiles[from];
+		tiles[from] = t->n - 1;
+		int entry = mod3_entry( t, distance_table_index( t->rows, t->cols, tiles ) );
+		tiles[from] = tiles[blank];
+		tiles[blank] = t->n - 1;
+		if ( entry == residue ) {
+			return from;
+		}
+	}
+	return -1;
+}
+
+/* walks down to the goal: the neighbour one move nearer is the one with
+residue - 1 mod 3, and the goal is the only board without one */
+static int mod3_lookup( const distance_table *t, const int *start ) {
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	memcpy( tiles, start, t->n * sizeof( int ) );
+	int blank = 0;
+	while ( tiles[blank] != t->n - 1 ) {
+		blank++;
+	}
+	int distance = 0;
+	int residue = mod3_entry( t, distance_table_index( t->rows, t->cols, tiles ) );
+	for ( ;; ) {
+		residue = ( residue + 2 ) % 3;
+		int from = mod3_neighbour( t, tiles, blank, residue );
+		if ( from < 0 ) {
+			return distance;
+		}
+		tiles[blank] = tiles[from];
+		tiles[from] = t->n - 1;
+		blank = from;
+		distance++;
+	}
+}
+
+int distance_table_lookup( const distance_table *t, const int *tiles ) {
+	if ( DISTANCE_TABLE_MOD3 == t->encoding ) {
+		return mod3_lookup( t, tiles );
+	}
+	unsigned long long index = distance_table_index( t->rows, t->cols, tiles );
+	int half = ( t->entries[index >> 1] >> ( ( index & 1 ) << 2 ) ) & 0xF;
+	int blank = 0;
+	while ( tiles[blank] != t->n - 1 ) {
+		blank++;
+	}
+	int blank_distance = ( t->rows - 1 - blank / t->cols ) + ( t->cols - 1 - blank % t->cols );
+	return 2 * half + ( blank_distance & 1 );
+}
+
+int distance_table_step( const distance_table *t, const int *tiles, int distance ) {
+	if ( DISTANCE_TABLE_MOD3 != t->encoding ) {
+		int next = distance_table_lookup( t, tiles );
+		return next == distance + 1 || next == distance - 1 ? next : -1;
+	}
+	int residue = mod3_entry( t, distance_table_index( t->rows, t->cols, tiles ) );
+	if ( residue == ( distance + 1 ) % 3 ) {
+		return distance + 1;
+	}
+	return distance > 0 && residue == ( distance + 2 ) % 3 ? distance - 1 : -1;
+}
+
+bool distance_table_best_move( const distance_table *t, const board *b, board_dir *dir ) {
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	memcpy( tiles, b->tiles, b->n * sizeof( int ) );
+	if ( DISTANCE_TABLE_MOD3 == t->encoding ) {
+		int residue = mod3_entry( t, distance_table_index( t->rows, t->cols, tiles ) );
+		int from = mod3_neighbour( t, tiles, b->blank, ( residue + 2 ) % 3 );
+		for ( int d = BOARD_UP; d <= BOARD_RIGHT && from >= 0; d++ ) {
+			if ( board_move_source( b, (board_dir)d ) == from ) {
+				*dir = (board_dir)d;
+				return true;
+			}
+		}
+		return false;
+	}
+	int distance = distance_table_lookup( t, b->tiles );
+	if ( 0 == distance ) {
+		return false;
+	}
+	for ( int d = BOARD_UP; d <= BOARD_RIGHT; d++ ) {
+		int from = board_move_source( b, (board_dir)d );
+		if ( from < 0 ) {
+			continue;
+		}
+		tiles[b->blank] = tiles[from];
+		tiles[from] = b->n - 1;
+		int next = distance_table_lookup( t, tiles );
+		tiles[from] = tiles[b->blank];
+		tiles[b->blank] = b->n - 1;
+		if ( next == distance - 1 ) {
+			*dir = (board_dir)d;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,78 @@
+/******************************************************************************\
+| Exact distance to the solution for every state of a small board.            |
+| A 3x3 board has only 9!/2 = 181440 solvable states, so dist_build can walk  |
+| all of them breadth first from the goal and store every distance. A state    |
+| is numbered by the blank's slot and the perm_rank_half() rank of the other   |
+| tiles -- which parity they have follows from the blank slot on a solvable    |
+| board -- giving a dense 0..states-1 index in O(n).                          |
+| Entries are 4 bits holding floor( distance / 2 ): every move takes the      |
+| blank one step, so the distance has the parity of the blank's Manhattan     |
+| distance to its home slot and the low bit needs no storage. 3x3 tops out at |
+| 31 moves, which just fits. The table is 89 KB and memory mapped read-only.   |
+| Bigger boards (3x4 and 2x6, built by dist_build_ext) go past 31 moves and  |
+| store distance mod 3 in 2 bits instead. A neighbour is always one move     |
+| nearer or further, and mod 3 tells which, so the distance is the length of |
+| the walk down to the goal and the step after a move is O(1).               |
+\******************************************************************************/
+#ifndef _DISTANCE_TABLE_H_
+#define _DISTANCE_TABLE_H_
+
+#include "board.h"
+#include "mapped_file.h"
+
+// 12!/2 states still index with 32 bits
+#define DISTANCE_TABLE_MAX_CELLS 12
+#define DISTANCE_TABLE_MAX_DISTANCE 31
+#define DISTANCE_TABLE_MAGIC "PUZDST1"
+// entry encodings, distance_table_header::encoding
+#define DISTANCE_TABLE_HALVES 0 // 4 bits of floor( distance / 2 )
+#define DISTANCE_TABLE_MOD3 1		// 2 bits of distance % 3
+
+struct distance_table {
+	int rows;
+	int cols;
+	int n;
+	unsigned long long states;
+	int max_distance;
+	int encoding;
+	// entry i is in byte i / 2 (halves) or i / 4 (mod 3), low bits first
+	const unsigned char *entries;
+	mapped_file file;
+};
+
+/* on-disk layout: this header, then the entries */
+struct distance_table_header {
+	char magic[8];
+	int rows;
+	int cols;
+	unsigned long long states;
+	int max_distance;
+	int encoding; // 0 in the first tables, which were all halves
+};
+
+/* number of solvable states of a rows x cols board, n!/2 */
+unsigned long long distance_table_state_count( int rows, int cols );
+
+/* index of the solvable board 'tiles' in 0..state count-1 */
+unsigned long long distance_table_index( int rows, int cols, const int *tiles );
+
+/* inverse of distance_table_index() */
+void distance_table_unindex( int rows, int cols, unsigned long long index, int *tiles );
+
+/* maps 'file_name' and checks it was built for the given board size */
+bool distance_table_open( distance_table *t, const char *file_name, int rows, int cols );
+
+void distance_table_close( distance_table *t );
+
+/* moves left on an optimal solution of 'tiles', which must be solvable.
+O(1) for halves, O(distance) for mod 3 tables */
+int distance_table_lookup( const distance_table *t, const int *tiles );
+
+/* distance of 'tiles', one move away from a board 'distance' moves from
+solved. O(1) for both encodings. -1 if the table disagrees with 'distance' */
+int distance_table_step( const distance_table *t, const int *tiles, int distance );
+
+/* a move that brings 'b' one step closer to solved. false if it is solved */
+bool distance_table_best_move( const distance_table *t, const board *b, board_dir *dir );
+
+#endif
@@ -0,0 +1,46 @@
+#include "frame_stats.h"
+#include <stdio.h>
+#include <string.h>
+
+void frame_stats_reset( frame_stats *f ) { memset( f, 0, sizeof( frame_stats ) ); }
+
+void frame_stats_add( frame_stats *f, double seconds ) {
+	int bucket = (int)( seconds / FRAME_STATS_BUCKET_SECONDS );
+	if ( bucket < 0 ) {
+		bucket = 0;
+	} else if ( bucket >= FRAME_STATS_BUCKETS ) {
+		bucket = FRAME_STATS_BUCKETS - 1;
+	}
+	f->buckets[bucket]++;
+	f->count++;
+	f->sum += seconds;
+	if ( seconds > f->max ) {
+		f->max = seconds;
+	}
+}
+
+double frame_stats_percentile( const frame_stats *f, double p ) {
+	if ( 0 == f->count ) {
+		return 0.0;
+	}
+	unsigned long long rank = (unsigned long long)( p * f->count );
+	if ( rank >= f->count ) {
+		rank = f->count - 1;
+	}
+	unsigned long long seen = 0;
+	for ( int i = 0; i < FRAME_STATS_BUCKETS - 1; i++ ) {
+		seen += f->buckets[i];
+		if ( seen > rank ) {
+			double top = ( i + 1 ) * FRAME_STATS_BUCKET_SECONDS;
+			return top < f->max ? top : f->max;
+		}
+	}
+	return f->max;
+}
+
+void frame_stats_print( const frame_stats *f, const char *name ) {
+	printf( "%s: %llu frames, ms mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", name, f->count,
+					f->count ? 1000.0 * f->sum / f->count : 0.0, 1000.0 * frame_stats_percentile( f, 0.5 ),
+					1000.0 * frame_stats_percentile( f, 0.9 ), 1000.0 * frame_stats_percentile( f, 0.99 ),
+					1000.0 * f->max );
+}
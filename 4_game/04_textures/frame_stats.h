@@ -0,0 +1,32 @@
+/******************************************************************************\
+| Frame time percentiles in constant memory.                                  |
+| Every frame time goes into a histogram of 10 microsecond buckets up to     |
+| 100 ms (longer frames share the last bucket, the maximum is kept exactly), |
+| so a run of any length costs one increment a frame and the percentiles are |
+| read off the histogram at the end to within a bucket.                      |
+\******************************************************************************/
+#ifndef _FRAME_STATS_H_
+#define _FRAME_STATS_H_
+
+#define FRAME_STATS_BUCKET_SECONDS 0.00001
+#define FRAME_STATS_BUCKETS 10000
+
+struct frame_stats {
+	unsigned int buckets[FRAME_STATS_BUCKETS];
+	unsigned long long count;
+	double sum;
+	double max;
+};
+
+void frame_stats_reset( frame_stats *f );
+
+void frame_stats_add( frame_stats *f, double seconds );
+
+/* frame time in seconds that fraction 'p' (0..1) of the frames took at most.
+the top of its bucket, or the exact maximum past the last bucket */
+double frame_stats_percentile( const frame_stats *f, double p );
+
+/* one line of mean, p50, p90, p99 and max in ms after 'name' */
+void frame_stats_print( const frame_stats *f, const char *name );
+
+#endif
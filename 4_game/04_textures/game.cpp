@@ -0,0 +1,204 @@
+#include "game.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <string.h>
+
+bool game_init( game *g, int rows, int cols, const int *tiles, const char *record_file ) {
+	memset( g, 0, sizeof( game ) );
+	if ( rows * cols > GAME_MAX_CELLS || !board_init( &g->b, rows, cols, tiles ) ) {
+		fprintf( stderr, "ERROR: could not create a %ix%i board\n", rows, cols );
+		return false;
+	}
+	if ( record_file ) {
+		if ( !movelog_create( &g->recording, record_file, &g->b, MOVELOG_DEFAULT_INTERVAL ) ) {
+			board_free( &g->b );
+			return false;
+		}
+		g->recording_on = true;
+	}
+	if ( !history_init( &g->hist, &g->b ) ) {
+		if ( g->recording_on ) {
+			movelog_close( &g->recording );
+		}
+		board_free( &g->b );
+		return false;
+	}
+	g->distance = -1;
+	g->distance_ok = true;
+	if ( rows * cols <= DISTANCE_TABLE_MAX_CELLS ) {
+		char file_name[64];
+		sprintf( file_name, GAME_DISTANCE_FILE, rows, cols );
+		g->have_dist = distance_table_open( &g->dist, file_name, rows, cols );
+		if ( g->have_dist ) {
+			g->distance = distance_table_lookup( &g->dist, g->b.tiles );
+		} else {
+			fprintf( stderr, "no %s, run %s %i %i %s for hints\n", file_name,
+							 3 == rows && 3 == cols ? "dist_build" : "dist_build_ext", rows, cols, file_name );
+		}
+	}
+	return true;
+}
+
+bool game_free( game *g ) {
+	bool ok = true;
+	if ( g->recording_on ) {
+		ok = movelog_close( &g->recording );
+		g->recording_on = false;
+	}
+	if ( g->have_dist ) {
+		distance_table_close( &g->dist );
+		g->have_dist = false;
+	}
+	history_free( &g->hist );
+	board_free( &g->b );
+	return ok;
+}
+
+int game_key_dir( int key ) {
+	switch ( key ) {
+	case GLFW_KEY_UP:
+		return BOARD_UP;
+	case GLFW_KEY_DOWN:
+		return BOARD_DOWN;
+	case GLFW_KEY_LEFT:
+		return BOARD_LEFT;
+	case GLFW_KEY_RIGHT:
+		return BOARD_RIGHT;
+	}
+	return -1;
+}
+
+int game_dir_key( board_dir dir ) {
+	static const int keys[] = { GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT };
+	return keys[dir];
+}
+
+/* everything a move does but the history */
+static bool play( game *g, board_dir dir ) {
+	if ( !board_move( &g->b, dir ) ) {
+		return false;
+	}
+	g->moves++;
+	if ( board_is_solved( &g->b ) ) {
+		g->solves++;
+	}
+	if ( g->recording_on ) {
+		movelog_append( &g->recording, dir );
+	}
+	if ( g->have_dist ) {
+		int distance = distance_table_step( &g->dist, g->b.tiles, g->distance );
+		if ( distance < 0 ) {
+			g->distance_ok = false;
+			distance = distance_table_lookup( &g->dist, g->b.tiles );
+		}
+		g->distance = distance;
+	}
+	return true;
+}
+
+bool game_move( game *g, board_dir dir ) {
+	if ( !play( g, dir ) ) {
+		return false;
+	}
+	history_push( &g->hist, dir, &g->b );
+	return true;
+}
+
+bool game_undo( game *g ) {
+	board_dir dir;
+	return history_undo( &g->hist, &dir ) && play( g, dir );
+}
+
+bool game_redo( game *g ) {
+	board_dir dir;
+	return history_redo( &g->hist, &dir ) && play( g, dir );
+}
+
+bool game_jump( game *g, unsigned long long position ) {
+	unsigned long long from = g->hist.position;
+	int tiles[GAME_MAX_CELLS];
+	if ( position == from || !history_seek( &g->hist, position, tiles ) ) {
+		return false;
+	}
+	if ( g->recording_on ) {
+		// the log only knows moves: the ones taken back, or played again
+		for ( unsigned long long i = from; i > position; i-- ) {
+			movelog_append( &g->recording, (board_dir)( history_move( &g->hist, i - 1 ) ^ 1 ) );
+		}
+		for ( unsigned long long i = from; i < position; i++ ) {
+			movelog_append( &g->recording, history_move( &g->hist, i ) );
+		}
+	}
+	board_set( &g->b, tiles );
+	if ( board_is_solved( &g->b ) ) {
+		g->solves++;
+	}
+	if ( g->have_dist ) {
+		g->distance = distance_table_lookup( &g->dist, g->b.tiles );
+	}
+	return true;
+}
+
+bool game_history_key( game *g, int key ) {
+	const history *h = &g->hist;
+	switch ( key ) {
+	case GLFW_KEY_Z:
+		return game_undo( g );
+	case GLFW_KEY_Y:
+		return game_redo( g );
+	case GLFW_KEY_HOME:
+		return game_jump( g, 0 );
+	case GLFW_KEY_END:
+		return game_jump( g, h->length );
+	case GLFW_KEY_PAGE_UP:
+		return game_jump( g, h->position > GAME_JUMP_MOVES ? h->position - GAME_JUMP_MOVES : 0 );
+	case GLFW_KEY_PAGE_DOWN:
+		return game_jump( g, h->length - h->position > GAME_JUMP_MOVES ? h->position + GAME_JUMP_MOVES
+																																		 : h->length );
+	}
+	return false;
+}
+
+bool game_check( const game *g ) {
+	const board *b = &g->b;
+	bool seen[GAME_MAX_CELLS] = { false };
+	int correct = 0;
+	for ( int slot = 0; slot < b->n; slot++ ) {
+		int tile = b->tiles[slot];
+		if ( tile < 0 || tile >= b->n || seen[tile] ) {
+			fprintf( stderr, "ERROR: tile %i in slot %i is out of range or repeated\n", tile, slot );
+			return false;
+		}
+		seen[tile] = true;
+		correct += tile == slot;
+	}
+	if ( b->tiles[b->blank] != b->n - 1 || correct != b->correct ) {
+		fprintf( stderr, "ERROR: board lost track of the blank (%i) or correct count (%i, not %i)\n",
+						 b->blank, b->correct, correct );
+		return false;
+	}
+	// a permutation of n tiles in c cycles has the parity of n - c. moves keep
+	// it equal to the parity of the blank's distance from its home slot
+	bool visited[GAME_MAX_CELLS] = { false };
+	int cycles = 0;
+	for ( int slot = 0; slot < b->n; slot++ ) {
+		if ( visited[slot] ) {
+			continue;
+		}
+		cycles++;
+		for ( int i = slot; !visited[i]; i = b->tiles[i] ) {
+			visited[i] = true;
+		}
+	}
+	int blank_distance =
+		( b->rows - 1 - b->blank / b->cols ) + ( b->cols - 1 - b->blank % b->cols );
+	if ( ( ( b->n - cycles ) & 1 ) != ( blank_distance & 1 ) ) {
+		fprintf( stderr, "ERROR: board is no longer solvable\n" );
+		return false;
+	}
+	if ( !g->distance_ok ) {
+		fprintf( stderr, "ERROR: a move changed the distance to solved by more than one\n" );
+		return false;
+	}
+	return true;
+}
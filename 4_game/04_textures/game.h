@@ -0,0 +1,70 @@
+/******************************************************************************\
+| Game state and rules, without any window or GL.                              |
+| Everything a move does -- the board, the move log, the distance to solved   |
+| -- goes through here, so the windowed loop in main.cpp and the headless      |
+| soak test drive exactly the same code.                                       |
+\******************************************************************************/
+#ifndef _GAME_H_
+#define _GAME_H_
+
+#include "board.h"
+#include "distance_table.h"
+#include "history.h"
+#include "movelog.h"
+
+#define GAME_MAX_CELLS MOVELOG_MAX_CELLS
+#define GAME_DISTANCE_FILE "puzzle%ix%i.dist" // rows, cols
+#define GAME_JUMP_MOVES 100 // through the history with Page Up and Page Down
+
+struct game {
+	board b;
+	distance_table dist; // exact distances, boards up to 12 cells
+	bool have_dist;
+	int distance;				 // moves left to solve, -1 without the distance table
+	bool distance_ok;		 // every move so far changed the distance by exactly one
+	movelog_writer recording;
+	bool recording_on;
+	history hist; // for undo and redo
+	unsigned long long moves;
+	unsigned long long solves; // times a move left the board solved
+	double play_seconds;			 // kept by the caller, for the save game
+};
+
+/* starts a rows x cols game from 'tiles' (NULL for solved). the distance
+table for the board size is opened if it is there, and every move goes to
+'record_file' if it is not NULL */
+bool game_init( game *g, int rows, int cols, const int *tiles, const char *record_file );
+
+/* closes the log and the distance table. false if the log failed to write */
+bool game_free( game *g );
+
+/* board_dir of an arrow key, -1 for any other GLFW_KEY_* */
+int game_key_dir( int key );
+
+/* the arrow key GLFW_KEY_* that plays 'dir' */
+int game_dir_key( board_dir dir );
+
+/* plays 'dir'. false, changing nothing, if the move is not legal */
+bool game_move( game *g, board_dir dir );
+
+/* takes back the last move, or plays the last one taken back again. false
+if there is nothing to undo or redo */
+bool game_undo( game *g );
+bool game_redo( game *g );
+
+/* puts the board where it was after move number 'position' of the history,
+without playing the moves in between: the renderer redraws the whole board.
+a recording gets the moves in between, so it still replays */
+bool game_jump( game *g, unsigned long long position );
+
+/* Z undo, Y redo, Home and End to the first and the latest move, Page Up and
+Page Down GAME_JUMP_MOVES back and forward. false if 'key' is none of them
+or changed nothing */
+bool game_history_key( game *g, int key );
+
+/* full consistency check of the state: the tiles are a permutation with the
+blank where the board says, the correct count and the permutation parity
+match the tiles and the distance table agreed with every move. O(n) */
+bool game_check( const game *g );
+
+#endif
@@ -45,4 +45,10 @@ bool is_valid( GLuint sp );
 
 bool parse_file_into_str( const char *file_name, char *shader_str, int max_len );
 
+bool create_shader( const char *file_name, GLuint *shader, GLenum type );
+
+bool create_programme( GLuint vert, GLuint frag, GLuint *programme );
+
+GLuint create_programme_from_files( const char *vert_file_name, const char *frag_file_name );
+
 #endif
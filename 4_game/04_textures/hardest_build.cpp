@@ -0,0 +1,201 @@
+/******************************************************************************\
+| Finds the hardest positions of a board size for positions_open().           |
+|   ./hardest_build <rows> <cols> <output file> [layers]                      |
+|   ./hardest_build 3 3 hardest3x3.pos 2                                     |
+| Breadth first search back from the goal over every solvable state, writing  |
+| out the states of the deepest 'layers' distances (1 by default), hardest    |
+| first. States are numbered like the distance table and every BFS layer is a |
+| bitset, one bit per state. The puzzle graph is bipartite -- every move takes |
+| the blank to a slot of the other colour -- so the neighbours of layer d are  |
+| all in layer d - 1 or d + 1, and the next layer is just the neighbours that |
+| are not in the previous one: no visited set is needed. Boards up to 12      |
+| cells: 3x4 and 2x6 (239500800 states) take 30 MB per layer.                |
+\******************************************************************************/
+#include "distance_table.h"
+#include "positions.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LAYERS 8
+#define MAX_DEPTH 256
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+static inline bool bit_test( const unsigned long long *bits, unsigned long long i ) {
+	return 0 != ( ( bits[i >> 6] >> ( i & 63 ) ) & 1 );
+}
+
+static inline void bit_set( unsigned long long *bits, unsigned long long i ) {
+	bits[i >> 6] |= 1ULL << ( i & 63 );
+}
+
+static inline int lowest_bit( unsigned long long x ) {
+#if defined( __GNUC__ )
+	return __builtin_ctzll( x );
+#else
+	int i = 0;
+	while ( 0 == ( x & 1 ) ) {
+		x >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+/* expands every state of 'layer' into 'next', skipping those in 'previous'.
+returns the number of states put in 'next' */
+static unsigned long long expand( int rows, int cols, unsigned long long words,
+																	const unsigned long long *previous, const unsigned long long *layer,
+																	unsigned long long *next ) {
+	int n = rows * cols;
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	unsigned long long count = 0;
+	memset( next, 0, words * sizeof( unsigned long long ) );
+	for ( unsigned long long w = 0; w < words; w++ ) {
+		for ( unsigned long long bits = layer[w]; bits; bits &= bits - 1 ) {
+			distance_table_unindex( rows, cols, w * 64 + lowest_bit( bits ), tiles );
+			int blank = 0;
+			while ( tiles[blank] != n - 1 ) {
+				blank++;
+			}
+			int neighbours[4] = { blank - cols, blank + cols, blank % cols > 0 ? blank - 1 : -1,
+														blank % cols < cols - 1 ? blank + 1 : -1 };
+			for ( int i = 0; i < 4; i++ ) {
+				int from = neighbours[i];
+				if ( from < 0 || from >= n ) {
+					continue;
+				}
+				tiles[blank] = tiles[from];
+				tiles[from] = n - 1;
+				unsigned long long state = distance_table_index( rows, cols, tiles );
+				tiles[from] = tiles[blank];
+				tiles[blank] = n - 1;
+				if ( !bit_test( previous, state ) && !bit_test( next, state ) ) {
+					bit_set( next, state );
+					count++;
+				}
+			}
+		}
+	}
+	return count;
+}
+
+int main( int argc, char **argv ) {
+	if ( argc < 4 ) {
+		fprintf( stderr, "usage: %s <rows> <cols> <output file> [layers]\n", argv[0] );
+		return 1;
+	}
+	int rows = atoi( argv[1] );
+	int cols = atoi( argv[2] );
+	const char *file_name = argv[3];
+	int layers = argc > 4 ? atoi( argv[4] ) : 1;
+	if ( rows < 2 || cols < 2 || rows * cols > DISTANCE_TABLE_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: board must be between 2x2 and %i cells\n",
+						 DISTANCE_TABLE_MAX_CELLS );
+		return 1;
+	}
+	if ( layers < 1 || layers > MAX_LAYERS ) {
+		fprintf( stderr, "ERROR: layers must be between 1 and %i\n", MAX_LAYERS );
+		return 1;
+	}
+	int n = rows * cols;
+	unsigned long long states = distance_table_state_count( rows, cols );
+	unsigned long long words = ( states + 63 ) / 64;
+	// ring of the last layers: the deepest ones are written out at the end,
+	// and the one before the current layer is what expand() skips
+	int ring_size = layers > 2 ? layers + 1 : 3;
+	unsigned long long *ring[MAX_LAYERS + 1];
+	for ( int i = 0; i < ring_size; i++ ) {
+		ring[i] = (unsigned long long *)calloc( words, sizeof( unsigned long long ) );
+		if ( !ring[i] ) {
+			fprintf( stderr, "ERROR: could not allocate %i layers of %llu bytes\n", ring_size,
+							 words * 8 );
+			return 1;
+		}
+	}
+	printf( "searching %ix%i: %llu states, %i layers of %.1f MB\n", rows, cols, states, ring_size,
+					words * 8 / ( 1024.0 * 1024.0 ) );
+	double start = now_seconds();
+
+	int tiles[DISTANCE_TABLE_MAX_CELLS];
+	for ( int i = 0; i < n; i++ ) {
+		tiles[i] = i;
+	}
+	unsigned long long level_count[MAX_DEPTH] = { 0 };
+	bit_set( ring[0], distance_table_index( rows, cols, tiles ) );
+	level_count[0] = 1;
+	unsigned long long total = 1;
+	int depth = 0;
+	while ( depth + 1 < MAX_DEPTH ) {
+		// layer d lives in ring[d % ring_size]. d - 1's slot is empty at d = 0
+		const unsigned long long *previous = ring[( depth + ring_size - 1 ) % ring_size];
+		unsigned long long count = expand( rows, cols, words, previous, ring[depth % ring_size],
+																			 ring[( depth + 1 ) % ring_size] );
+		if ( 0 == count ) {
+			break;
+		}
+		depth++;
+		level_count[depth] = count;
+		total += count;
+	}
+	for ( int d = 0; d <= depth; d++ ) {
+		printf( "  %2i moves: %llu states\n", d, level_count[d] );
+	}
+	printf( "searched in %.3f s, hardest states %i moves\n", now_seconds() - start, depth );
+	if ( total != states ) {
+		fprintf( stderr, "ERROR: reached %llu of %llu states\n", total, states );
+		return 1;
+	}
+
+	// the deepest layers, hardest first, each in state order
+	if ( layers > depth + 1 ) {
+		layers = depth + 1;
+	}
+	positions_header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, POSITIONS_MAGIC, sizeof( POSITIONS_MAGIC ) );
+	header.rows = rows;
+	header.cols = cols;
+	header.max_distance = depth;
+	header.min_distance = depth - layers + 1;
+	for ( int d = header.min_distance; d <= depth; d++ ) {
+		header.count += level_count[d];
+	}
+	FILE *file = fopen( file_name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		return 1;
+	}
+	fwrite( &header, sizeof( header ), 1, file );
+	unsigned char record[DISTANCE_TABLE_MAX_CELLS + 1];
+	for ( int d = depth; d >= header.min_distance; d-- ) {
+		const unsigned long long *layer = ring[d % ring_size];
+		for ( unsigned long long w = 0; w < words; w++ ) {
+			for ( unsigned long long bits = layer[w]; bits; bits &= bits - 1 ) {
+				distance_table_unindex( rows, cols, w * 64 + lowest_bit( bits ), tiles );
+				record[0] = (unsigned char)d;
+				for ( int slot = 0; slot < n; slot++ ) {
+					record[1 + slot] = (unsigned char)tiles[slot];
+				}
+				fwrite( record, 1, n + 1, file );
+			}
+		}
+	}
+	bool ok = 0 == ferror( file );
+	fclose( file );
+	for ( int i = 0; i < ring_size; i++ ) {
+		free( ring[i] );
+	}
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: could not write %s\n", file_name );
+		return 1;
+	}
+	printf( "%s: %llu positions of %i to %i moves\n", file_name, header.count, header.min_distance,
+					depth );
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "headless.h"
+#include "game.h"
+#include "input.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// simulated frame rate, and key presses per frame, like a very fast player
+#define HEADLESS_FRAME_SECONDS ( 1.0 / 60.0 )
+#define HEADLESS_KEYS_PER_FRAME 8
+// one key in this many is an undo, redo or jump instead of an arrow
+#define HEADLESS_HISTORY_ONE_IN 16
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/* one simulated frame of random key presses through the input queue */
+static bool random_frame( game *g, input *in, double frame_time, unsigned long long *left ) {
+	static const int arrows[4] = { GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT };
+	// undo and redo most, jumps now and then
+	static const int history_keys[8] = { GLFW_KEY_Z,		 GLFW_KEY_Z,				GLFW_KEY_Z,		GLFW_KEY_Y,
+																			 GLFW_KEY_Y,		 GLFW_KEY_PAGE_UP,	GLFW_KEY_END, GLFW_KEY_PAGE_DOWN };
+	for ( int i = 0; i < HEADLESS_KEYS_PER_FRAME; i++ ) {
+		input_event ev;
+		ev.key = 0 == rand() % HEADLESS_HISTORY_ONE_IN ? history_keys[rand() & 7] : arrows[rand() & 3];
+		ev.time = frame_time + i * ( HEADLESS_FRAME_SECONDS / HEADLESS_KEYS_PER_FRAME );
+		ev.action = GLFW_PRESS;
+		input_queue_push( &in->queue, &ev );
+		ev.action = GLFW_RELEASE;
+		input_queue_push( &in->queue, &ev );
+	}
+	int keys[INPUT_QUEUE_SIZE];
+	int key_count = input_poll( in, frame_time + HEADLESS_FRAME_SECONDS, keys, INPUT_QUEUE_SIZE );
+	for ( int i = 0; i < key_count && *left > 0; i++ ) {
+		if ( game_history_key( g, keys[i] ) ) {
+			if ( !game_check( g ) ) {
+				return false;
+			}
+			continue;
+		}
+		int dir = game_key_dir( keys[i] );
+		if ( dir < 0 || !game_move( g, (board_dir)dir ) ) {
+			continue;
+		}
+		( *left )--;
+		if ( !game_check( g ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int headless_run( const headless_options *o ) {
+	movelog_reader replay;
+	game g;
+	bool ok = false;
+	if ( o->replay_file ) {
+		if ( !movelog_open( &replay, o->replay_file ) ) {
+			return 1;
+		}
+		ok = game_init( &g, replay.b.rows, replay.b.cols, replay.b.tiles, o->record_file );
+	} else {
+		// a solved board, scrambled by the random keys themselves
+		ok = game_init( &g, o->rows, o->cols, NULL, o->record_file );
+	}
+	if ( !ok ) {
+		return 1;
+	}
+	srand( o->seed );
+	static input in; // big ring, keep it off the stack
+	input_reset( &in );
+
+	printf( "headless %ix%i: %s\n", g.b.rows, g.b.cols,
+					o->replay_file ? o->replay_file : "random keys" );
+	double start = now_seconds();
+	unsigned long long frames = 0;
+	if ( o->replay_file ) {
+		board_dir dir;
+		while ( ok && movelog_next( &replay, &dir ) ) {
+			ok = game_move( &g, dir ) && game_check( &g );
+		}
+		ok = ok && replay.position == replay.header.move_count;
+		movelog_close( &replay );
+	} else {
+		unsigned long long left = o->moves;
+		while ( ok && left > 0 ) {
+			ok = random_frame( &g, &in, frames * HEADLESS_FRAME_SECONDS, &left );
+			frames++;
+		}
+	}
+	double seconds = now_seconds() - start;
+
+	printf( "%llu moves, %llu solves", g.moves, g.solves );
+	if ( frames > 0 ) {
+		printf( ", %llu simulated frames (%.1f min of play)", frames,
+						frames * HEADLESS_FRAME_SECONDS / 60.0 );
+	}
+	printf( "\n%.3f s: %.2f M moves/s (%.0f M moves/min)\n", seconds, g.moves / seconds / 1e6,
+					g.moves / seconds * 60.0 / 1e6 );
+	if ( !game_free( &g ) ) {
+		fprintf( stderr, "ERROR: could not finish writing %s\n", o->record_file );
+		ok = false;
+	}
+	printf( "invariants %s\n", ok ? "held" : "FAILED" );
+	return ok ? 0 : 1;
+}
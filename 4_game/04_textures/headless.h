@@ -0,0 +1,24 @@
+/******************************************************************************\
+| Headless run of the game: no window, no GL context, so it runs on servers   |
+| without a display or GPU. Input is either a move log played back or random  |
+| arrow key presses, with undo, redo and history jumps mixed in, fed through  |
+| the same input queue the window uses, at a simulated 60 frames a second.    |
+| The game state is checked after every move and the run reports simulated   |
+| moves per second.                                                           |
+\******************************************************************************/
+#ifndef _HEADLESS_H_
+#define _HEADLESS_H_
+
+struct headless_options {
+	unsigned long long moves; // random moves to make, ignored for a replay
+	unsigned int seed;
+	int rows;
+	int cols;
+	const char *replay_file; // play this log instead of random keys
+	const char *record_file; // log the moves made, or NULL
+};
+
+/* returns the process exit code: 0 if every invariant held */
+int headless_run( const headless_options *o );
+
+#endif
@@ -0,0 +1,532 @@
+#include "hint.h"
+#include "bitboard.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define BATCH 1024					// expansions between looks at the mailbox
+#define WEIGHT_STEPS 5
+#define INFINITE_G 0x7FFFFFFF
+#define SOLVED_TILE 0xFF // published tile on the solved board
+
+// ARA* weights, times 16 so the keys stay integer
+static const int weights16[WEIGHT_STEPS] = { 48, 32, 24, 20, 16 };
+
+struct hint_node {
+	bitboard64 state;
+	int g;				// moves from the goal along the tree
+	int parent;		// one move nearer the goal, -1 for the goal
+	int heap_pos; // index in the open list, -1 if not in it
+	int closed;		// iteration the node was last expanded in
+	unsigned short h; // Manhattan distance to the player's board, kept while open
+	unsigned char blank;
+	unsigned char incons; // improved after it was expanded this iteration
+};
+
+struct hint_engine {
+	int rows;
+	int cols;
+	int n;
+	hint_options options;
+	bitboard_tables tables;
+	// the search, only ever touched by the worker thread
+	hint_node *nodes;
+	int node_count;
+	int *hash; // node index + 1, 0 for empty
+	unsigned int hash_mask;
+	int *heap;
+	int heap_count;
+	int *incons;
+	int incons_count;
+	int iteration;
+	int weight_step;
+	bitboard64 target;
+	int target_blank;
+	int target_pos[HINT_MAX_CELLS]; // slot of every tile on the player's board
+	int target_node;								// -1 until the tree reaches the board
+	unsigned int working;						// generation of the board being searched
+	double board_time;
+	bool answered;
+	bool done;
+	bool retried;
+	unsigned long long expanded;
+	// mailbox from the main thread, under 'lock'
+	std::mutex lock;
+	std::condition_variable wake;
+	int next_tiles[HINT_MAX_CELLS];
+	double next_time;
+	unsigned int posted;
+	bool quit;
+	hint_stats stats;
+	// latest answer: valid bit 51, moves 41..50, weight * 16 35..40,
+	// optimal 34, direction 32..33, tile 24..31, generation 0..23
+	std::atomic<unsigned long long> answer;
+	unsigned int requested; // main thread's copy of 'posted'
+	std::thread worker;
+};
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/*------------------------------- tree storage -------------------------------*/
+static inline unsigned int hash_of( bitboard64 state ) {
+	return (unsigned int)( ( state * 0x9E3779B97F4A7C15ULL ) >> 32 );
+}
+
+static int find_node( const hint_engine *h, bitboard64 state ) {
+	for ( unsigned int i = hash_of( state ) & h->hash_mask;; i = ( i + 1 ) & h->hash_mask ) {
+		int slot = h->hash[i];
+		if ( 0 == slot ) {
+			return -1;
+		}
+		if ( h->nodes[slot - 1].state == state ) {
+			return slot - 1;
+		}
+	}
+}
+
+/* -1 when the tree is full */
+static int add_node( hint_engine *h, bitboard64 state, int blank ) {
+	if ( h->node_count == h->options.max_nodes ) {
+		return -1;
+	}
+	unsigned int i = hash_of( state ) & h->hash_mask;
+	while ( h->hash[i] ) {
+		i = ( i + 1 ) & h->hash_mask;
+	}
+	int index = h->node_count++;
+	h->hash[i] = index + 1;
+	hint_node *x = &h->nodes[index];
+	x->state = state;
+	x->g = INFINITE_G;
+	x->parent = -1;
+	x->heap_pos = -1;
+	x->closed = 0;
+	x->h = 0;
+	x->blank = (unsigned char)blank;
+	x->incons = 0;
+	return index;
+}
+
+/*-------------------------------- open list ---------------------------------*/
+/* f = g + weight * h, ties to the deeper node */
+static inline long long key_of( const hint_engine *h, const hint_node *x ) {
+	long long f = 16LL * x->g + (long long)weights16[h->weight_step] * x->h;
+	return f * 1024 - x->g;
+}
+
+static void heap_place( hint_engine *h, int pos, int node ) {
+	h->heap[pos] = node;
+	h->nodes[node].heap_pos = pos;
+}
+
+static void heap_up( hint_engine *h, int pos ) {
+	int node = h->heap[pos];
+	long long key = key_of( h, &h->nodes[node] );
+	while ( pos > 0 ) {
+		int up = ( pos - 1 ) / 2;
+		if ( key_of( h, &h->nodes[h->heap[up]] ) <= key ) {
+			break;
+		}
+		heap_place( h, pos, h->heap[up] );
+		pos = up;
+	}
+	heap_place( h, pos, node );
+}
+
+static void heap_down( hint_engine *h, int pos ) {
+	int node = h->heap[pos];
+	long long key = key_of( h, &h->nodes[node] );
+	for ( ;; ) {
+		int child = 2 * pos + 1;
+		if ( child >= h->heap_count ) {
+			break;
+		}
+		long long child_key = key_of( h, &h->nodes[h->heap[child]] );
+		if ( child + 1 < h->heap_count ) {
+			long long right_key = key_of( h, &h->nodes[h->heap[child + 1]] );
+			if ( right_key < child_key ) {
+				child++;
+				child_key = right_key;
+			}
+		}
+		if ( key <= child_key ) {
+			break;
+		}
+		heap_place( h, pos, h->heap[child] );
+		pos = child;
+	}
+	heap_place( h, pos, node );
+}
+
+static void heap_push( hint_engine *h, int node ) {
+	if ( h->nodes[node].heap_pos >= 0 ) {
+		heap_up( h, h->nodes[node].heap_pos ); // only ever gets a smaller key
+		return;
+	}
+	heap_place( h, h->heap_count++, node );
+	heap_up( h, h->heap_count - 1 );
+}
+
+static int heap_pop( hint_engine *h ) {
+	int top = h->heap[0];
+	h->nodes[top].heap_pos = -1;
+	if ( --h->heap_count > 0 ) {
+		heap_place( h, 0, h->heap[h->heap_count] );
+		heap_down( h, 0 );
+	}
+	return top;
+}
+
+static void heapify( hint_engine *h ) {
+	for ( int pos = h->heap_count / 2 - 1; pos >= 0; pos-- ) {
+		heap_down( h, pos );
+	}
+}
+
+/*---------------------------------- search ----------------------------------*/
+static inline int slot_distance( const bitboard_tables *t, int a, int b ) {
+	return abs( t->slot_row[a] - t->slot_row[b] ) + abs( t->slot_col[a] - t->slot_col[b] );
+}
+
+/* Manhattan distance from 'state' to the player's board */
+static int heuristic( const hint_engine *h, bitboard64 state ) {
+	int sum = 0;
+	for ( int slot = 0; slot < h->n; slot++ ) {
+		int tile = bitboard64_tile( state, slot );
+		if ( tile != h->n - 1 ) {
+			sum += slot_distance( &h->tables, slot, h->target_pos[tile] );
+		}
+	}
+	return sum;
+}
+
+/* the nodes improved after their expansion go back in the open list */
+static void reopen_incons( hint_engine *h ) {
+	for ( int i = 0; i < h->incons_count; i++ ) {
+		hint_node *x = &h->nodes[h->incons[i]];
+		x->incons = 0;
+		if ( x->heap_pos < 0 ) {
+			x->h = (unsigned short)heuristic( h, x->state );
+			heap_place( h, h->heap_count++, h->incons[i] );
+		}
+	}
+	h->incons_count = 0;
+}
+
+static void reset_tree( hint_engine *h ) {
+	h->node_count = 0;
+	memset( h->hash, 0, ( h->hash_mask + 1 ) * sizeof( int ) );
+	h->heap_count = 0;
+	h->incons_count = 0;
+	h->iteration = 1;
+	int tiles[HINT_MAX_CELLS];
+	for ( int i = 0; i < h->n; i++ ) {
+		tiles[i] = i;
+	}
+	int goal = add_node( h, bitboard64_from_tiles( tiles, h->n ), h->n - 1 );
+	h->nodes[goal].g = 0;
+	h->nodes[goal].h = (unsigned short)heuristic( h, h->nodes[goal].state );
+	heap_push( h, goal );
+	h->target_node = h->target == h->nodes[goal].state ? goal : -1;
+}
+
+/* a new board for the player: same tree, open list re-keyed for it */
+static void retarget( hint_engine *h, const int *tiles ) {
+	h->target = bitboard64_from_tiles( tiles, h->n );
+	for ( int slot = 0; slot < h->n; slot++ ) {
+		h->target_pos[tiles[slot]] = slot;
+		if ( tiles[slot] == h->n - 1 ) {
+			h->target_blank = slot;
+		}
+	}
+	if ( 0 == h->node_count ) {
+		reset_tree( h );
+	}
+	h->weight_step = 0;
+	h->iteration++;
+	reopen_incons( h );
+	for ( int i = 0; i < h->heap_count; i++ ) {
+		hint_node *x = &h->nodes[h->heap[i]];
+		x->h = (unsigned short)heuristic( h, x->state );
+	}
+	heapify( h );
+	h->target_node = find_node( h, h->target );
+	h->answered = false;
+	h->done = false;
+	h->retried = false;
+}
+
+static void publish( hint_engine *h, bool optimal ) {
+	const hint_node *t = &h->nodes[h->target_node];
+	unsigned long long tile = SOLVED_TILE, dir = 0;
+	if ( t->parent >= 0 ) {
+		// the blank of the parent is where the tile comes from
+		int from = h->nodes[t->parent].blank;
+		tile = (unsigned long long)bitboard64_tile( h->target, from );
+		for ( int d = 0; d < 4; d++ ) {
+			if ( h->tables.from[h->target_blank][d] == from ) {
+				dir = (unsigned long long)d;
+			}
+		}
+	}
+	unsigned long long moves = (unsigned long long)( t->g < 1023 ? t->g : 1023 );
+	unsigned long long packed = ( 1ULL << 51 ) | ( moves << 41 ) |
+															( (unsigned long long)weights16[h->weight_step] << 35 ) |
+															( (unsigned long long)optimal << 34 ) | ( dir << 32 ) | ( tile << 24 ) |
+															( h->working & 0xFFFFFF );
+	if ( packed == h->answer.load( std::memory_order_relaxed ) ) {
+		return;
+	}
+	h->answer.store( packed, std::memory_order_release );
+	double latency = now_seconds() - h->board_time;
+	std::lock_guard<std::mutex> guard( h->lock );
+	if ( !h->answered ) {
+		h->answered = true;
+		h->stats.answered++;
+		h->stats.first_answer_seconds_sum += latency;
+		if ( latency > h->stats.first_answer_seconds_max ) {
+			h->stats.first_answer_seconds_max = latency;
+		}
+	}
+	if ( optimal ) {
+		h->stats.optimal++;
+		h->stats.optimal_seconds_sum += latency;
+	}
+}
+
+/* expands node 's'. false if the tree filled up */
+static bool expand( hint_engine *h, int s ) {
+	hint_node *x = &h->nodes[s];
+	x->closed = h->iteration;
+	h->expanded++;
+	for ( int d = 0; d < 4; d++ ) {
+		int from = h->tables.from[x->blank][d];
+		if ( from == x->blank ) {
+			continue;
+		}
+		bitboard64 state = bitboard64_move( x->state, h->n, x->blank, from );
+		int c = find_node( h, state );
+		if ( c < 0 && ( c = add_node( h, state, from ) ) < 0 ) {
+			return false;
+		}
+		hint_node *child = &h->nodes[c];
+		if ( child->g <= x->g + 1 ) {
+			continue;
+		}
+		child->g = x->g + 1;
+		child->parent = s;
+		if ( child->closed == h->iteration ) {
+			// ARA*: not expanded again this iteration, but in the next one
+			if ( !child->incons ) {
+				child->incons = 1;
+				h->incons[h->incons_count++] = c;
+			}
+			continue;
+		}
+		if ( child->heap_pos < 0 ) {
+			// the tile in 'from' slides into x's blank
+			int tile = bitboard64_tile( x->state, from );
+			child->h = (unsigned short)( x->h - slot_distance( &h->tables, from, h->target_pos[tile] ) +
+																	 slot_distance( &h->tables, x->blank, h->target_pos[tile] ) );
+		}
+		heap_push( h, c );
+		if ( state == h->target ) {
+			h->target_node = c;
+		}
+	}
+	return true;
+}
+
+/* up to BATCH expansions of the current weight, moving on to the next
+weight whenever the player's board is settled for this one */
+static void search_batch( hint_engine *h ) {
+	for ( int i = 0; i < BATCH && !h->done; i++ ) {
+		bool settled = 0 == h->heap_count;
+		if ( h->target_node >= 0 && !settled ) {
+			const hint_node *top = &h->nodes[h->heap[0]];
+			long long f_min = 16LL * top->g + (long long)weights16[h->weight_step] * top->h;
+			settled = 16LL * h->nodes[h->target_node].g <= f_min;
+		}
+		if ( settled ) {
+			bool last = WEIGHT_STEPS - 1 == h->weight_step || 0 == h->heap_count;
+			if ( h->target_node >= 0 ) {
+				publish( h, last && 16 == weights16[h->weight_step] );
+			}
+			if ( last ) {
+				h->done = true;
+				break;
+			}
+			h->weight_step++;
+			h->iteration++;
+			reopen_incons( h );
+			heapify( h );
+			continue;
+		}
+		if ( !expand( h, heap_pop( h ) ) ) {
+			// full. start over once from this board, with the tree all its own
+			if ( h->retried || h->answered ) {
+				h->done = true;
+				break;
+			}
+			h->retried = true;
+			h->stats.resets++;
+			reset_tree( h );
+			h->weight_step = 0;
+		}
+	}
+	if ( h->target_node >= 0 && !h->done ) {
+		publish( h, false );
+	}
+	std::lock_guard<std::mutex> guard( h->lock );
+	h->stats.nodes = (unsigned long long)h->node_count;
+	h->stats.expanded = h->expanded;
+}
+
+static void worker_main( hint_engine *h ) {
+	for ( ;; ) {
+		bool fresh = false;
+		int tiles[HINT_MAX_CELLS];
+		{
+			std::unique_lock<std::mutex> guard( h->lock );
+			while ( !h->quit && h->posted == h->working && ( h->done || 0 == h->working ) ) {
+				h->wake.wait( guard );
+			}
+			if ( h->quit ) {
+				return;
+			}
+			if ( h->posted != h->working ) {
+				memcpy( tiles, h->next_tiles, h->n * sizeof( int ) );
+				h->working = h->posted;
+				h->board_time = h->next_time;
+				h->stats.boards++;
+				fresh = true;
+			}
+		}
+		if ( fresh ) {
+			retarget( h, tiles );
+		}
+		if ( now_seconds() - h->board_time > h->options.think_seconds ) {
+			h->done = true;
+			continue;
+		}
+		search_batch( h );
+	}
+}
+
+/*----------------------------------- API ------------------------------------*/
+hint_engine *hint_engine_create( int rows, int cols, const hint_options *options ) {
+	if ( rows * cols > HINT_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: hints only work on boards up to %i cells\n", HINT_MAX_CELLS );
+		return NULL;
+	}
+	hint_engine *h = new hint_engine;
+	h->rows = rows;
+	h->cols = cols;
+	h->n = rows * cols;
+	h->options.think_seconds = HINT_THINK_SECONDS;
+	h->options.max_nodes = HINT_MAX_NODES;
+	if ( options ) {
+		h->options = *options;
+	}
+	unsigned int hash_size = 1;
+	while ( hash_size < 2u * (unsigned int)h->options.max_nodes ) {
+		hash_size *= 2;
+	}
+	h->hash_mask = hash_size - 1;
+	h->nodes = (hint_node *)malloc( h->options.max_nodes * sizeof( hint_node ) );
+	h->hash = (int *)malloc( hash_size * sizeof( int ) );
+	h->heap = (int *)malloc( h->options.max_nodes * sizeof( int ) );
+	h->incons = (int *)malloc( h->options.max_nodes * sizeof( int ) );
+	if ( !bitboard_tables_init( &h->tables, rows, cols ) || !h->nodes || !h->hash || !h->heap ||
+			 !h->incons ) {
+		fprintf( stderr, "ERROR: could not allocate the hint search for %i nodes\n",
+						 h->options.max_nodes );
+		free( h->nodes );
+		free( h->hash );
+		free( h->heap );
+		free( h->incons );
+		delete h;
+		return NULL;
+	}
+	h->node_count = 0;
+	h->heap_count = 0;
+	h->incons_count = 0;
+	h->iteration = 0;
+	h->weight_step = 0;
+	h->target = 0;
+	h->target_blank = 0;
+	h->target_node = -1;
+	h->working = 0;
+	h->board_time = 0.0;
+	h->answered = false;
+	h->done = false;
+	h->retried = false;
+	h->expanded = 0;
+	h->next_time = 0.0;
+	h->posted = 0;
+	h->quit = false;
+	memset( &h->stats, 0, sizeof( h->stats ) );
+	h->answer.store( 0 );
+	h->requested = 0;
+	h->worker = std::thread( worker_main, h );
+	return h;
+}
+
+void hint_engine_destroy( hint_engine *h ) {
+	{
+		std::lock_guard<std::mutex> guard( h->lock );
+		h->quit = true;
+	}
+	h->wake.notify_one();
+	h->worker.join();
+	free( h->nodes );
+	free( h->hash );
+	free( h->heap );
+	free( h->incons );
+	delete h;
+}
+
+void hint_engine_set_board( hint_engine *h, const board *b ) {
+	{
+		std::lock_guard<std::mutex> guard( h->lock );
+		memcpy( h->next_tiles, b->tiles, h->n * sizeof( int ) );
+		h->next_time = now_seconds();
+		// 0 means no board yet, and only 24 bits are published
+		h->posted = ( h->posted + 1 ) & 0xFFFFFF;
+		if ( 0 == h->posted ) {
+			h->posted = 1;
+		}
+		h->requested = h->posted;
+	}
+	h->wake.notify_one();
+}
+
+bool hint_engine_read( const hint_engine *h, hint *out ) {
+	unsigned long long packed = h->answer.load( std::memory_order_acquire );
+	if ( 0 == ( ( packed >> 51 ) & 1 ) || ( packed & 0xFFFFFF ) != h->requested ) {
+		return false;
+	}
+	int tile = (int)( ( packed >> 24 ) & 0xFF );
+	if ( SOLVED_TILE == tile ) {
+		return false;
+	}
+	out->tile = tile;
+	out->dir = (board_dir)( ( packed >> 32 ) & 3 );
+	out->optimal = 0 != ( ( packed >> 34 ) & 1 );
+	out->weight = (float)( ( packed >> 35 ) & 63 ) / 16.0f;
+	out->moves = (int)( ( packed >> 41 ) & 1023 );
+	return true;
+}
+
+void hint_engine_stats( hint_engine *h, hint_stats *stats ) {
+	std::lock_guard<std::mutex> guard( h->lock );
+	*stats = h->stats;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************\
+| Anytime hint engine: the best next move for the board the player is on.     |
+| An ARA* search (weighted A* with the weight lowered 3 -> 2 -> 1.5 -> 1.25   |
+| -> 1 as time allows, re-using the tree between weights) runs on its own     |
+| thread. It searches *back from the goal* towards the player's board, so a  |
+| node's g is its distance from the goal whatever board the player is on:   |
+| when the player moves, only the heuristic changes -- the open list is re-  |
+| keyed and the tree carries on. The hint is the move from the player's board |
+| to its parent in the tree, and after following one the next board is      |
+| usually in the tree already.                                               |
+| Answers are published as one 64 bit atomic word, so the render loop reads  |
+| the latest one with a single load and never waits on the search.           |
+| Boards up to 16 cells (the search uses bitboard64 states).                 |
+\******************************************************************************/
+#ifndef _HINT_H_
+#define _HINT_H_
+
+#include "board.h"
+
+#define HINT_MAX_CELLS 16
+#define HINT_THINK_SECONDS 5.0 // per board, then the thread sleeps
+#define HINT_MAX_NODES ( 1 << 20 ) // the tree starts over when it fills
+
+struct hint_engine;
+
+struct hint_options {
+	double think_seconds; // give up refining a board after this long
+	int max_nodes;
+};
+
+struct hint {
+	int tile;			 // tile id to slide
+	board_dir dir; // the way it slides
+	int moves;		 // length of the plan the move is on
+	float weight;	 // the plan is at most weight times longer than optimal
+	bool optimal;	 // weight 1 finished: 'moves' is the exact distance
+};
+
+struct hint_stats {
+	unsigned long long boards;			 // boards handed to the engine
+	unsigned long long answered;		 // of those, ones with an answer
+	unsigned long long optimal;			 // and ones proven optimal
+	double first_answer_seconds_sum; // from hint_engine_set_board() to the first answer
+	double first_answer_seconds_max;
+	double optimal_seconds_sum; // to the optimal answer
+	unsigned long long nodes;		// in the tree now
+	unsigned long long expanded; // over all boards
+	int resets;									 // times the tree filled up and started over
+};
+
+/* starts the search thread for rows x cols boards, idle until the first
+board. 'options' may be NULL for the defaults. NULL if the board is too big */
+hint_engine *hint_engine_create( int rows, int cols, const hint_options *options );
+
+void hint_engine_destroy( hint_engine *h );
+
+/* the board the player is on now. returns at once: the search picks it up
+between node batches */
+void hint_engine_set_board( hint_engine *h, const board *b );
+
+/* the latest answer for the last board set, a single atomic load. false
+until there is one, and on a solved board */
+bool hint_engine_read( const hint_engine *h, hint *out );
+
+void hint_engine_stats( hint_engine *h, hint_stats *stats );
+
+#endif
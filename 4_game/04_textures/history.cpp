@@ -0,0 +1,134 @@
+#include "history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char *keyframe( const history *h, unsigned long long k ) {
+	return h->keyframes + k * h->n;
+}
+
+bool history_init( history *h, const board *start ) {
+	memset( h, 0, sizeof( history ) );
+	h->rows = start->rows;
+	h->cols = start->cols;
+	h->n = start->n;
+	h->capacity = HISTORY_INITIAL_MOVES;
+	h->moves = (unsigned char *)calloc( h->capacity / 4, 1 );
+	h->keyframes = (unsigned char *)malloc( ( h->capacity / HISTORY_KEYFRAME_INTERVAL + 1 ) * h->n );
+	if ( !h->moves || !h->keyframes ) {
+		fprintf( stderr, "ERROR: could not allocate the move history\n" );
+		history_free( h );
+		return false;
+	}
+	for ( int slot = 0; slot < h->n; slot++ ) {
+		h->keyframes[slot] = (unsigned char)start->tiles[slot];
+	}
+	return true;
+}
+
+void history_free( history *h ) {
+	free( h->moves );
+	free( h->keyframes );
+	h->moves = NULL;
+	h->keyframes = NULL;
+}
+
+/* doubles both arenas */
+static bool grow( history *h ) {
+	unsigned long long capacity = h->capacity * 2;
+	unsigned char *moves = (unsigned char *)realloc( h->moves, capacity / 4 );
+	if ( !moves ) {
+		return false;
+	}
+	h->moves = moves;
+	unsigned char *keyframes =
+		(unsigned char *)realloc( h->keyframes, ( capacity / HISTORY_KEYFRAME_INTERVAL + 1 ) * h->n );
+	if ( !keyframes ) {
+		return false;
+	}
+	h->keyframes = keyframes;
+	h->capacity = capacity;
+	return true;
+}
+
+bool history_reserve( history *h, unsigned long long moves ) {
+	while ( h->capacity <= moves ) {
+		if ( !grow( h ) ) {
+			fprintf( stderr, "ERROR: could not grow the move history to %llu moves\n", moves );
+			return false;
+		}
+	}
+	return true;
+}
+
+bool history_push( history *h, board_dir dir, const board *b ) {
+	if ( h->position == h->capacity && !grow( h ) ) {
+		fprintf( stderr, "ERROR: could not grow the move history past %llu moves\n", h->capacity );
+		return false;
+	}
+	if ( h->position < h->clean ) {
+		h->clean = h->position;
+	}
+	unsigned char *byte = &h->moves[h->position >> 2];
+	int shift = 2 * (int)( h->position & 3 );
+	*byte = (unsigned char)( ( *byte & ~( 3 << shift ) ) | ( (int)dir << shift ) );
+	h->position++;
+	h->length = h->position;
+	if ( 0 == h->position % HISTORY_KEYFRAME_INTERVAL ) {
+		unsigned char *k = keyframe( h, h->position / HISTORY_KEYFRAME_INTERVAL );
+		for ( int slot = 0; slot < h->n; slot++ ) {
+			k[slot] = (unsigned char)b->tiles[slot];
+		}
+	}
+	return true;
+}
+
+bool history_undo( history *h, board_dir *dir ) {
+	if ( 0 == h->position ) {
+		return false;
+	}
+	h->position--;
+	// UP and DOWN, LEFT and RIGHT differ in the low bit
+	*dir = (board_dir)( history_move( h, h->position ) ^ 1 );
+	return true;
+}
+
+bool history_redo( history *h, board_dir *dir ) {
+	if ( h->position == h->length ) {
+		return false;
+	}
+	*dir = history_move( h, h->position );
+	h->position++;
+	return true;
+}
+
+bool history_seek( history *h, unsigned long long position, int *tiles ) {
+	if ( position > h->length ) {
+		return false;
+	}
+	unsigned long long first = position - position % HISTORY_KEYFRAME_INTERVAL;
+	const unsigned char *k = keyframe( h, first / HISTORY_KEYFRAME_INTERVAL );
+	int blank = 0;
+	for ( int slot = 0; slot < h->n; slot++ ) {
+		tiles[slot] = k[slot];
+		if ( tiles[slot] == h->n - 1 ) {
+			blank = slot;
+		}
+	}
+	// the moves since the keyframe were all legal when they were played. the
+	// tile that slides UP into the blank is the one below it, etc.
+	int offset[4] = { h->cols, -h->cols, 1, -1 };
+	for ( unsigned long long i = first; i < position; i++ ) {
+		board_dir dir = history_move( h, i );
+		int from = blank + offset[dir];
+		// a sideways move off the end of a row would wrap into the next one
+		if ( from < 0 || from >= h->n || ( dir >= BOARD_LEFT && from / h->cols != blank / h->cols ) ) {
+			return false;
+		}
+		tiles[blank] = tiles[from];
+		tiles[from] = h->n - 1;
+		blank = from;
+	}
+	h->position = position;
+	return true;
+}
@@ -0,0 +1,60 @@
+/******************************************************************************\
+| Unlimited undo and redo.                                                    |
+| Every move is kept as its 2 bit board_dir, four to a byte; undoing one plays |
+| the opposite direction, so stepping back or forward is O(1) and never looks |
+| at the board. Every HISTORY_KEYFRAME_INTERVAL moves the board is copied, one |
+| byte per slot, so any position -- a snapshot is just a move number -- is    |
+| one keyframe copy plus at most interval - 1 moves away, however far back it |
+| is. Moves and keyframes live in two arenas that double when full: nothing is |
+| allocated per move, and a new move after undoing drops the redo tail by     |
+| writing over it.                                                            |
+\******************************************************************************/
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include "board.h"
+
+#define HISTORY_KEYFRAME_INTERVAL 64 // a multiple of 4
+#define HISTORY_INITIAL_MOVES 4096
+
+struct history {
+	int rows;
+	int cols;
+	int n;
+	unsigned char *moves;				 // 2 bits a move
+	unsigned char *keyframes;		 // n bytes each, the board after k * interval moves
+	unsigned long long capacity; // moves the arenas have room for
+	unsigned long long length;	 // moves kept, the redo tail included
+	unsigned long long position; // moves played. length - position can be redone
+	unsigned long long clean;		 // moves before this one unchanged since the save set it
+};
+
+/* an empty history starting from board 'start' */
+bool history_init( history *h, const board *start );
+
+void history_free( history *h );
+
+/* makes room for 'moves' moves, for filling the arenas in from a save */
+bool history_reserve( history *h, unsigned long long moves );
+
+/* records 'dir', just played on 'b', dropping anything there was to redo.
+false if the arenas could not grow */
+bool history_push( history *h, board_dir dir, const board *b );
+
+/* move number 'i' (0 is the first), as it was played */
+inline board_dir history_move( const history *h, unsigned long long i ) {
+	return (board_dir)( ( h->moves[i >> 2] >> ( 2 * ( i & 3 ) ) ) & 3 );
+}
+
+/* the move that takes back the last one played. false at the start */
+bool history_undo( history *h, board_dir *dir );
+
+/* the move that was taken back last. false if there is none */
+bool history_redo( history *h, board_dir *dir );
+
+/* goes to move number 'position' (0 to h->length), writing the board there
+into 'tiles'. false, changing nothing, if it is past the end or the moves
+run off the board (a history read back from a damaged save) */
+bool history_seek( history *h, unsigned long long position, int *tiles );
+
+#endif
@@ -0,0 +1,97 @@
+#include "input.h"
+
+bool input_queue_push( input_queue *q, const input_event *ev ) {
+	unsigned int tail = q->tail.load( std::memory_order_relaxed );
+	if ( tail - q->head.load( std::memory_order_acquire ) == INPUT_QUEUE_SIZE ) {
+		return false;
+	}
+	q->events[tail & ( INPUT_QUEUE_SIZE - 1 )] = *ev;
+	// publish the event before the consumer can see the new tail
+	q->tail.store( tail + 1, std::memory_order_release );
+	return true;
+}
+
+bool input_queue_pop( input_queue *q, input_event *ev ) {
+	unsigned int head = q->head.load( std::memory_order_relaxed );
+	if ( head == q->tail.load( std::memory_order_acquire ) ) {
+		return false;
+	}
+	*ev = q->events[head & ( INPUT_QUEUE_SIZE - 1 )];
+	q->head.store( head + 1, std::memory_order_release );
+	return true;
+}
+
+static void key_callback( GLFWwindow *window, int key, int scancode, int action, int mods ) {
+	// O/S repeats are dropped, input_poll() times its own
+	if ( GLFW_REPEAT == action || GLFW_KEY_UNKNOWN == key ) {
+		return;
+	}
+	input *in = (input *)glfwGetWindowUserPointer( window );
+	input_event ev;
+	ev.key = key;
+	ev.action = action;
+	ev.time = glfwGetTime();
+	if ( !input_queue_push( &in->queue, &ev ) ) {
+		in->dropped++;
+	}
+}
+
+void input_reset( input *in ) {
+	in->queue.head = 0;
+	in->queue.tail = 0;
+	in->held_key = 0;
+	in->next_repeat = 0.0;
+	in->first_press = -1.0;
+	in->dropped = 0;
+}
+
+void input_init( input *in, GLFWwindow *window ) {
+	input_reset( in );
+	glfwSetWindowUserPointer( window, in );
+	glfwSetKeyCallback( window, key_callback );
+}
+
+/* the held key's repeat, if one is due by 'time'. the next is an interval
+after it, or after 'time' if that is already past: a late poll never
+catches up in a burst of moves */
+static bool repeat_due( input *in, double time ) {
+	if ( !in->held_key || in->next_repeat > time ) {
+		return false;
+	}
+	in->next_repeat += INPUT_REPEAT_INTERVAL;
+	if ( in->next_repeat <= time ) {
+		in->next_repeat = time + INPUT_REPEAT_INTERVAL;
+	}
+	return true;
+}
+
+int input_poll( input *in, double now, int *keys, int max_keys ) {
+	int count = 0;
+	bool repeated = false; // one repeat per frame at most
+	input_event ev;
+	in->first_press = -1.0;
+	while ( count < max_keys && input_queue_pop( &in->queue, &ev ) ) {
+		// a repeat of the held key that was due before this event comes first,
+		// leaving room for the event itself
+		if ( !repeated && count < max_keys - 1 && repeat_due( in, ev.time ) ) {
+			keys[count++] = in->held_key;
+			repeated = true;
+		}
+		if ( GLFW_PRESS == ev.action ) {
+			keys[count++] = ev.key;
+			if ( in->first_press < 0.0 ) {
+				in->first_press = ev.time;
+			}
+			// the latest key pressed is the one that repeats
+			in->held_key = ev.key;
+			in->next_repeat = ev.time + INPUT_REPEAT_DELAY;
+		} else if ( ev.key == in->held_key ) {
+			in->held_key = 0;
+		}
+	}
+	// after a stall carry on from now rather than catching up
+	if ( !repeated && count < max_keys && repeat_due( in, now ) ) {
+		keys[count++] = in->held_key;
+	}
+	return count;
+}
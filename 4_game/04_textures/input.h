@@ -0,0 +1,63 @@
+/******************************************************************************\
+| Keyboard input without blocking the render loop.                             |
+| GLFW's key callback only timestamps the event and pushes it into a           |
+| single-producer single-consumer ring buffer; the frame drains it at the     |
+| start of the loop, so no key press is lost however long a frame takes and    |
+| the loop never has to sleep to debounce. Held keys repeat on our own clock  |
+| (a delay, then a fixed interval) instead of the O/S auto-repeat, which has   |
+| a different rate on every platform and does not exist on some.              |
+\******************************************************************************/
+#ifndef _INPUT_H_
+#define _INPUT_H_
+
+#include <GLFW/glfw3.h>
+#include <atomic>
+
+// power of two, so the ring indices just wrap
+#define INPUT_QUEUE_SIZE 256
+#define INPUT_REPEAT_DELAY 0.25		// seconds before a held key starts repeating
+#define INPUT_REPEAT_INTERVAL 0.06 // seconds between repeats after that
+
+struct input_event {
+	int key;		 // GLFW_KEY_*
+	int action;	 // GLFW_PRESS or GLFW_RELEASE
+	double time; // glfwGetTime() when it happened
+};
+
+struct input_queue {
+	input_event events[INPUT_QUEUE_SIZE];
+	std::atomic<unsigned int> head; // next to pop, only the consumer writes it
+	std::atomic<unsigned int> tail; // next to push, only the producer writes it
+};
+
+struct input {
+	input_queue queue;
+	int held_key; // key repeating right now, 0 for none
+	double next_repeat;
+	double first_press; // time of the first press the last poll returned, -1 for none
+	unsigned int dropped; // events lost to a full queue
+};
+
+/* false if the queue is full */
+bool input_queue_push( input_queue *q, const input_event *ev );
+
+/* false if the queue is empty */
+bool input_queue_pop( input_queue *q, input_event *ev );
+
+/* events that can be pushed before the queue is full */
+inline int input_queue_room( const input_queue *q ) {
+	return INPUT_QUEUE_SIZE - (int)( q->tail.load( std::memory_order_relaxed ) -
+																	 q->head.load( std::memory_order_acquire ) );
+}
+
+/* empties the queue and forgets any held key */
+void input_reset( input *in );
+
+/* installs the key callback on 'window'. 'in' must outlive the window */
+void input_init( input *in, GLFWwindow *window );
+
+/* drains the events queued up to 'now' and returns the key presses, and at
+most one repeat of a held key, in the order they happened. at most 'max_keys' */
+int input_poll( input *in, double now, int *keys, int max_keys );
+
+#endif
@@ -2,6 +2,20 @@
 //#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "gl_utils.h"
+#include "autoplay.h"
+#include "board_renderer.h"
+#include "frame_stats.h"
+#include "game.h"
+#include "headless.h"
+#include "hint.h"
+#include "input.h"
+#include "positions.h"
+#include "redraw.h"
+#include "save.h"
+#include "scramble.h"
+#include "tile_atlas.h"
+#include "video_texture.h"
+#include "virtual_texture.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <assert.h>
@@ -13,13 +27,213 @@
 #include <time.h>
 #define GL_LOG_FILE "gl.log"
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 int g_gl_width = 640;
 int g_gl_height = 480;
 GLFWwindow *g_window = NULL;
 
-int main() {
+/* shows how far the board is from solved, and the move that gets closer, in
+the window title. both are a lookup in the distance table */
+static void update_title( const distance_table *dist, const board *b ) {
+	static const char *dir_names[] = { "up", "down", "left", "right" };
+	char title[256];
+	board_dir best;
+	if ( distance_table_best_move( dist, b, &best ) ) {
+		sprintf( title, "Texture Mapping - %i moves to go, try %s",
+						 distance_table_lookup( dist, b->tiles ), dir_names[best] );
+	} else {
+		sprintf( title, "Texture Mapping - solved" );
+	}
+	glfwSetWindowTitle( g_window, title );
+}
+
+/* how long the hints took to come, then stops the hint thread */
+static void finish_hints( hint_engine *hints ) {
+	if ( !hints ) {
+		return;
+	}
+	hint_stats stats;
+	hint_engine_stats( hints, &stats );
+	if ( stats.answered > 0 ) {
+		printf( "hints: %llu boards, first answer %.2f ms mean %.2f ms max, %llu proven optimal in "
+						"%.2f ms mean\n",
+						stats.boards, 1000.0 * stats.first_answer_seconds_sum / stats.answered,
+						1000.0 * stats.first_answer_seconds_max, stats.optimal,
+						stats.optimal > 0 ? 1000.0 * stats.optimal_seconds_sum / stats.optimal : 0.0 );
+	}
+	hint_engine_destroy( hints );
+}
+
+/* how hard the page cache worked, then frees it */
+static void finish_virtual_texture( virtual_texture *vt ) {
+	if ( !vt ) {
+		return;
+	}
+	virtual_texture_stats stats;
+	virtual_texture_get_stats( vt, &stats );
+	printf( "virtual texture: %i pages resident, %llu uploaded, %llu evicted, %llu dropped\n",
+					stats.resident, stats.uploaded, stats.evicted, stats.dropped );
+	virtual_texture_close( vt );
+}
+
+/* frames shown and dropped and the upload rate of the video, then frees it */
+static void finish_video( video_texture *video ) {
+	if ( !video ) {
+		return;
+	}
+	video_stats stats;
+	video_texture_get_stats( video, &stats );
+	printf( "video: %llu frames shown, %llu dropped, %.1f MB/s uploaded, %.2f ms/frame converting\n",
+					stats.shown, stats.dropped,
+					stats.play_seconds > 0.0 ? stats.uploaded / stats.play_seconds / 1e6 : 0.0,
+					stats.decoded > 0 ? 1000.0 * stats.decode_seconds / stats.decoded : 0.0 );
+	video_texture_close( video );
+}
+
+/* sustained moves/s from the first autoplay move to the last one played, and
+the frame times while they ran */
+static void finish_autoplay( autoplay *bot, unsigned long long moves, double last_move_time,
+														 const frame_stats *frames ) {
+	double seconds = last_move_time - bot->start_time;
+	printf( "autoplay: %llu moves, %llu solves in %.3f s: %.1f moves/s", moves, bot->solves, seconds,
+					seconds > 0.0 ? moves / seconds : 0.0 );
+	if ( !bot->dist ) {
+		// on the planner's thread: the frames went on meanwhile
+		printf( ", %.3f s planning (not in the frame times)", bot->plan_seconds );
+	}
+	printf( "\n" );
+	frame_stats_print( frames, "autoplay frames" );
+	autoplay_free( bot );
+}
+
+/* game options from the command line:
+	--record <file>         log every move of the game
+	--replay <file> [rate]  play a log back, 'rate' moves per frame (default 1) as
+	                        fast as the frames go, then print the timings
+	--from <move>           start the replay at this move
+	--autoplay [rate] [n]   the computer solves the board, 'rate' moves a second
+	                        (default 4, 0 for as fast as the frames go). with
+	                        'n' it goes on walking away and solving again for
+	                        n moves. prints moves/s and frame times
+	--headless [moves]      no window: random key presses (10 million moves by
+	                        default) or the --replay log, checking the game
+	                        state after every move
+	--band <band>           difficulty of the start layout: any, easy, medium
+	                        or hard by optimal distance (default medium)
+	--positions <file> [i]  start from position i of a hardest_build file, a
+	                        random one of them without 'i'
+	--seed <n>              random seed for --headless and the start layout,
+	                        which is different every run without it
+	--new                   start a new game instead of the one saved in
+	                        puzzle.save. a game played by hand is saved there
+	                        as it goes and picked up again on the next run
+	--image <file>          the picture to cut into tiles (default cat.jpg), any
+	                        image stb_image reads
+	--virtual <file>        the picture is a vt_build virtual texture instead,
+	                        paged in as the board needs it, for pictures far
+	                        too big for one texture
+	--video <file>          the picture is an uncompressed y4m video, played at
+	                        its own frame rate. prints frames shown and
+	                        dropped and the upload rate
+	--continuous            draw every frame, as before, instead of only when
+	                        the picture changes. either way CPU use and key
+	                        to screen times are printed at the end */
+int main( int argc, char **argv ) {
+	const char *record_file = NULL;
+	const char *replay_file = NULL;
+	int replay_rate = 1;
+	unsigned long long replay_from = 0;
+	bool autoplay_on = false;
+	double autoplay_rate = AUTOPLAY_RATE;
+	unsigned long long autoplay_moves = 0;
+	bool headless = false;
+	headless_options headless_opts = { 10000000ULL, 1, 3, 3, NULL, NULL };
+	scramble_band band = SCRAMBLE_MEDIUM;
+	const char *positions_file = NULL;
+	long long position_index = -1;
+	unsigned long long start_seed = (unsigned long long)time( NULL );
+	bool new_game = false;
+	const char *image_file = "cat.jpg";
+	const char *virtual_file = NULL;
+	const char *video_file = NULL;
+	bool continuous = false;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp( argv[i], "--headless" ) ) {
+			headless = true;
+			if ( i + 1 < argc && argv[i + 1][0] != '-' ) {
+				headless_opts.moves = strtoull( argv[++i], NULL, 10 );
+			}
+		} else if ( 0 == strcmp( argv[i], "--seed" ) && i + 1 < argc ) {
+			headless_opts.seed = (unsigned int)strtoul( argv[++i], NULL, 10 );
+			start_seed = headless_opts.seed;
+		} else if ( 0 == strcmp( argv[i], "--band" ) && i + 1 < argc &&
+								scramble_band_from_name( argv[i + 1], &band ) ) {
+			i++;
+		} else if ( 0 == strcmp( argv[i], "--positions" ) && i + 1 < argc ) {
+			positions_file = argv[++i];
+			if ( i + 1 < argc && argv[i + 1][0] != '-' ) {
+				position_index = strtoll( argv[++i], NULL, 10 );
+			}
+		} else if ( 0 == strcmp( argv[i], "--new" ) ) {
+			new_game = true;
+		} else if ( 0 == strcmp( argv[i], "--image" ) && i + 1 < argc ) {
+			image_file = argv[++i];
+		} else if ( 0 == strcmp( argv[i], "--virtual" ) && i + 1 < argc ) {
+			virtual_file = argv[++i];
+		} else if ( 0 == strcmp( argv[i], "--video" ) && i + 1 < argc ) {
+			video_file = argv[++i];
+		} else if ( 0 == strcmp( argv[i], "--continuous" ) ) {
+			continuous = true;
+		} else if ( 0 == strcmp( argv[i], "--record" ) && i + 1 < argc ) {
+			record_file = argv[++i];
+		} else if ( 0 == strcmp( argv[i], "--replay" ) && i + 1 < argc ) {
+			replay_file = argv[++i];
+			if ( i + 1 < argc && argv[i + 1][0] != '-' ) {
+				replay_rate = atoi( argv[++i] ) > 0 ? atoi( argv[i] ) : 1;
+			}
+		} else if ( 0 == strcmp( argv[i], "--autoplay" ) ) {
+			autoplay_on = true;
+			if ( i + 1 < argc && argv[i + 1][0] != '-' ) {
+				autoplay_rate = atof( argv[++i] );
+			}
+			if ( i + 1 < argc && argv[i + 1][0] != '-' ) {
+				autoplay_moves = strtoull( argv[++i], NULL, 10 );
+			}
+		} else if ( 0 == strcmp( argv[i], "--from" ) && i + 1 < argc ) {
+			replay_from = strtoull( argv[++i], NULL, 10 );
+		} else {
+			fprintf( stderr, "usage: %s [--record file] [--replay file [moves per frame]] "
+											 "[--from move] [--autoplay [moves/s] [moves]] [--headless [moves]] "
+											 "[--band any|easy|medium|hard] "
+											 "[--positions file [index]] [--seed n] [--new] [--image file] "
+											 "[--virtual file] [--video file] [--continuous]\n",
+							 argv[0] );
+			return 1;
+		}
+	}
+	if ( virtual_file && video_file ) {
+		fprintf( stderr, "ERROR: the picture is either --virtual or --video, not both\n" );
+		return 1;
+	}
+	if ( autoplay_on && ( replay_file || headless ) ) {
+		fprintf( stderr, "ERROR: --autoplay plays in the window, not with --replay or --headless\n" );
+		return 1;
+	}
+	if ( headless ) {
+		// before anything touches GLFW, so no display is needed
+		headless_opts.replay_file = replay_file;
+		headless_opts.record_file = record_file;
+		return headless_run( &headless_opts );
+	}
+	movelog_reader replay;
+	if ( replay_file && ( !movelog_open( &replay, replay_file ) ||
+												!movelog_seek( &replay, replay_from ) ) ) {
+		return 1;
+	}
+
 	restart_gl_log();
 	// all the GLFW and GLEW start-up code is moved to here in gl_utils.cpp
 	start_gl("Texture Mapping");
@@ -30,173 +244,100 @@ int main() {
 	/* OTHER STUFF GOES HERE NEXT */
 
 
-	// set up vertex data (and buffer(s)) and configure vertex attributes
+	// set up the board model. the renderer draws it straight from the tile ids
 	// ------------------------------------------------------------------
-	/*
-	float vertices[] = {
-		// positions				// colors           // texture coords
-		//1
-		-0.9f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,	// top left
-		-0.3f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.0f,	// top right
-		-0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.3f, // bottom right
-		-0.9f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.3f,	// bottom left
-															//2
-		-0.3f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.0f,	// top left
-		0.3f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.0f,	// top right
-		0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.3f, // bottom right
-		-0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.3f,	// bottom left
-															//3
-		0.3f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.0f,	// top left
-		0.9f, 0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.9f, 0.0f,	// top right
-		0.9f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.9f, 0.3f, // bottom right
-		0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.3f,	// bottom left
-														//4
-		-0.9f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.3f,	// top left
-		-0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.3f,	// top right
-		-0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.6f, // bottom right
-		-0.9f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.6f,	// bottom left
-															//5
-		-0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.3f,	// top left
-		0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.3f,	// top right
-		0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.6f, // bottom right
-		-0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.6f,	// bottom left
-															//6
-		0.3f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.3f,	// top left
-		0.9f, 0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.9f, 0.3f,	// top right
-		0.9f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.9f, 0.6f, // bottom right
-		0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.6f,	// bottom left
-															//7
-		-0.9f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.6f,	// top left
-		-0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.6f,	// top right
-		-0.3f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.9f, // bottom right
-		-0.9f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.9f,	// bottom left
-															//8
-		-0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.6f,	// top left
-		0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.6f,	// top right
-		0.3f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.6f, 0.9f, // bottom right
-		-0.3f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.3f, 0.9f,	// bottom left
-															//9
-		0.3f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,	// top left
-		0.9f, -0.3f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,	// top right
-		0.9f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // bottom right
-		0.3f, -0.9f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f	// bottom left
-	};
-	*/
-
-	float vertices[] = {
-		// positions				// colors           // texture coords
-		//3
-   /*0*/-0.9f, 0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.6f, 0.0f,	// top left
-		-0.3f,  0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.9f, 0.0f,	// top right
-		-0.3f,  0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.9f, 0.3f, // bottom right
-		-0.9f,  0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.6f, 0.3f,	// bottom left
-		//4
-  /*32*/-0.3f,  0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.0f, 0.3f,	// top left
-		0.3f,   0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.3f, 0.3f,	// top right
-		0.3f,   0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.3f, 0.6f, // bottom right
-		-0.3f,  0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.0f, 0.6f,	// bottom left
-		//1
-  /*64*/0.3f,   0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.0f, 0.0f,	// top left
-		0.9f,   0.9f, 0.0f,		1.0f, 0.0f, 0.0f,   0.3f, 0.0f,	// top right
-		0.9f,   0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.3f, 0.3f, // bottom right
-		0.3f,   0.3f, 0.0f,		1.0f, 0.0f, 0.0f,   0.0f, 0.3f,	// bottom left
-		//2
-  /*96*/-0.9f,  0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.0f,	// top left
-		-0.3f,  0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.0f,	// top right
-		-0.3f,  -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.3f, // bottom right
-		-0.9f,  -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.3f,	// bottom left
-		//8
- /*128*/-0.3f,  0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.6f,	// top left
-		0.3f,   0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.6f,	// top right
-		0.3f,   -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.9f, // bottom right
-		-0.3f,  -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.9f,	// bottom left
-		//7
- /*160*/0.3f,   0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.0f, 0.6f,	// top left
-		0.9f,   0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.6f,	// top right
-		0.9f,   -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.9f, // bottom right
-		0.3f,   -0.3f, 0.0f,	1.0f, 0.0f, 0.0f,   0.0f, 0.9f,	// bottom left
-		//6
- /*192*/-0.9f,  -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.3f,	// top left
-		-0.3f,  -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.9f, 0.3f,	// top right
-		-0.3f,  -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.9f, 0.6f, // bottom right
-		-0.9f,  -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.6f,	// bottom left
-		//5
- /*224*/-0.3f,  -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.3f,	// top left
-		0.3f,   -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.3f,	// top right
-		0.3f,   -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.6f, 0.6f, // bottom right
-		-0.3f,  -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.3f, 0.6f,	// bottom left
-		//9
- /*256*/0.3f,  -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.5f, 0.5f,	// top left
-		0.9f,  -0.3f,  0.0f,	1.0f, 0.0f, 0.0f,   0.5F, 0.5f,	// top right
-		0.9f,  -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.5f, 0.5f, // bottom right
-		0.3f,  -0.9f,  0.0f,	1.0f, 0.0f, 0.0f,   0.5f, 0.5f	// bottom left
-	};
-
-	float points_square_empty[] = {
-		0.3f, -0.3f, 0.0f,
-		0.9f, -0.9f, 0.0f
-
-	};
-
-	int pos_square = 262;
-
-	unsigned int indices[] = {
-		// 1
-		0, 1, 2, // first triangle
-		0, 2, 3,  // second triangle
-
-		4, 5, 6, // first triangle
-		4, 6, 7,  // second triangle
-
-		8, 9, 10, // first triangle
-		8, 10, 11,  // second triangle
-
-		12, 13, 14, // first triangle
-		12, 14, 15,  // second triangle
-
-		16, 17, 18, // first triangle
-		16, 18, 19,  // second triangle
-
-		20, 21, 22, // first triangle
-		20, 22, 23, // second triangle
-
-		24, 25, 26, // first triangle
-		24, 26, 27,  // second triangle
-
-		28, 29, 30, // first triangle
-		28, 30, 31, // second triangle
-
-		32, 33, 34, // first triangle
-		32, 34, 35  // second triangle
-	};
-
-	unsigned int VBO, VAO, EBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	// position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	// color attribute
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// texture coord attribute
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
+	// start layout: a position from a hardest_build file, or else a random
+	// solvable board from the difficulty band, which is by exact distance.
+	// 3x3 boards take well under a millisecond to check. a game resumed from
+	// the save needs neither
+	int start_rows = 3;
+	int start_cols = 3;
+	int start_tiles[POSITIONS_MAX_CELLS];
+	if ( positions_file && !replay_file ) {
+		// expert level: one of the hardest positions of its board size
+		positions hardest;
+		if ( !positions_open( &hardest, positions_file ) ) {
+			return 1;
+		}
+		rng r;
+		rng_seed( &r, start_seed );
+		unsigned long long i = position_index >= 0 ? (unsigned long long)position_index % hardest.count
+																							 : rng_next( &r ) % hardest.count;
+		int distance = positions_get( &hardest, i, start_tiles );
+		start_rows = hardest.rows;
+		start_cols = hardest.cols;
+		positions_close( &hardest );
+		if ( distance < 0 ) {
+			fprintf( stderr, "ERROR: position %llu of %s is not a board, the file is damaged\n", i,
+							 positions_file );
+			return 1;
+		}
+		if ( !scramble_is_solvable( start_tiles, start_rows, start_cols ) ) {
+			fprintf( stderr, "ERROR: position %llu of %s can not be solved\n", i, positions_file );
+			return 1;
+		}
+		printf( "position %llu of %s: %ix%i, %i moves from solved\n", i, positions_file, start_rows,
+						start_cols, distance );
+	}
+	// the game owns the board, the move log and the distance table. a game
+	// played by hand carries on from the save unless a start was asked for
+	game g;
+	save_game *saved = replay_file || autoplay_on ? NULL : save_open( SAVE_FILE );
+	bool resumed = saved && !new_game && !positions_file && save_resume( saved, &g, record_file );
+	if ( !resumed && !replay_file && !positions_file ) {
+		// with the table game_init() maps too the band edges are lookups, not
+		// 256 searches. it is looked for first, game_init() says how to build it
+		char dist_name[64];
+		sprintf( dist_name, GAME_DISTANCE_FILE, 3, 3 );
+		FILE *dist_file = fopen( dist_name, "rb" );
+		distance_table start_dist;
+		bool have_dist = dist_file && distance_table_open( &start_dist, dist_name, 3, 3 );
+		if ( dist_file ) {
+			fclose( dist_file );
+		}
+		solver start_solver;
+		scramble_generator scrambler;
+		bool scrambled = solver_init( &start_solver, 3, 3 ) &&
+										 scramble_init( &scrambler, 3, 3, start_seed, SCRAMBLE_EXACT, &start_solver,
+																		have_dist ? &start_dist : NULL );
+		if ( scrambled ) {
+			scramble_next( &scrambler, band, start_tiles, NULL );
+		}
+		if ( have_dist ) {
+			distance_table_close( &start_dist );
+		}
+		if ( !scrambled ) {
+			if ( saved ) {
+				save_close( saved );
+			}
+			return 1;
+		}
+	}
+	bool game_ok = resumed ||
+								 ( replay_file
+										 ? game_init( &g, replay.b.rows, replay.b.cols, replay.b.tiles, record_file )
+										 : game_init( &g, start_rows, start_cols, start_tiles, record_file ) );
+	if ( !game_ok ) {
+		if ( saved ) {
+			save_close( saved );
+		}
+		return 1;
+	}
+	if ( resumed ) {
+		printf( "resumed the %ix%i game in %s: move %llu of %llu, %.0f s played\n", g.b.rows, g.b.cols,
+						SAVE_FILE, g.hist.position, g.hist.length, g.play_seconds );
+	} else if ( saved && !save_start( saved, &g ) ) {
+		save_close( saved );
+		saved = NULL;
+	}
+	if ( g.have_dist ) {
+		update_title( &g.dist, &g.b );
+	}
 	char vertex_shader[1024 * 256];
 	char fragment_shader[1024 * 256];
 	parse_file_into_str( "test_vs.glsl", vertex_shader, 1024 * 256 );
-	parse_file_into_str( "test_fs.glsl", fragment_shader, 1024 * 256 );
+	// a virtual texture is looked up through its page table
+	parse_file_into_str( virtual_file ? "vt_fs.glsl" : "test_fs.glsl", fragment_shader, 1024 * 256 );
 
 	GLuint vs = glCreateShader( GL_VERTEX_SHADER );
 	const GLchar *p = (const GLchar *)vertex_shader;
@@ -238,47 +379,240 @@ int main() {
 		return false;
 	}
 
-	// load and create a texture
-	// -------------------------
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, nrChannels;
-
-	unsigned char *data = stbi_load("cat.jpg", &width, &height, &nrChannels, 0);
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+	board_renderer renderer;
+	if ( !board_renderer_init( &renderer, &g.b, shader_programme ) ) {
+		fprintf( stderr, "ERROR: could not create board renderer\n" );
+		return 1;
 	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
+
+	// H shows the best next tile. the search runs on its own thread from the
+	// first press on, following every move so the next hint is ready sooner
+	hint_engine *hints =
+		g.b.n <= HINT_MAX_CELLS ? hint_engine_create( g.b.rows, g.b.cols, NULL ) : NULL;
+	bool hints_on = false;
+	bool show_hint = false;
+
+	// the picture cropped to the board and cut into tiles, with gutters so
+	// the mipmaps do not bleed. cached next to the image for the next run
+	// a virtual texture keeps a fixed page cache on the GPU instead, and a
+	// video is streamed whole into one texture, frame after frame
+	virtual_texture *vt = NULL;
+	video_texture *video = NULL;
+	GLuint texture = 0;
+	if ( virtual_file ) {
+		vt = virtual_texture_open( virtual_file, shader_programme, g_gl_width, g_gl_height );
+		if ( !vt ) {
+			return 1;
+		}
+	} else if ( video_file ) {
+		video = video_texture_open( video_file );
+		if ( !video ) {
+			return 1;
+		}
+	} else {
+		tile_atlas atlas;
+		if ( !tile_atlas_load( &atlas, image_file, g.b.rows, g.b.cols ) ) {
+			return 1;
+		}
+		texture = tile_atlas_upload( &atlas );
+		if ( !texture ) {
+			return 1;
+		}
+		board_renderer_use_atlas( &renderer, &atlas );
+		tile_atlas_free( &atlas ); // GL has its own copy
 	}
-	stbi_image_free(data);
 
 	glEnable( GL_CULL_FACE ); // cull face
 	glCullFace( GL_BACK );		// cull back face
 	glFrontFace( GL_CW );			// GL_CCW for counter clock-wise
 
+	// key presses are queued by the GLFW callback and handled once per frame
+	static input keys_in;
+	input_init( &keys_in, g_window );
+
+	// the computer presses the keys, into the same queue as the callback
+	autoplay bot;
+	if ( autoplay_on && !autoplay_init( &bot, &g, autoplay_rate, autoplay_moves, start_seed ) ) {
+		return 1;
+	}
+	unsigned long long autoplay_first_move = g.moves;
+	double autoplay_last_move = 0.0;
+	static frame_stats frames;
+	frame_stats_reset( &frames );
+
+	// the swap waits for the display instead of the loop sleeping. a replay
+	// or unthrottled autoplay runs flat out to time the game loop
+	glfwSwapInterval( replay_file || ( autoplay_on && 0.0 == bot.rate ) ? 0 : 1 );
+	double replay_start = glfwGetTime();
+	unsigned long long replay_frames = 0;
+	double last_frame = replay_start;
+
+	// by hand the loop sleeps while the picture is still. a replay or autoplay
+	// keeps drawing every frame, its timings are what it is run for
+	static redraw frames_drawn;
+	redraw_init( &frames_drawn, g_window, !continuous && !replay_file && !autoplay_on );
+	if ( vt ) {
+		// the page feedback of a frame is read two frames later
+		redraw_follow( &frames_drawn, 2 );
+	}
+	bool was_animating = false;
+
 	while ( !glfwWindowShouldClose( g_window ) ) {
+		// update other events like input handling. sleeps when there is
+		// nothing to draw, until a key, a window event or the next timer
+		redraw_wait( &frames_drawn );
+
+		// every key pressed since the last frame, in order, handled before
+		// anything is drawn. a move never waits on the previous one, so quick
+		// presses chain at any frame rate
+		double now = glfwGetTime();
+		if ( replay_file || ( autoplay_on && bot.started && !bot.done ) ) {
+			frame_stats_add( &frames, now - last_frame );
+		}
+		// play time for the save, leaving out stalls (a dragged window, a debugger)
+		g.play_seconds += now - last_frame < 0.25 ? now - last_frame : 0.25;
+		last_frame = now;
+		if ( autoplay_on ) {
+			board_dir dirs[INPUT_QUEUE_SIZE / 2];
+			int count = autoplay_feed( &bot, &g.b, now, dirs, input_queue_room( &keys_in.queue ) / 2 );
+			for ( int i = 0; i < count; i++ ) {
+				input_event ev = { game_dir_key( dirs[i] ), GLFW_PRESS, now };
+				input_queue_push( &keys_in.queue, &ev );
+				ev.action = GLFW_RELEASE;
+				input_queue_push( &keys_in.queue, &ev );
+			}
+			// with a move count the run ends on it, not at the goal
+			if ( bot.done && ( bot.max_moves > 0 || bot.failed ) ) {
+				glfwSetWindowShouldClose( g_window, 1 );
+			}
+		}
+		int keys[INPUT_QUEUE_SIZE];
+		int key_count = input_poll( &keys_in, now, keys, INPUT_QUEUE_SIZE );
+		if ( key_count > 0 ) {
+			redraw_key( &frames_drawn, keys_in.first_press >= 0.0 ? keys_in.first_press : now );
+		}
+		if ( keys_in.held_key ) {
+			redraw_at( &frames_drawn, keys_in.next_repeat );
+		}
+		bool moved = false;
+		if ( replay_file ) {
+			// the log stands in for the player. when it runs out we are done
+			board_dir dir;
+			for ( int i = 0; i < replay_rate; i++ ) {
+				if ( !movelog_next( &replay, &dir ) ) {
+					glfwSetWindowShouldClose( g_window, 1 );
+					break;
+				}
+				moved |= game_move( &g, dir );
+				board_renderer_update( &renderer, &g.b, now );
+			}
+			replay_frames++;
+		}
+		for ( int i = 0; i < key_count; i++ ) {
+			if ( GLFW_KEY_ESCAPE == keys[i] ) {
+				glfwSetWindowShouldClose( g_window, 1 );
+			}
+			if ( GLFW_KEY_H == keys[i] && hints && !replay_file ) {
+				if ( !hints_on ) {
+					hint_engine_set_board( hints, &g.b );
+				}
+				hints_on = true;
+				show_hint = true;
+			}
+			if ( !replay_file && game_history_key( &g, keys[i] ) ) {
+				// an undo slides back like a move, a jump redraws the board
+				moved = true;
+				board_renderer_update( &renderer, &g.b, now );
+				continue;
+			}
+			int dir = game_key_dir( keys[i] );
+			if ( dir < 0 || replay_file || !game_move( &g, (board_dir)dir ) ) {
+				continue;
+			}
+			moved = true;
+			// start the slide of the tile that moved, one small upload per move.
+			// frames in between only move the clock
+			board_renderer_update( &renderer, &g.b, now );
+		}
+		if ( moved && autoplay_on ) {
+			autoplay_last_move = now;
+		}
+		if ( moved && g.have_dist ) {
+			update_title( &g.dist, &g.b );
+		}
+		if ( moved && hints_on ) {
+			hint_engine_set_board( hints, &g.b );
+			show_hint = false;
+		}
+		// one atomic load: the frame never waits on the search
+		hint best;
+		bool have_hint = show_hint && hint_engine_read( hints, &best );
+		if ( renderer.highlight_tile != ( have_hint ? best.tile : -1 ) ) {
+			redraw_needed( &frames_drawn );
+		}
+		board_renderer_highlight( &renderer, have_hint ? best.tile : -1 );
+		if ( show_hint && !have_hint ) {
+			// the search can not wake the loop, look again soon
+			redraw_at( &frames_drawn, now + REDRAW_POLL_SECONDS );
+		}
+		// saving is a few stores into the mapping, the disk is another thread's.
+		// only on a move: the play clock alone would have the file synced every
+		// second while the board sits there, it goes in with the next move
+		if ( saved && moved ) {
+			save_update( saved, &g );
+		}
 
-		//Sleep(100);
+		// let the last tile slide home before the board counts as done
+		// (a replay, or an autoplay run of so many moves, ends on its own)
+		bool demo = replay_file || ( autoplay_on && bot.max_moves > 0 );
+		bool animating = board_renderer_animating( &renderer, now );
+		bool solved = !demo && board_is_solved( &g.b ) && !animating;
+		if ( solved ) {
+			board_renderer_reveal_blank( &renderer );
+			redraw_needed( &frames_drawn );
+		}
+		// every frame of a slide, and one more once it has landed
+		if ( animating || was_animating ) {
+			redraw_needed( &frames_drawn );
+		}
+		if ( animating ) {
+			redraw_at( &frames_drawn, now );
+		}
+		was_animating = animating;
+		if ( video ) {
+			// the frame due now, if the worker has it
+			double next_frame_time;
+			if ( video_texture_update( video, now, &next_frame_time ) ) {
+				redraw_needed( &frames_drawn );
+			}
+			redraw_at( &frames_drawn, next_frame_time );
+		}
+		if ( !redraw_begin( &frames_drawn ) ) {
+			continue;
+		}
+
+		if ( vt ) {
+			// pages the frame before last asked for, then what this one needs
+			if ( virtual_texture_update( vt ) ) {
+				redraw_needed( &frames_drawn );
+			}
+			virtual_texture_begin_feedback( vt );
+			board_renderer_draw( &renderer, now );
+			virtual_texture_end_feedback( vt, g_gl_width, g_gl_height );
+		}
 
 		// wipe the drawing surface clear
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
 		// bind Texture
-		glBindTexture(GL_TEXTURE_2D, texture);
+		if ( vt ) {
+			virtual_texture_bind( vt );
+		} else if ( video ) {
+			video_texture_bind( video );
+		} else {
+			glBindTexture(GL_TEXTURE_2D, texture);
+		}
 
 		//
 		// Note: this call is not necessary, but I like to do it anyway before any
@@ -287,217 +621,68 @@ int main() {
 
 		// Note: this call is not necessary, but I like to do it anyway before any
 		// time that I call glDrawArrays() so I never use the wrong vertex data
-		glBindVertexArray( VAO );
-		glDrawElements(GL_TRIANGLES, 54, GL_UNSIGNED_INT, 0);
-		// update other events like input handling
-		glfwPollEvents();
-
-		/*float square_empty[] = {
-			0.3f,  -0.3f,  0.0f,	// top left
-			0.9f,  -0.9f,  0.0f,	// bottom right
-		};*/
-
-		if (vertices[6] == 0.0f && vertices[7] == 0.0f
-			&& vertices[38] == 0.3f && vertices[39] == 0.0f
-			&& vertices[70] == 0.6f && vertices[71] == 0.0f
-
-			&& vertices[102] == 0.0f && vertices[103] == 0.3f
-			&& vertices[134] == 0.3f && vertices[135] == 0.3f
-			&& vertices[166] == 0.6f && vertices[167] == 0.3f
-
-			&& vertices[198] == 0.0f && vertices[199] == 0.6f
-			&& vertices[230] == 0.3f && vertices[231] == 0.6f) {
-
-			vertices[pos_square] = 0.6f;
-			vertices[pos_square + 1] = 0.6f;
-			vertices[pos_square + 8] = 0.6f;
-			vertices[pos_square + 9] = 0.9f;
-			vertices[pos_square + 16] = 0.9f;
-			vertices[pos_square + 17] = 0.9f;
-			vertices[pos_square + 24] = 0.6f;
-			vertices[pos_square + 25] = 0.9f;
+		board_renderer_draw( &renderer, now );
 
-			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-			// put the stuff we've been drawing onto the display
-			glfwSwapBuffers(g_window);
+		// put the stuff we've been drawing onto the display
+		glfwSwapBuffers(g_window);
+		redraw_end( &frames_drawn, glfwGetTime() );
 
+		if ( solved ) {
+#ifdef _WIN32
 			int msgboxID = MessageBox(
 				NULL,
 				(LPCWSTR)L"Parabns!\nVoc conseguiu resolver o quebra-cabea.",
 				(LPCWSTR)L"JOGO",
 				MB_DEFBUTTON2
 			);
+#else
+			printf( "Parabens! Voce conseguiu resolver o quebra-cabeca.\n" );
+#endif
+			printf( "%llu moves in %.0f s\n", g.moves, g.play_seconds );
 
 			glfwSetWindowShouldClose(g_window, 1);
 
-			return 0;
-		}
-
-		if ( GLFW_PRESS == glfwGetKey( g_window, GLFW_KEY_ESCAPE ) ) {
-			glfwSetWindowShouldClose( g_window, 1 );
-		}
-		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_UP)) {
-			if (points_square_empty[4] > -0.9f) {
-				points_square_empty[4] -= 0.6f;
-				points_square_empty[1] -= 0.6f;
-
-
-				float p1_x = vertices[pos_square + 96];
-				float p1_y = vertices[pos_square + 96 + 1];
-				float p2_x = vertices[pos_square + 96 + 8];
-				float p2_y = vertices[pos_square + 96 + 9];
-				float p3_x = vertices[pos_square + 96 + 16];
-				float p3_y = vertices[pos_square + 96 + 17];
-				float p4_x = vertices[pos_square + 96 + 24];
-				float p4_y = vertices[pos_square + 96 + 25];
-
-				vertices[pos_square + 96] = 0.5f;
-				vertices[pos_square + 96 + 1] = 0.5f;
-				vertices[pos_square + 96 + 8] = 0.5f;
-				vertices[pos_square + 96 + 9] = 0.5f;
-				vertices[pos_square + 96 + 16] = 0.5f;
-				vertices[pos_square + 96 + 17] = 0.5f;
-				vertices[pos_square + 96 + 24] = 0.5f;
-				vertices[pos_square + 96 + 25] = 0.5f;
-
-				vertices[pos_square] = p1_x;
-				vertices[pos_square + 1] = p1_y;
-				vertices[pos_square + 8] = p2_x;
-				vertices[pos_square + 9] = p2_y;
-				vertices[pos_square + 16] = p3_x;
-				vertices[pos_square + 17] = p3_y;
-				vertices[pos_square + 24] = p4_x;
-				vertices[pos_square + 25] = p4_y;
-
-				pos_square += 96;
-
-				Sleep(200);
+			finish_hints( hints );
+			if ( saved ) {
+				// nothing left to resume
+				save_clear( saved );
+				save_close( saved );
 			}
-		}
-		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_DOWN)) {
-			if (points_square_empty[1] < 0.9f) {
-				points_square_empty[1] += 0.6f;
-				points_square_empty[4] += 0.6f;
-
-
-				float p1_x = vertices[pos_square - 96];
-				float p1_y = vertices[pos_square - 96 + 1];
-				float p2_x = vertices[pos_square - 96 + 8];
-				float p2_y = vertices[pos_square - 96 + 9];
-				float p3_x = vertices[pos_square - 96 + 16];
-				float p3_y = vertices[pos_square - 96 + 17];
-				float p4_x = vertices[pos_square - 96 + 24];
-				float p4_y = vertices[pos_square - 96 + 25];
-
-				vertices[pos_square - 96] = 0.5f;
-				vertices[pos_square - 96 + 1] = 0.5f;
-				vertices[pos_square - 96 + 8] = 0.5f;
-				vertices[pos_square - 96 + 9] = 0.5f;
-				vertices[pos_square - 96 + 16] = 0.5f;
-				vertices[pos_square - 96 + 17] = 0.5f;
-				vertices[pos_square - 96 + 24] = 0.5f;
-				vertices[pos_square - 96 + 25] = 0.5f;
-
-				vertices[pos_square ] = p1_x;
-				vertices[pos_square + 1] = p1_y;
-				vertices[pos_square + 8] = p2_x;
-				vertices[pos_square + 9] = p2_y;
-				vertices[pos_square + 16] = p3_x;
-				vertices[pos_square + 17] = p3_y;
-				vertices[pos_square + 24] = p4_x;
-				vertices[pos_square + 25] = p4_y;
-
-				pos_square -= 96;
-
-				Sleep(200);
-			}
-		}
-		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_LEFT)) {
-			if (points_square_empty[3] < 0.9f) {
-				points_square_empty[3] += 0.6f;
-				points_square_empty[0] += 0.6f;
-
-
-				float p1_x = vertices[pos_square + 32];
-				float p1_y = vertices[pos_square + 32 + 1];
-				float p2_x = vertices[pos_square + 32 + 8];
-				float p2_y = vertices[pos_square + 32 + 9];
-				float p3_x = vertices[pos_square + 32 + 16];
-				float p3_y = vertices[pos_square + 32 + 17];
-				float p4_x = vertices[pos_square + 32 + 24];
-				float p4_y = vertices[pos_square + 32 + 25];
-
-				vertices[pos_square + 32] = 0.5f;
-				vertices[pos_square + 32 + 1] = 0.5f;
-				vertices[pos_square + 32 + 8] = 0.5f;
-				vertices[pos_square + 32 + 9] = 0.5f;
-				vertices[pos_square + 32 + 16] = 0.5f;
-				vertices[pos_square + 32 + 17] = 0.5f;
-				vertices[pos_square + 32 + 24] = 0.5f;
-				vertices[pos_square + 32 + 25] = 0.5f;
-
-				vertices[pos_square] = p1_x;
-				vertices[pos_square + 1] = p1_y;
-				vertices[pos_square + 8] = p2_x;
-				vertices[pos_square + 9] = p2_y;
-				vertices[pos_square + 16] = p3_x;
-				vertices[pos_square + 17] = p3_y;
-				vertices[pos_square + 24] = p4_x;
-				vertices[pos_square + 25] = p4_y;
-
-				pos_square += 32;
-
-				Sleep(200);
-			}
-		}
-		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_RIGHT)) {
-
-			if (points_square_empty[0] > -0.9f) {
-				points_square_empty[0] -= 0.6f;
-				points_square_empty[3] -= 0.6f;
-
-
-				float p1_x = vertices[pos_square - 32];
-				float p1_y = vertices[pos_square - 32 + 1];
-				float p2_x = vertices[pos_square - 32 + 8];
-				float p2_y = vertices[pos_square - 32 + 9];
-				float p3_x = vertices[pos_square - 32 + 16];
-				float p3_y = vertices[pos_square - 32 + 17];
-				float p4_x = vertices[pos_square - 32 + 24];
-				float p4_y = vertices[pos_square - 32 + 25];
-
-				vertices[pos_square - 32] = 0.5f;
-				vertices[pos_square - 32 + 1] = 0.5f;
-				vertices[pos_square - 32 + 8] = 0.5f;
-				vertices[pos_square - 32 + 9] = 0.5f;
-				vertices[pos_square - 32 + 16] = 0.5f;
-				vertices[pos_square - 32 + 17] = 0.5f;
-				vertices[pos_square - 32 + 24] = 0.5f;
-				vertices[pos_square - 32 + 25] = 0.5f;
-
-				vertices[pos_square] = p1_x;
-				vertices[pos_square + 1] = p1_y;
-				vertices[pos_square + 8] = p2_x;
-				vertices[pos_square + 9] = p2_y;
-				vertices[pos_square + 16] = p3_x;
-				vertices[pos_square + 17] = p3_y;
-				vertices[pos_square + 24] = p4_x;
-				vertices[pos_square + 25] = p4_y;
-
-				pos_square -= 32;
-
-				Sleep(200);
+			if ( autoplay_on ) {
+				finish_autoplay( &bot, g.moves - autoplay_first_move, autoplay_last_move, &frames );
 			}
+			finish_virtual_texture( vt );
+			finish_video( video );
+			redraw_print( &frames_drawn );
+			board_renderer_free( &renderer );
+			game_free( &g );
+			return 0;
 		}
-
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-		// put the stuff we've been drawing onto the display
-		glfwSwapBuffers(g_window);
-		
 	}
 
+	if ( replay_file ) {
+		double seconds = glfwGetTime() - replay_start;
+		unsigned long long moves = replay.position - replay_from;
+		printf( "replayed %llu moves in %llu frames, %.3f s: %.0f moves/s, %.1f frames/s\n", moves,
+						replay_frames, seconds, moves / seconds, replay_frames / seconds );
+		frame_stats_print( &frames, "replay frames" );
+		movelog_close( &replay );
+	}
+	if ( autoplay_on ) {
+		finish_autoplay( &bot, g.moves - autoplay_first_move, autoplay_last_move, &frames );
+	}
+	finish_hints( hints );
+	if ( saved ) {
+		save_update( saved, &g );
+		save_close( saved );
+	}
+	finish_virtual_texture( vt );
+	finish_video( video );
+	redraw_print( &frames_drawn );
+	board_renderer_free( &renderer );
+	if ( !game_free( &g ) ) {
+		fprintf( stderr, "ERROR: could not finish writing %s\n", record_file );
+	}
 	// close GL context and any other GLFW resources
 	glfwTerminate();
 	return 0;
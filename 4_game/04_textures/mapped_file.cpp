@@ -0,0 +1,194 @@
+#include "mapped_file.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool mapped_file_open_read( mapped_file *m, const char *file_name ) {
+	memset( m, 0, sizeof( mapped_file ) );
+	m->descriptor = -1;
+#ifdef _WIN32
+	HANDLE file = CreateFileA( file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+														 FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( INVALID_HANDLE_VALUE == file ) {
+		fprintf( stderr, "ERROR: could not open %s for mapping\n", file_name );
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx( file, &size );
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	const void *data = mapping ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+	if ( !data ) {
+		fprintf( stderr, "ERROR: could not map %s\n", file_name );
+		if ( mapping ) {
+			CloseHandle( mapping );
+		}
+		CloseHandle( file );
+		return false;
+	}
+	m->handle = file;
+	m->mapping = mapping;
+	m->size = (size_t)size.QuadPart;
+#else
+	int fd = open( file_name, O_RDONLY );
+	if ( fd < 0 ) {
+		fprintf( stderr, "ERROR: could not open %s for mapping\n", file_name );
+		return false;
+	}
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || 0 == st.st_size ) {
+		fprintf( stderr, "ERROR: could not stat %s or it is empty\n", file_name );
+		close( fd );
+		return false;
+	}
+	void *data = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	// the mapping keeps the file alive, the descriptor is not needed any more
+	close( fd );
+	if ( MAP_FAILED == data ) {
+		fprintf( stderr, "ERROR: could not map %s\n", file_name );
+		return false;
+	}
+	m->size = (size_t)st.st_size;
+#endif
+	m->data = data;
+	return true;
+}
+
+/* maps m->size bytes of the open file read/write */
+static bool map_writable( mapped_file *m ) {
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	size.QuadPart = (LONGLONG)m->size;
+	HANDLE mapping =
+		CreateFileMappingA( (HANDLE)m->handle, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL );
+	void *data = mapping ? MapViewOfFile( mapping, FILE_MAP_WRITE, 0, 0, 0 ) : NULL;
+	if ( !data ) {
+		if ( mapping ) {
+			CloseHandle( mapping );
+		}
+		return false;
+	}
+	m->mapping = mapping;
+#else
+	void *data = mmap( NULL, m->size, PROT_READ | PROT_WRITE, MAP_SHARED, m->descriptor, 0 );
+	if ( MAP_FAILED == data ) {
+		return false;
+	}
+#endif
+	m->data = data;
+	m->writable = data;
+	return true;
+}
+
+static void unmap( mapped_file *m ) {
+#ifdef _WIN32
+	UnmapViewOfFile( m->data );
+	CloseHandle( (HANDLE)m->mapping );
+#else
+	munmap( (void *)m->data, m->size );
+#endif
+	m->data = NULL;
+	m->writable = NULL;
+	m->mapping = NULL;
+}
+
+bool mapped_file_open_write( mapped_file *m, const char *file_name, size_t size ) {
+	memset( m, 0, sizeof( mapped_file ) );
+	m->descriptor = -1;
+#ifdef _WIN32
+	HANDLE file = CreateFileA( file_name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+														 OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( INVALID_HANDLE_VALUE == file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	GetFileSizeEx( file, &file_size );
+	m->handle = file;
+	// the mapping grows the file to its size itself
+	m->size = (size_t)file_size.QuadPart > size ? (size_t)file_size.QuadPart : size;
+	if ( !map_writable( m ) ) {
+		fprintf( stderr, "ERROR: could not map %s for writing\n", file_name );
+		CloseHandle( file );
+		return false;
+	}
+#else
+	int fd = open( file_name, O_RDWR | O_CREAT, 0644 );
+	if ( fd < 0 ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		return false;
+	}
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 ) {
+		fprintf( stderr, "ERROR: could not stat %s\n", file_name );
+		close( fd );
+		return false;
+	}
+	m->descriptor = fd;
+	m->size = (size_t)st.st_size > size ? (size_t)st.st_size : size;
+	if ( ( (size_t)st.st_size < size && ftruncate( fd, (off_t)size ) != 0 ) || !map_writable( m ) ) {
+		fprintf( stderr, "ERROR: could not map %s for writing\n", file_name );
+		close( fd );
+		m->descriptor = -1;
+		return false;
+	}
+#endif
+	return true;
+}
+
+bool mapped_file_resize( mapped_file *m, size_t size ) {
+	if ( !m->writable || size <= m->size ) {
+		return m->writable != NULL;
+	}
+	unmap( m );
+	size_t old_size = m->size;
+	m->size = size;
+#ifndef _WIN32
+	if ( ftruncate( m->descriptor, (off_t)size ) != 0 ) {
+		m->size = old_size;
+		map_writable( m );
+		return false;
+	}
+#endif
+	if ( !map_writable( m ) ) {
+		// the file can still be mapped at the size it had
+		m->size = old_size;
+		map_writable( m );
+		return false;
+	}
+	return true;
+}
+
+bool mapped_file_flush( mapped_file *m ) {
+	if ( !m->writable ) {
+		return false;
+	}
+#ifdef _WIN32
+	return FlushViewOfFile( m->data, 0 ) && FlushFileBuffers( (HANDLE)m->handle );
+#else
+	// the pages of a shared mapping are the file's page cache, so syncing the
+	// file writes them without touching the mapping
+	return 0 == fsync( m->descriptor );
+#endif
+}
+
+void mapped_file_close( mapped_file *m ) {
+	if ( !m->data ) {
+		return;
+	}
+	unmap( m );
+#ifdef _WIN32
+	CloseHandle( (HANDLE)m->handle );
+#else
+	if ( m->descriptor >= 0 ) {
+		close( m->descriptor );
+	}
+#endif
+	memset( m, 0, sizeof( mapped_file ) );
+}
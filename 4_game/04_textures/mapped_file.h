@@ -0,0 +1,38 @@
+/******************************************************************************\
+| Memory mapped files.                                                         |
+| Read-only for the big lookup tables so every process running the game or a   |
+| tool shares one copy in the page cache and opening a table costs no reading. |
+| Read/write for the save game: a store into the mapping is the whole write,  |
+| the O/S owns the page from then on (so it outlives a crash of the process)  |
+| and mapped_file_flush() only decides when it is on the disk.                |
+\******************************************************************************/
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+
+struct mapped_file {
+	const void *data;
+	size_t size;
+	void *handle;	 // file handle (or descriptor) and mapping handle, per O/S
+	void *mapping;
+	void *writable;	// 'data' again when opened for writing, else NULL
+	int descriptor; // POSIX file descriptor kept for writing, else -1
+};
+
+bool mapped_file_open_read( mapped_file *m, const char *file_name );
+
+/* opens 'file_name' for reading and writing, creating it if it is not there
+and growing it with zeros to at least 'size' bytes */
+bool mapped_file_open_write( mapped_file *m, const char *file_name, size_t size );
+
+/* grows a file opened for writing to 'size' bytes and maps it again, so
+m->data and m->writable may move. nothing else may touch the mapping meanwhile */
+bool mapped_file_resize( mapped_file *m, size_t size );
+
+/* blocks until everything written to the mapping is on the disk */
+bool mapped_file_flush( mapped_file *m );
+
+void mapped_file_close( mapped_file *m );
+
+#endif
@@ -0,0 +1,250 @@
+#include "movelog.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* fseek() takes a long, which is 32 bits on Windows */
+static bool seek_to( FILE *file, unsigned long long offset ) {
+#ifdef _WIN32
+	return 0 == _fseeki64( file, (long long)offset, SEEK_SET );
+#else
+	return 0 == fseeko( file, (off_t)offset, SEEK_SET );
+#endif
+}
+
+static bool file_size( FILE *file, unsigned long long *size ) {
+#ifdef _WIN32
+	if ( 0 != _fseeki64( file, 0, SEEK_END ) ) {
+		return false;
+	}
+	long long end = _ftelli64( file );
+#else
+	if ( 0 != fseeko( file, 0, SEEK_END ) ) {
+		return false;
+	}
+	long long end = (long long)ftello( file );
+#endif
+	*size = (unsigned long long)end;
+	return end >= 0;
+}
+
+static int chunk_bytes( int n, int interval ) { return n + interval / 4; }
+
+static unsigned long long chunk_offset( const movelog_header *h, long long chunk ) {
+	return sizeof( movelog_header ) +
+				 (unsigned long long)chunk * chunk_bytes( h->rows * h->cols, h->interval );
+}
+
+/* w->chunk becomes the keyframe of the board reached and no moves, written
+out as the next chunk. the file always ends in the chunk being filled */
+static void start_chunk( movelog_writer *w, long long chunk ) {
+	memset( w->chunk, 0, w->chunk_bytes );
+	for ( int i = 0; i < w->b.n; i++ ) {
+		w->chunk[i] = (unsigned char)w->b.tiles[i];
+	}
+	w->chunk_index = chunk;
+	w->in_chunk = 0;
+	seek_to( w->file, chunk_offset( &w->header, chunk ) );
+	fwrite( w->chunk, 1, w->chunk_bytes, w->file );
+}
+
+/* the chunk being filled, over what start_chunk() wrote of it */
+static void write_chunk( movelog_writer *w ) {
+	seek_to( w->file, chunk_offset( &w->header, w->chunk_index ) );
+	fwrite( w->chunk, 1, w->chunk_bytes, w->file );
+}
+
+bool movelog_create( movelog_writer *w, const char *file_name, const board *start,
+										 int interval ) {
+	memset( w, 0, sizeof( movelog_writer ) );
+	if ( start->n > MOVELOG_MAX_CELLS || interval < 4 || interval % 4 != 0 ) {
+		fprintf( stderr, "ERROR: can not log %ix%i boards every %i moves\n", start->rows,
+						 start->cols, interval );
+		return false;
+	}
+	if ( !board_init( &w->b, start->rows, start->cols, start->tiles ) ) {
+		return false;
+	}
+	w->chunk_bytes = chunk_bytes( start->n, interval );
+	w->chunk = (unsigned char *)calloc( w->chunk_bytes, 1 );
+	w->file = fopen( file_name, "wb" );
+	if ( !w->chunk || !w->file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		free( w->chunk );
+		board_free( &w->b );
+		return false;
+	}
+	memcpy( w->header.magic, MOVELOG_MAGIC, sizeof( MOVELOG_MAGIC ) );
+	w->header.rows = start->rows;
+	w->header.cols = start->cols;
+	w->header.interval = interval;
+	// the count is patched in on close. a crash leaves 0, and movelog_open()
+	// works the readable moves out from the file size
+	fwrite( &w->header, sizeof( movelog_header ), 1, w->file );
+	// the start board goes out now, so even a log with no moves replays
+	start_chunk( w, 0 );
+	return true;
+}
+
+bool movelog_append( movelog_writer *w, board_dir dir ) {
+	if ( !board_move( &w->b, dir ) ) {
+		return false;
+	}
+	// the log's board is never drawn, so its dirty list can just be dropped
+	board_clear_dirty( &w->b );
+	unsigned char *moves = w->chunk + w->b.n;
+	moves[w->in_chunk >> 2] |= (unsigned char)( dir << ( ( w->in_chunk & 3 ) << 1 ) );
+	w->header.move_count++;
+	if ( ++w->in_chunk == w->header.interval ) {
+		write_chunk( w );
+		start_chunk( w, w->chunk_index + 1 );
+	}
+	return true;
+}
+
+bool movelog_close( movelog_writer *w ) {
+	if ( !w->file ) {
+		return false;
+	}
+	// chunks are all the same size, the moves past the count are just unused
+	if ( w->in_chunk > 0 ) {
+		write_chunk( w );
+	}
+	seek_to( w->file, 0 );
+	fwrite( &w->header, sizeof( movelog_header ), 1, w->file );
+	bool ok = 0 == ferror( w->file );
+	ok = 0 == fclose( w->file ) && ok;
+	w->file = NULL;
+	free( w->chunk );
+	w->chunk = NULL;
+	board_free( &w->b );
+	return ok;
+}
+
+static bool load_chunk( movelog_reader *r, long long chunk ) {
+	if ( r->loaded_chunk == chunk ) {
+		return true;
+	}
+	if ( !seek_to( r->file, chunk_offset( &r->header, chunk ) ) ||
+			 1 != fread( r->chunk, r->chunk_bytes, 1, r->file ) ) {
+		fprintf( stderr, "ERROR: move log is truncated at chunk %lli\n", chunk );
+		return false;
+	}
+	r->loaded_chunk = chunk;
+	return true;
+}
+
+/* r->b becomes the keyframe of the loaded chunk. board_init() turns down a
+keyframe that is not a permutation, so a damaged log fails here instead of
+handing out tile ids past the end of the board */
+static bool restore_keyframe( movelog_reader *r ) {
+	int tiles[MOVELOG_MAX_CELLS];
+	for ( int i = 0; i < r->b.n; i++ ) {
+		tiles[i] = r->chunk[i];
+	}
+	board_free( &r->b );
+	if ( !board_init( &r->b, r->header.rows, r->header.cols, tiles ) ) {
+		fprintf( stderr, "ERROR: bad keyframe in move log chunk %lli\n", r->loaded_chunk );
+		return false;
+	}
+	return true;
+}
+
+bool movelog_open( movelog_reader *r, const char *file_name ) {
+	memset( r, 0, sizeof( movelog_reader ) );
+	r->loaded_chunk = -1;
+	r->file = fopen( file_name, "rb" );
+	if ( !r->file ) {
+		fprintf( stderr, "ERROR: could not open %s\n", file_name );
+		return false;
+	}
+	movelog_header *h = &r->header;
+	int n = 0;
+	if ( 1 == fread( h, sizeof( movelog_header ), 1, r->file ) &&
+			 0 == memcmp( h->magic, MOVELOG_MAGIC, sizeof( MOVELOG_MAGIC ) ) ) {
+		n = h->rows * h->cols;
+	}
+	if ( n < 4 || n > MOVELOG_MAX_CELLS || h->interval < 4 || h->interval % 4 != 0 ) {
+		fprintf( stderr, "ERROR: %s is not a move log\n", file_name );
+		fclose( r->file );
+		r->file = NULL;
+		return false;
+	}
+	r->chunk_bytes = chunk_bytes( n, h->interval );
+	unsigned long long size;
+	if ( 0 == h->move_count && file_size( r->file, &size ) && size > sizeof( movelog_header ) ) {
+		// never closed: the writer puts out the moves of a chunk once it is full,
+		// and then the next one's keyframe, so every whole chunk but the last
+		// holds 'interval' moves
+		unsigned long long chunks = ( size - sizeof( movelog_header ) ) / r->chunk_bytes;
+		h->move_count = chunks > 0 ? ( chunks - 1 ) * h->interval : 0;
+	}
+	r->chunk = (unsigned char *)malloc( r->chunk_bytes );
+	// the board gets its real tiles from the first keyframe
+	if ( !r->chunk || !board_init( &r->b, h->rows, h->cols, NULL ) || !movelog_seek( r, 0 ) ) {
+		movelog_close( r );
+		return false;
+	}
+	return true;
+}
+
+void movelog_close( movelog_reader *r ) {
+	if ( r->file ) {
+		fclose( r->file );
+		r->file = NULL;
+	}
+	free( r->chunk );
+	r->chunk = NULL;
+	board_free( &r->b );
+}
+
+bool movelog_seek( movelog_reader *r, unsigned long long move ) {
+	if ( move > r->header.move_count ) {
+		return false;
+	}
+	long long chunk = (long long)( move / r->header.interval );
+	// the end of a log that fills its last chunk is that chunk's last move
+	if ( move > 0 && move == r->header.move_count && 0 == move % r->header.interval ) {
+		chunk--;
+	}
+	if ( !load_chunk( r, chunk ) || !restore_keyframe( r ) ) {
+		return false;
+	}
+	r->position = (unsigned long long)chunk * r->header.interval;
+	board_dir dir;
+	while ( r->position < move ) {
+		if ( !movelog_next( r, &dir ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool movelog_next( movelog_reader *r, board_dir *dir ) {
+	if ( r->position >= r->header.move_count ) {
+		return false;
+	}
+	long long chunk = (long long)( r->position / r->header.interval );
+	int in_chunk = (int)( r->position % r->header.interval );
+	if ( chunk != r->loaded_chunk ) {
+		if ( !load_chunk( r, chunk ) ) {
+			return false;
+		}
+		// the keyframe has to be the board the moves so far led to
+		for ( int i = 0; i < r->b.n; i++ ) {
+			if ( r->chunk[i] != r->b.tiles[i] ) {
+				fprintf( stderr, "ERROR: replay diverged from the keyframe at move %llu\n",
+								 r->position );
+				return false;
+			}
+		}
+	}
+	const unsigned char *moves = r->chunk + r->b.n;
+	*dir = (board_dir)( ( moves[in_chunk >> 2] >> ( ( in_chunk & 3 ) << 1 ) ) & 3 );
+	if ( !board_move( &r->b, *dir ) ) {
+		fprintf( stderr, "ERROR: move %llu in the log is not legal\n", r->position );
+		return false;
+	}
+	board_clear_dirty( &r->b );
+	r->position++;
+	return true;
+}
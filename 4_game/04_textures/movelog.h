@@ -0,0 +1,73 @@
+/******************************************************************************\
+| Compact move log for recording and replaying games.                          |
+| A move is 2 bits (the board_dir). The file is the header followed by fixed  |
+| size chunks; chunk k holds a keyframe -- the board before move k * interval, |
+| one byte per slot -- then the next 'interval' moves. With fixed size chunks  |
+| the offset of any move is arithmetic, so seeking is one read plus at most    |
+| 'interval' moves replayed from the keyframe, whatever the log length, and   |
+| the reader only ever holds one chunk in memory. The first keyframe is the    |
+| scramble the game started from. Reading checks every keyframe against the   |
+| board it replayed, so a replay that diverges is caught within one chunk.    |
+\******************************************************************************/
+#ifndef _MOVELOG_H_
+#define _MOVELOG_H_
+
+#include "board.h"
+#include <stdio.h>
+
+#define MOVELOG_MAGIC "PUZLOG1"
+#define MOVELOG_MAX_CELLS 256			// tile ids fit a byte
+#define MOVELOG_DEFAULT_INTERVAL 1024 // moves per chunk, a multiple of 4
+
+struct movelog_header {
+	char magic[8];
+	int rows;
+	int cols;
+	int interval;
+	int reserved;
+	unsigned long long move_count; // written when the log is closed, 0 after a crash
+};
+
+struct movelog_writer {
+	FILE *file;
+	movelog_header header;
+	board b;							// the board as the log has it, for the keyframes
+	unsigned char *chunk; // keyframe then interval / 4 bytes of moves
+	int chunk_bytes;
+	int in_chunk;					 // moves in the chunk being filled
+	long long chunk_index; // the chunk being filled, its keyframe in the file already
+};
+
+struct movelog_reader {
+	FILE *file;
+	movelog_header header;
+	board b;										 // board after 'position' moves
+	unsigned long long position; // moves played so far
+	unsigned char *chunk;
+	int chunk_bytes;
+	long long loaded_chunk; // chunk in 'chunk', -1 for none
+};
+
+/* starts a log of the game beginning at board 'start' */
+bool movelog_create( movelog_writer *w, const char *file_name, const board *start, int interval );
+
+/* records 'dir'. returns false, recording nothing, if it is not a legal move
+from the board the log has reached */
+bool movelog_append( movelog_writer *w, board_dir dir );
+
+/* writes the moves of the last chunk and the move count */
+bool movelog_close( movelog_writer *w );
+
+/* opens a log and positions it at the start of the game */
+bool movelog_open( movelog_reader *r, const char *file_name );
+
+void movelog_close( movelog_reader *r );
+
+/* puts r->b in the state after 'move' moves. O(interval) at most */
+bool movelog_seek( movelog_reader *r, unsigned long long move );
+
+/* the next move, also applied to r->b. false at the end of the log or if the
+log does not replay */
+bool movelog_next( movelog_reader *r, board_dir *dir );
+
+#endif
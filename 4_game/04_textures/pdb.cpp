@@ -0,0 +1,128 @@
+#include "pdb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned long long pdb_entry_count( int n, int k ) {
+	unsigned long long count = 1;
+	for ( int i = 0; i < k; i++ ) {
+		count *= (unsigned long long)( n - i );
+	}
+	return count;
+}
+
+unsigned long long pdb_rank( const int *pos, int k, int n ) {
+	// digit i is the cell of tile i counted among the cells tiles 0..i-1 left
+	// free, so the placements are numbered densely 0..n!/(n-k)!-1
+	unsigned long long index = 0;
+	for ( int i = 0; i < k; i++ ) {
+		int digit = pos[i];
+		for ( int j = 0; j < i; j++ ) {
+			if ( pos[j] < pos[i] ) {
+				digit--;
+			}
+		}
+		index = index * ( n - i ) + digit;
+	}
+	return index;
+}
+
+void pdb_unrank( unsigned long long index, int k, int n, int *pos ) {
+	int digits[PDB_MAX_PATTERN_TILES];
+	for ( int i = k - 1; i >= 0; i-- ) {
+		digits[i] = (int)( index % ( n - i ) );
+		index /= ( n - i );
+	}
+	bool used[PDB_MAX_CELLS] = { false };
+	for ( int i = 0; i < k; i++ ) {
+		int free_seen = -1;
+		for ( int cell = 0; cell < n; cell++ ) {
+			if ( !used[cell] && ++free_seen == digits[i] ) {
+				pos[i] = cell;
+				used[cell] = true;
+				break;
+			}
+		}
+	}
+}
+
+bool pdb_open( pdb_set *p, const char *file_name, int rows, int cols ) {
+	memset( p, 0, sizeof( pdb_set ) );
+	if ( !mapped_file_open_read( &p->file, file_name ) ) {
+		return false;
+	}
+	const pdb_file_header *header = (const pdb_file_header *)p->file.data;
+	if ( p->file.size < sizeof( pdb_file_header ) ||
+			 0 != memcmp( header->magic, PDB_MAGIC, sizeof( PDB_MAGIC ) ) ) {
+		fprintf( stderr, "ERROR: %s is not a pattern database\n", file_name );
+		pdb_close( p );
+		return false;
+	}
+	if ( rows * cols > PDB_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: pattern databases go up to %i cells\n", PDB_MAX_CELLS );
+		pdb_close( p );
+		return false;
+	}
+	if ( header->rows != rows || header->cols != cols ) {
+		fprintf( stderr, "ERROR: %s is for %ix%i boards, not %ix%i\n", file_name, header->rows,
+						 header->cols, rows, cols );
+		pdb_close( p );
+		return false;
+	}
+	p->rows = rows;
+	p->cols = cols;
+	p->n = rows * cols;
+	p->pattern_count = header->pattern_count;
+	memset( p->pattern_of, -1, sizeof( p->pattern_of ) );
+	// the lookups index by these without a check, so a damaged header must not get through
+	bool ok = p->pattern_count >= 1 && p->pattern_count <= PDB_MAX_PATTERNS;
+	for ( int i = 0; ok && i < p->pattern_count; i++ ) {
+		pdb_pattern *pat = &p->patterns[i];
+		pat->k = header->k[i];
+		ok = pat->k >= 1 && pat->k <= PDB_MAX_PATTERN_TILES;
+		for ( int t = 0; ok && t < pat->k; t++ ) {
+			int tile = header->tiles[i][t];
+			// every tile but the blank, in one pattern only
+			ok = tile >= 0 && tile < p->n - 1 && p->pattern_of[tile] < 0;
+			if ( ok ) {
+				pat->tiles[t] = tile;
+				p->pattern_of[tile] = (signed char)i;
+			}
+		}
+	}
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: %s has a damaged pattern list\n", file_name );
+		pdb_close( p );
+		return false;
+	}
+	for ( int i = 0; i < p->pattern_count; i++ ) {
+		pdb_pattern *pat = &p->patterns[i];
+		pat->entries = pdb_entry_count( p->n, pat->k );
+		if ( header->offsets[i] > p->file.size ||
+				 ( pat->entries + 1 ) / 2 > p->file.size - header->offsets[i] ) {
+			fprintf( stderr, "ERROR: %s is truncated\n", file_name );
+			pdb_close( p );
+			return false;
+		}
+		pat->nibbles = (const unsigned char *)p->file.data + header->offsets[i];
+	}
+	return true;
+}
+
+void pdb_close( pdb_set *p ) { mapped_file_close( &p->file ); }
+
+int pdb_heuristic( const pdb_set *p, const int *tiles ) {
+	int pos_of[PDB_MAX_CELLS];
+	int h = 0;
+	for ( int pos = 0; pos < p->n; pos++ ) {
+		int tile = tiles[pos];
+		pos_of[tile] = pos;
+		if ( tile != p->n - 1 ) {
+			h += abs( tile / p->cols - pos / p->cols ) + abs( tile % p->cols - pos % p->cols );
+		}
+	}
+	for ( int i = 0; i < p->pattern_count; i++ ) {
+		h += 2 * pdb_lookup( p, i, pos_of );
+	}
+	return h;
+}
@@ -0,0 +1,79 @@
+/******************************************************************************\
+| Disjoint additive pattern databases.                                         |
+| The tiles are split into groups (patterns). For every placement of a         |
+| pattern's tiles the table holds how many moves of *those* tiles it takes to  |
+| get them home, so the values of disjoint patterns can be added up and stay   |
+| admissible.                                                                  |
+| Entries are 4 bits: the pattern cost minus the Manhattan distance of the     |
+| pattern's tiles is always even, so we store half of it (clamped at 15) and   |
+| the heuristic is  Manhattan + 2 * sum of entries.                            |
+| Tables are built by the pdb_build tool and memory mapped read-only here.     |
+\******************************************************************************/
+#ifndef _PDB_H_
+#define _PDB_H_
+
+#include "mapped_file.h"
+
+#define PDB_MAX_PATTERNS 6
+#define PDB_MAX_PATTERN_TILES 8
+#define PDB_MAX_CELLS 25
+#define PDB_MAGIC "PUZPDB1"
+
+struct pdb_pattern {
+	int k;
+	int tiles[PDB_MAX_PATTERN_TILES];
+	unsigned long long entries;		// n! / ( n - k )!
+	const unsigned char *nibbles; // entry i is in byte i / 2, low nibble first
+};
+
+struct pdb_set {
+	int rows;
+	int cols;
+	int n;
+	int pattern_count;
+	pdb_pattern patterns[PDB_MAX_PATTERNS];
+	signed char pattern_of[PDB_MAX_CELLS]; // pattern of every tile, -1 for the blank
+	mapped_file file;
+};
+
+/* on-disk layout: this header, then each pattern's nibbles at its offset */
+struct pdb_file_header {
+	char magic[8];
+	int rows;
+	int cols;
+	int pattern_count;
+	int k[PDB_MAX_PATTERNS];
+	int tiles[PDB_MAX_PATTERNS][PDB_MAX_PATTERN_TILES];
+	unsigned long long offsets[PDB_MAX_PATTERNS];
+};
+
+/* number of table entries for k tiles on n cells */
+unsigned long long pdb_entry_count( int n, int k );
+
+/* index of the placement where pattern tile i sits in cell pos[i] */
+unsigned long long pdb_rank( const int *pos, int k, int n );
+
+/* inverse of pdb_rank() */
+void pdb_unrank( unsigned long long index, int k, int n, int *pos );
+
+/* maps 'file_name' and checks it was built for the given board size */
+bool pdb_open( pdb_set *p, const char *file_name, int rows, int cols );
+
+void pdb_close( pdb_set *p );
+
+/* half the extra moves pattern 'pattern' needs on top of its Manhattan
+distance. 'pos_of' holds the cell of every tile */
+inline int pdb_lookup( const pdb_set *p, int pattern, const int *pos_of ) {
+	const pdb_pattern *pat = &p->patterns[pattern];
+	int pos[PDB_MAX_PATTERN_TILES];
+	for ( int i = 0; i < pat->k; i++ ) {
+		pos[i] = pos_of[pat->tiles[i]];
+	}
+	unsigned long long index = pdb_rank( pos, pat->k, p->n );
+	return ( pat->nibbles[index >> 1] >> ( ( index & 1 ) << 2 ) ) & 0xF;
+}
+
+/* full heuristic for 'tiles': Manhattan + 2 * sum of the pattern entries */
+int pdb_heuristic( const pdb_set *p, const int *tiles );
+
+#endif
@@ -0,0 +1,428 @@
+/******************************************************************************\
+| Builds a disjoint additive pattern database file for pdb_open().            |
+|   ./pdb_build <rows> <cols> <output file> [threads] [pattern ...]            |
+|   ./pdb_build 4 4 puzzle4x4.patdb                                            |
+| A pattern is a comma separated list of tile ids, e.g. 0,1,4,5,8,12. With no |
+| patterns given the usual splits are used: 6-6-3 for 4x4, 6-6-6-6 for 5x5.   |
+|                                                                              |
+| Each pattern is built with a breadth first search backwards from the goal   |
+| over (pattern placement, blank cell) states, where only moves of pattern    |
+| tiles cost anything. Every level runs in two parallel passes:                |
+|  1. flood the blank through the free cells of each placement (free moves)  |
+|  2. swap the blank with an adjacent pattern tile, claiming the new state    |
+|     for level d + 1 with a compare-and-swap                                  |
+| The states need one byte each while building (n * n!/(n-k)! bytes: 92 MB   |
+| for a 6 tile 4x4 pattern, 3.2 GB for a 6 tile 5x5 one); the table written   |
+| out is the minimum over the blank cells at 4 bits per placement.            |
+\******************************************************************************/
+#include "pdb.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define UNSEEN 0xFF
+// placements handed to a worker at a time. even, so two workers never write
+// the two nibbles of the same output byte
+#define CHUNK 4096
+
+struct build_job {
+	int rows;
+	int cols;
+	int n;
+	int k;
+	const int *tiles;
+	unsigned long long entries;
+	std::atomic<unsigned char> *depth; // entries * n, indexed placement * n + blank
+	std::atomic<unsigned long long> next_chunk;
+	std::atomic<unsigned long long> level_count;
+	int level;
+	unsigned char *nibbles;				 // output, ( entries + 1 ) / 2 bytes
+	std::atomic<int> max_entry;
+};
+
+typedef void ( *placement_pass )( build_job *job, unsigned long long p );
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/* runs 'pass' over every chunk of placements on 'threads' workers */
+static void parallel_chunks( build_job *job, int threads, placement_pass pass ) {
+	job->next_chunk = 0;
+	std::vector<std::thread> workers;
+	for ( int t = 0; t < threads; t++ ) {
+		workers.push_back( std::thread( [job, pass]() {
+			for ( ;; ) {
+				unsigned long long first = job->next_chunk.fetch_add( CHUNK );
+				if ( first >= job->entries ) {
+					return;
+				}
+				unsigned long long last = first + CHUNK < job->entries ? first + CHUNK : job->entries;
+				for ( unsigned long long p = first; p < last; p++ ) {
+					pass( job, p );
+				}
+			}
+		} ) );
+	}
+	for ( size_t t = 0; t < workers.size(); t++ ) {
+		workers[t].join();
+	}
+}
+
+static void neighbours( const build_job *job, int cell, int *out, int *count ) {
+	*count = 0;
+	int row = cell / job->cols;
+	int col = cell % job->cols;
+	if ( row > 0 ) {
+		out[( *count )++] = cell - job->cols;
+	}
+	if ( row < job->rows - 1 ) {
+		out[( *count )++] = cell + job->cols;
+	}
+	if ( col > 0 ) {
+		out[( *count )++] = cell - 1;
+	}
+	if ( col < job->cols - 1 ) {
+		out[( *count )++] = cell + 1;
+	}
+}
+
+/* pass 1: blank moves onto cells no pattern tile is in cost nothing */
+static void flood_free_cells( build_job *job, unsigned long long p ) {
+	const int n = job->n;
+	const unsigned char d = (unsigned char)job->level;
+	std::atomic<unsigned char> *states = job->depth + p * n;
+	int queue[PDB_MAX_CELLS];
+	int queue_len = 0;
+	for ( int b = 0; b < n; b++ ) {
+		if ( states[b].load( std::memory_order_relaxed ) == d ) {
+			queue[queue_len++] = b;
+		}
+	}
+	if ( 0 == queue_len ) {
+		return;
+	}
+	int pos[PDB_MAX_PATTERN_TILES];
+	pdb_unrank( p, job->k, n, pos );
+	bool occupied[PDB_MAX_CELLS] = { false };
+	for ( int i = 0; i < job->k; i++ ) {
+		occupied[pos[i]] = true;
+	}
+	// only this worker writes level d into this placement's states
+	int seeds = queue_len;
+	for ( int head = 0; head < queue_len; head++ ) {
+		int adjacent[4], count;
+		neighbours( job, queue[head], adjacent, &count );
+		for ( int i = 0; i < count; i++ ) {
+			int c = adjacent[i];
+			if ( !occupied[c] && states[c].load( std::memory_order_relaxed ) == UNSEEN ) {
+				states[c].store( d, std::memory_order_relaxed );
+				queue[queue_len++] = c;
+			}
+		}
+	}
+	if ( queue_len > seeds ) {
+		job->level_count += queue_len - seeds;
+	}
+}
+
+/* pass 2: the blank swapping with a pattern tile costs one move */
+static void move_pattern_tiles( build_job *job, unsigned long long p ) {
+	const int n = job->n;
+	const unsigned char d = (unsigned char)job->level;
+	std::atomic<unsigned char> *states = job->depth + p * n;
+	int pos[PDB_MAX_PATTERN_TILES];
+	bool unranked = false;
+	int tile_at[PDB_MAX_CELLS];
+	unsigned long long found = 0;
+	for ( int b = 0; b < n; b++ ) {
+		if ( states[b].load( std::memory_order_relaxed ) != d ) {
+			continue;
+		}
+		if ( !unranked ) {
+			pdb_unrank( p, job->k, n, pos );
+			for ( int c = 0; c < n; c++ ) {
+				tile_at[c] = -1;
+			}
+			for ( int i = 0; i < job->k; i++ ) {
+				tile_at[pos[i]] = i;
+			}
+			unranked = true;
+		}
+		int adjacent[4], count;
+		neighbours( job, b, adjacent, &count );
+		for ( int j = 0; j < count; j++ ) {
+			int c = adjacent[j];
+			int i = tile_at[c];
+			if ( i < 0 ) {
+				continue;
+			}
+			pos[i] = b; // tile i slides into the blank, the blank ends up on c
+			unsigned long long next = pdb_rank( pos, job->k, n ) * n + c;
+			pos[i] = c;
+			unsigned char expected = UNSEEN;
+			if ( job->depth[next].compare_exchange_strong( expected, (unsigned char)( d + 1 ),
+																										 std::memory_order_relaxed ) ) {
+				found++;
+			}
+		}
+	}
+	if ( found ) {
+		job->level_count += found;
+	}
+}
+
+static void clear_states( build_job *job, unsigned long long p ) {
+	for ( int b = 0; b < job->n; b++ ) {
+		job->depth[p * job->n + b].store( UNSEEN, std::memory_order_relaxed );
+	}
+}
+
+/* cheapest blank cell of every placement, stored relative to Manhattan */
+static void write_entries( build_job *job, unsigned long long p ) {
+	int best = UNSEEN;
+	for ( int b = 0; b < job->n; b++ ) {
+		int d = job->depth[p * job->n + b].load( std::memory_order_relaxed );
+		if ( d < best ) {
+			best = d;
+		}
+	}
+	int pos[PDB_MAX_PATTERN_TILES];
+	pdb_unrank( p, job->k, job->n, pos );
+	int md = 0;
+	for ( int i = 0; i < job->k; i++ ) {
+		int t = job->tiles[i];
+		md += abs( t / job->cols - pos[i] / job->cols ) + abs( t % job->cols - pos[i] % job->cols );
+	}
+	int entry = ( best - md ) / 2;
+	if ( entry > 15 ) {
+		entry = 15; // clamping only ever lowers the estimate
+	}
+	int seen = job->max_entry.load( std::memory_order_relaxed );
+	while ( entry > seen && !job->max_entry.compare_exchange_weak( seen, entry ) ) {
+	}
+	unsigned char *byte = &job->nibbles[p >> 1];
+	if ( p & 1 ) {
+		*byte = (unsigned char)( ( *byte & 0x0F ) | ( entry << 4 ) );
+	} else {
+		*byte = (unsigned char)( ( *byte & 0xF0 ) | entry );
+	}
+}
+
+/* builds one pattern into 'nibbles' ( (entries + 1) / 2 bytes ) */
+static bool build_pattern( int rows, int cols, int k, const int *tiles, int threads,
+													 unsigned char *nibbles ) {
+	build_job job;
+	job.rows = rows;
+	job.cols = cols;
+	job.n = rows * cols;
+	job.k = k;
+	job.tiles = tiles;
+	job.entries = pdb_entry_count( job.n, k );
+	unsigned long long states = job.entries * job.n;
+	job.depth = new ( std::nothrow ) std::atomic<unsigned char>[states];
+	if ( !job.depth ) {
+		fprintf( stderr, "ERROR: could not allocate %llu bytes of search states\n", states );
+		return false;
+	}
+	parallel_chunks( &job, threads, clear_states );
+
+	// goal: every pattern tile home, blank in the last cell
+	int goal[PDB_MAX_PATTERN_TILES];
+	for ( int i = 0; i < k; i++ ) {
+		goal[i] = tiles[i];
+	}
+	job.depth[pdb_rank( goal, k, job.n ) * job.n + job.n - 1].store( 0 );
+
+	unsigned long long reached = 1;
+	for ( job.level = 0; job.level < UNSEEN - 1; job.level++ ) {
+		job.level_count = 0;
+		parallel_chunks( &job, threads, flood_free_cells );
+		unsigned long long flooded = job.level_count;
+		job.level_count = 0;
+		parallel_chunks( &job, threads, move_pattern_tiles );
+		reached += flooded + job.level_count;
+		printf( "  level %2i: %llu states by free blank moves, %llu at level %i\n", job.level, flooded,
+						(unsigned long long)job.level_count, job.level + 1 );
+		if ( 0 == job.level_count ) {
+			break;
+		}
+	}
+	printf( "  %llu of %llu states reached\n", reached, states );
+
+	job.nibbles = nibbles;
+	job.max_entry = 0;
+	parallel_chunks( &job, threads, write_entries );
+	int max_entry = job.max_entry;
+	printf( "  largest entry %i (%s)\n", max_entry, max_entry >= 15 ? "some clamped" : "none clamped" );
+	delete[] job.depth;
+	return true;
+}
+
+static int parse_pattern( const char *text, int *tiles ) {
+	int k = 0;
+	const char *c = text;
+	while ( *c && k < PDB_MAX_PATTERN_TILES ) {
+		tiles[k++] = atoi( c );
+		while ( *c && *c != ',' ) {
+			c++;
+		}
+		if ( *c == ',' ) {
+			c++;
+		}
+	}
+	return k;
+}
+
+/* random boards, not necessarily solvable -- the lookups do not care */
+static void report_lookup_rate( const pdb_set *p ) {
+	const int boards = 1000;
+	const int rounds = 2000;
+	std::vector<int> tiles( boards * p->n );
+	srand( 1 );
+	for ( int i = 0; i < boards; i++ ) {
+		int *t = &tiles[i * p->n];
+		for ( int j = 0; j < p->n; j++ ) {
+			t[j] = j;
+		}
+		for ( int j = p->n - 1; j > 0; j-- ) {
+			int r = rand() % ( j + 1 );
+			int tmp = t[j];
+			t[j] = t[r];
+			t[r] = tmp;
+		}
+	}
+	double start = now_seconds();
+	long long sum = 0;
+	for ( int r = 0; r < rounds; r++ ) {
+		for ( int i = 0; i < boards; i++ ) {
+			sum += pdb_heuristic( p, &tiles[i * p->n] );
+		}
+	}
+	double seconds = now_seconds() - start;
+	double evaluations = (double)boards * rounds;
+	printf( "lookup: %.2f M heuristic evaluations/s (%.2f M table lookups/s), mean h %.1f\n",
+					evaluations / seconds / 1e6, evaluations * p->pattern_count / seconds / 1e6,
+					(double)sum / evaluations );
+}
+
+int main( int argc, char **argv ) {
+	if ( argc < 4 ) {
+		fprintf( stderr, "usage: %s <rows> <cols> <output file> [threads] [pattern ...]\n", argv[0] );
+		return 1;
+	}
+	int rows = atoi( argv[1] );
+	int cols = atoi( argv[2] );
+	const char *file_name = argv[3];
+	int threads = argc > 4 ? atoi( argv[4] ) : (int)std::thread::hardware_concurrency();
+	if ( threads < 1 ) {
+		threads = 1;
+	}
+	int n = rows * cols;
+	if ( rows < 2 || cols < 2 || n > PDB_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: board must be between 2x2 and %i cells\n", PDB_MAX_CELLS );
+		return 1;
+	}
+
+	pdb_file_header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PDB_MAGIC, sizeof( PDB_MAGIC ) );
+	header.rows = rows;
+	header.cols = cols;
+	for ( int i = 5; i < argc && header.pattern_count < PDB_MAX_PATTERNS; i++ ) {
+		header.k[header.pattern_count] = parse_pattern( argv[i], header.tiles[header.pattern_count] );
+		header.pattern_count++;
+	}
+	if ( 0 == header.pattern_count ) {
+		static const int p44[3][PDB_MAX_PATTERN_TILES] = {
+			{ 0, 1, 4, 5, 8, 12 }, { 2, 3, 6, 7, 10, 11 }, { 9, 13, 14 } };
+		static const int k44[3] = { 6, 6, 3 };
+		static const int p55[4][PDB_MAX_PATTERN_TILES] = { { 0, 1, 5, 6, 10, 11 },
+																											 { 2, 3, 4, 7, 8, 9 },
+																											 { 12, 13, 14, 17, 18, 19 },
+																											 { 15, 16, 20, 21, 22, 23 } };
+		static const int k55[4] = { 6, 6, 6, 6 };
+		if ( 4 == rows && 4 == cols ) {
+			header.pattern_count = 3;
+			memcpy( header.tiles, p44, sizeof( p44 ) );
+			memcpy( header.k, k44, sizeof( k44 ) );
+		} else if ( 5 == rows && 5 == cols ) {
+			header.pattern_count = 4;
+			memcpy( header.tiles, p55, sizeof( p55 ) );
+			memcpy( header.k, k55, sizeof( k55 ) );
+		} else {
+			fprintf( stderr, "ERROR: no default patterns for %ix%i, list them\n", rows, cols );
+			return 1;
+		}
+	}
+
+	// every tile but the blank in exactly one pattern, or the sum is not admissible
+	int owner[PDB_MAX_CELLS];
+	for ( int t = 0; t < n; t++ ) {
+		owner[t] = -1;
+	}
+	for ( int i = 0; i < header.pattern_count; i++ ) {
+		for ( int j = 0; j < header.k[i]; j++ ) {
+			int t = header.tiles[i][j];
+			if ( t < 0 || t >= n - 1 || owner[t] >= 0 ) {
+				fprintf( stderr, "ERROR: tile %i is out of range or in two patterns\n", t );
+				return 1;
+			}
+			owner[t] = i;
+		}
+	}
+
+	// tables start on page boundaries after the header
+	unsigned long long offset = 4096;
+	for ( int i = 0; i < header.pattern_count; i++ ) {
+		header.offsets[i] = offset;
+		offset += ( pdb_entry_count( n, header.k[i] ) + 1 ) / 2;
+		offset = ( offset + 4095 ) & ~4095ULL;
+	}
+	FILE *file = fopen( file_name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+		return 1;
+	}
+	fwrite( &header, sizeof( header ), 1, file );
+
+	printf( "building %i patterns for %ix%i on %i threads\n", header.pattern_count, rows, cols,
+					threads );
+	double total_start = now_seconds();
+	for ( int i = 0; i < header.pattern_count; i++ ) {
+		unsigned long long entries = pdb_entry_count( n, header.k[i] );
+		unsigned long long bytes = ( entries + 1 ) / 2;
+		unsigned char *nibbles = (unsigned char *)calloc( bytes, 1 );
+		if ( !nibbles ) {
+			fprintf( stderr, "ERROR: could not allocate %llu bytes\n", bytes );
+			return 1;
+		}
+		printf( "pattern %i: %i tiles, %llu entries\n", i, header.k[i], entries );
+		double start = now_seconds();
+		if ( !build_pattern( rows, cols, header.k[i], header.tiles[i], threads, nibbles ) ) {
+			return 1;
+		}
+		printf( "  built in %.2f s, %.2f MB on disk\n", now_seconds() - start, bytes / 1048576.0 );
+		fseek( file, (long)header.offsets[i], SEEK_SET );
+		fwrite( nibbles, 1, bytes, file );
+		free( nibbles );
+	}
+	fclose( file );
+	printf( "total: %.2f s, %s is %.2f MB\n", now_seconds() - total_start, file_name,
+					offset / 1048576.0 );
+
+	pdb_set p;
+	double open_start = now_seconds();
+	if ( !pdb_open( &p, file_name, rows, cols ) ) {
+		return 1;
+	}
+	printf( "pdb_open: %.3f ms\n", ( now_seconds() - open_start ) * 1000.0 );
+	report_lookup_rate( &p );
+	pdb_close( &p );
+	return 0;
+}
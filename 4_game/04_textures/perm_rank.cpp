@@ -0,0 +1,63 @@
+#include "perm_rank.h"
+
+static int popcount( unsigned int v ) {
+	v = v - ( ( v >> 1 ) & 0x55555555u );
+	v = ( v & 0x33333333u ) + ( ( v >> 2 ) & 0x33333333u );
+	return (int)( ( ( ( v + ( v >> 4 ) ) & 0x0F0F0F0Fu ) * 0x01010101u ) >> 24 );
+}
+
+unsigned long long perm_count( int n ) {
+	unsigned long long count = 1;
+	for ( int i = 2; i <= n; i++ ) {
+		count *= (unsigned long long)i;
+	}
+	return count;
+}
+
+int perm_parity( const int *perm, int n ) {
+	// the Lehmer digits add up to the number of inversions
+	unsigned int used = 0;
+	int inversions = 0;
+	for ( int i = 0; i < n; i++ ) {
+		inversions += perm[i] - popcount( used & ( ( 1u << perm[i] ) - 1 ) );
+		used |= 1u << perm[i];
+	}
+	return inversions & 1;
+}
+
+unsigned long long perm_rank_half( const int *perm, int n ) {
+	// mixed radix: digit i counts ( n - 1 - i )! / 2. the digit of the last
+	// but one value is its parity bit and the last digit is always 0
+	unsigned int used = 0;
+	unsigned long long index = 0;
+	for ( int i = 0; i < n - 2; i++ ) {
+		int digit = perm[i] - popcount( used & ( ( 1u << perm[i] ) - 1 ) );
+		used |= 1u << perm[i];
+		index = index * ( n - i ) + digit;
+	}
+	return index;
+}
+
+void perm_unrank_half( unsigned long long index, int n, int parity, int *perm ) {
+	int digits[PERM_MAX];
+	int digit_sum = 0;
+	for ( int i = n - 3; i >= 0; i-- ) {
+		digits[i] = (int)( index % ( n - i ) );
+		index /= ( n - i );
+		digit_sum += digits[i];
+	}
+	// the last but one digit makes the inversion count the right parity
+	digits[n - 2] = ( digit_sum + parity ) & 1;
+	digits[n - 1] = 0;
+	unsigned int used = 0;
+	for ( int i = 0; i < n; i++ ) {
+		int free_seen = -1;
+		for ( int value = 0; value < n; value++ ) {
+			if ( !( used & ( 1u << value ) ) && ++free_seen == digits[i] ) {
+				perm[i] = value;
+				used |= 1u << value;
+				break;
+			}
+		}
+	}
+}
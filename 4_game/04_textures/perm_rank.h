@@ -0,0 +1,28 @@
+/******************************************************************************\
+| Perfect hashing of permutations.                                             |
+| A permutation of 0..n-1 is numbered by its Lehmer code: digit i is how many  |
+| of the values not used by p[0..i-1] are smaller than p[i]. Those values are  |
+| tracked in a bit mask so each digit is one popcount and ranking is O(n).     |
+| The last two digits only encode the permutation's parity, so when the       |
+| parity is known (solvable boards) they are dropped to number the n!/2       |
+| permutations of that parity densely.                                         |
+\******************************************************************************/
+#ifndef _PERM_RANK_H_
+#define _PERM_RANK_H_
+
+// n!/2 still fits in 64 bits and the used-value mask in 32
+#define PERM_MAX 20
+
+/* n! */
+unsigned long long perm_count( int n );
+
+/* 0 for an even permutation, 1 for an odd one */
+int perm_parity( const int *perm, int n );
+
+/* rank of 'perm' among the n!/2 permutations with the same parity */
+unsigned long long perm_rank_half( const int *perm, int n );
+
+/* inverse of perm_rank_half() for permutations of the given parity */
+void perm_unrank_half( unsigned long long index, int n, int parity, int *perm );
+
+#endif
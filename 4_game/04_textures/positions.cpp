@@ -0,0 +1,49 @@
+#include "positions.h"
+#include "board.h"
+#include <stdio.h>
+#include <string.h>
+
+bool positions_open( positions *p, const char *file_name ) {
+	memset( p, 0, sizeof( positions ) );
+	if ( !mapped_file_open_read( &p->file, file_name ) ) {
+		return false;
+	}
+	const positions_header *header = (const positions_header *)p->file.data;
+	if ( p->file.size < sizeof( positions_header ) ||
+			 0 != memcmp( header->magic, POSITIONS_MAGIC, sizeof( POSITIONS_MAGIC ) ) ) {
+		fprintf( stderr, "ERROR: %s is not a positions file\n", file_name );
+		positions_close( p );
+		return false;
+	}
+	if ( header->rows < 2 || header->cols < 2 || header->rows * header->cols > POSITIONS_MAX_CELLS ) {
+		fprintf( stderr, "ERROR: %s has a %ix%i board\n", file_name, header->rows, header->cols );
+		positions_close( p );
+		return false;
+	}
+	p->rows = header->rows;
+	p->cols = header->cols;
+	p->n = p->rows * p->cols;
+	p->count = header->count;
+	p->max_distance = header->max_distance;
+	if ( 0 == p->count ||
+			 sizeof( positions_header ) + p->count * ( p->n + 1 ) > p->file.size ) {
+		fprintf( stderr, "ERROR: %s is empty or truncated\n", file_name );
+		positions_close( p );
+		return false;
+	}
+	p->records = (const unsigned char *)p->file.data + sizeof( positions_header );
+	return true;
+}
+
+void positions_close( positions *p ) { mapped_file_close( &p->file ); }
+
+int positions_get( const positions *p, unsigned long long i, int *tiles ) {
+	const unsigned char *record = p->records + i * ( p->n + 1 );
+	for ( int slot = 0; slot < p->n; slot++ ) {
+		tiles[slot] = record[1 + slot];
+	}
+	if ( !board_is_permutation( tiles, p->n ) ) {
+		return -1;
+	}
+	return record[0];
+}
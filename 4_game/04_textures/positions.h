@@ -0,0 +1,45 @@
+/******************************************************************************\
+| Files of start positions, hardest first.                                     |
+| Written by hardest_build for the expert level and for stress-testing the    |
+| solvers: a header, then one record per position -- its optimal distance in |
+| one byte and its tiles, one byte per slot -- sorted by distance, longest    |
+| first. Memory mapped read-only, so picking a position is a pointer offset.  |
+\******************************************************************************/
+#ifndef _POSITIONS_H_
+#define _POSITIONS_H_
+
+#include "mapped_file.h"
+
+#define POSITIONS_MAGIC "PUZPOS1"
+#define POSITIONS_MAX_CELLS 255 // tile ids are stored in a byte
+
+struct positions {
+	int rows;
+	int cols;
+	int n;
+	unsigned long long count;
+	int max_distance; // of the first record
+	const unsigned char *records; // n + 1 bytes each
+	mapped_file file;
+};
+
+/* on-disk layout: this header, then the records */
+struct positions_header {
+	char magic[8];
+	int rows;
+	int cols;
+	unsigned long long count;
+	int max_distance;
+	int min_distance; // of the last record
+};
+
+/* maps 'file_name'. positions of any board size */
+bool positions_open( positions *p, const char *file_name );
+
+void positions_close( positions *p );
+
+/* tiles of position i into 'tiles' (n ints). returns its distance, or -1 if
+the record is not a permutation of 0..n-1 (a damaged file) */
+int positions_get( const positions *p, unsigned long long i, int *tiles );
+
+#endif
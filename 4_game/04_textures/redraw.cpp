@@ -0,0 +1,127 @@
+#include "redraw.h"
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// GLFW 3.2. the glfw3.h in external/include is from before it was added,
+// the libraries next to it and the system ones have it
+extern "C" GLFWAPI void glfwWaitEventsTimeout( double timeout );
+
+// set by the refresh callback while the loop waits in GLFW
+static bool g_refresh = false;
+
+static void refresh_callback( GLFWwindow *window ) { g_refresh = true; }
+
+/* CPU time of the whole process, every thread, in seconds */
+static double cpu_seconds() {
+#ifdef _WIN32
+	FILETIME created, exited, kernel, user;
+	if ( !GetProcessTimes( GetCurrentProcess(), &created, &exited, &kernel, &user ) ) {
+		return 0.0;
+	}
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return ( k.QuadPart + u.QuadPart ) * 1e-7; // 100 ns units
+#else
+	struct rusage usage;
+	if ( 0 != getrusage( RUSAGE_SELF, &usage ) ) {
+		return 0.0;
+	}
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+				 1e-6 * ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec );
+#endif
+}
+
+void redraw_init( redraw *r, GLFWwindow *window, bool on_demand ) {
+	r->on_demand = on_demand;
+	r->dirty = true;
+	r->follow = 0;
+	r->follow_left = 0;
+	r->key_time = -1.0;
+	r->drawn = 0;
+	r->skipped = 0;
+	r->start_time = glfwGetTime();
+	r->start_cpu = cpu_seconds();
+	r->wake_time = r->start_time;
+	r->wait_seconds = 0.0;
+	frame_stats_reset( &r->latency );
+	glfwSetWindowRefreshCallback( window, refresh_callback );
+}
+
+void redraw_wait( redraw *r ) {
+	double now = glfwGetTime();
+	if ( !r->on_demand || r->dirty || r->follow_left > 0 || r->wake_time <= now ) {
+		glfwPollEvents();
+	} else {
+		double timeout = r->wake_time - now;
+		timeout = timeout < REDRAW_MIN_WAIT ? REDRAW_MIN_WAIT : timeout;
+		timeout = timeout > REDRAW_MAX_WAIT ? REDRAW_MAX_WAIT : timeout;
+		glfwWaitEventsTimeout( timeout );
+		double woken = glfwGetTime();
+		r->wait_seconds += woken - now;
+		now = woken;
+	}
+	// the loop sets it again for whatever is still pending
+	r->wake_time = now + REDRAW_MAX_WAIT;
+	if ( g_refresh ) {
+		g_refresh = false;
+		r->dirty = true;
+	}
+}
+
+void redraw_follow( redraw *r, int frames ) { r->follow = frames; }
+
+void redraw_needed( redraw *r ) { r->dirty = true; }
+
+void redraw_at( redraw *r, double time ) {
+	if ( time < r->wake_time ) {
+		r->wake_time = time;
+	}
+}
+
+void redraw_key( redraw *r, double press_time ) {
+	if ( r->key_time < 0.0 || press_time < r->key_time ) {
+		r->key_time = press_time;
+	}
+	r->dirty = true;
+}
+
+bool redraw_begin( redraw *r ) {
+	if ( r->dirty ) {
+		r->follow_left = r->follow;
+	} else if ( r->follow_left > 0 ) {
+		r->follow_left--;
+	} else if ( r->on_demand ) {
+		r->skipped++;
+		return false;
+	}
+	r->dirty = false;
+	r->drawn++;
+	return true;
+}
+
+void redraw_end( redraw *r, double now ) {
+	if ( r->key_time >= 0.0 ) {
+		frame_stats_add( &r->latency, now - r->key_time );
+		r->key_time = -1.0;
+	}
+}
+
+void redraw_print( const redraw *r ) {
+	double seconds = glfwGetTime() - r->start_time;
+	double cpu = cpu_seconds() - r->start_cpu;
+	printf( "%s: %llu frames drawn, %llu wakes with nothing to draw, %.1f%% of the time asleep, "
+					"%.1f%% of a core over %.1f s\n",
+					r->on_demand ? "on demand" : "continuous", r->drawn, r->skipped,
+					seconds > 0.0 ? 100.0 * r->wait_seconds / seconds : 0.0,
+					seconds > 0.0 ? 100.0 * cpu / seconds : 0.0, seconds );
+	if ( r->latency.count > 0 ) {
+		frame_stats_print( &r->latency, "key press to swap" );
+	}
+}
@@ -0,0 +1,71 @@
+/******************************************************************************\
+| Draws a frame only when the picture changed.                                 |
+| The render loop notes what it changed (a move, a hint, a revealed tile, a    |
+| video frame) and when something will change on its own (the next key         |
+| repeat, a hint still being searched). With nothing to draw it skips the      |
+| clear, draw and swap, and blocks in glfwWaitEventsTimeout() until the        |
+| earliest of those times, so a board at rest costs no CPU. A key press or a   |
+| window event ends the wait at once: a move is drawn as soon as before.       |
+| Slides keep the loop drawing every frame until the last one has landed,      |
+| and work read back from the GPU frames later (the page feedback of a         |
+| virtual texture) can ask for frames to follow every one drawn.               |
+| Also keeps the numbers to compare with drawing every frame: CPU time, and    |
+| the time from a key press to the swap that shows it.                         |
+\******************************************************************************/
+#ifndef _REDRAW_H_
+#define _REDRAW_H_
+
+#include "frame_stats.h"
+#include <GLFW/glfw3.h>
+
+#define REDRAW_MAX_WAIT 0.25	// the longest the loop sleeps: the play clock ticks on
+#define REDRAW_MIN_WAIT 0.001 // the shortest, so a late worker is not polled in a spin
+#define REDRAW_POLL_SECONDS 0.01 // how often to look at work of a thread that can not wake us
+
+struct redraw {
+	bool on_demand;		// false: draw every frame, as fast as the swap goes
+	bool dirty;				// what is on screen is out of date
+	int follow;				// frames drawn after every needed one
+	int follow_left;
+	double wake_time; // the earliest something changes on its own
+	double key_time;	// the earliest key press not yet on screen, -1 for none
+	unsigned long long drawn;		// frames drawn
+	unsigned long long skipped; // wakes that had nothing to draw
+	double start_time;
+	double start_cpu;
+	double wait_seconds; // blocked in glfwWaitEventsTimeout()
+	frame_stats latency; // key press to swap
+};
+
+/* installs a refresh callback on 'window' so a damaged or resized window is
+drawn again. the first frame is always drawn */
+void redraw_init( redraw *r, GLFWwindow *window, bool on_demand );
+
+/* at the top of the loop, instead of glfwPollEvents(): with a frame to draw
+only polls, else sleeps until an event or the earliest redraw_at() time */
+void redraw_wait( redraw *r );
+
+/* every frame drawn is followed by 'frames' more, for GPU work read back that
+many frames later */
+void redraw_follow( redraw *r, int frames );
+
+/* the next frame must be drawn */
+void redraw_needed( redraw *r );
+
+/* something changes at 'time' without an event: wake the loop then. 'now'
+or earlier for every frame, while something animates */
+void redraw_at( redraw *r, double time );
+
+/* a key pressed at 'press_time' was handled: draw, and time it to the swap */
+void redraw_key( redraw *r, double press_time );
+
+/* true if this frame is to be drawn, and then clears the dirty flag */
+bool redraw_begin( redraw *r );
+
+/* right after the swap of a frame redraw_begin() let through */
+void redraw_end( redraw *r, double now );
+
+/* frames drawn and skipped, CPU use and key to screen latency */
+void redraw_print( const redraw *r );
+
+#endif
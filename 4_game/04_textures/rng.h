@@ -0,0 +1,53 @@
+/******************************************************************************\
+| Small fast seedable random number generator: xoshiro256**.                  |
+| Every stream is seeded through splitmix64, so nearby seeds (0, 1, 2 ... per |
+| thread or per chunk of boards) still give unrelated sequences, and the same |
+| seed gives the same scrambles on every platform, unlike rand().              |
+\******************************************************************************/
+#ifndef _RNG_H_
+#define _RNG_H_
+
+struct rng {
+	unsigned long long s[4];
+};
+
+inline unsigned long long rng_rotl( unsigned long long x, int k ) {
+	return ( x << k ) | ( x >> ( 64 - k ) );
+}
+
+inline void rng_seed( rng *r, unsigned long long seed ) {
+	for ( int i = 0; i < 4; i++ ) {
+		// splitmix64
+		unsigned long long z = ( seed += 0x9E3779B97F4A7C15ULL );
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+		r->s[i] = z ^ ( z >> 31 );
+	}
+}
+
+inline unsigned long long rng_next( rng *r ) {
+	unsigned long long *s = r->s;
+	unsigned long long result = rng_rotl( s[1] * 5, 7 ) * 9;
+	unsigned long long t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl( s[3], 45 );
+	return result;
+}
+
+/* uniform in 0..bound-1 with no modulo bias (Lemire's multiply and reject) */
+inline unsigned int rng_below( rng *r, unsigned int bound ) {
+	unsigned long long m = ( rng_next( r ) >> 32 ) * bound;
+	if ( (unsigned int)m < bound ) {
+		unsigned int threshold = ( 0u - bound ) % bound;
+		while ( (unsigned int)m < threshold ) {
+			m = ( rng_next( r ) >> 32 ) * bound;
+		}
+	}
+	return (unsigned int)( m >> 32 );
+}
+
+#endif
@@ -0,0 +1,236 @@
+#include "save.h"
+#include "mapped_file.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#define CHUNK_MOVES HISTORY_KEYFRAME_INTERVAL
+#define CHUNK_MOVE_BYTES ( CHUNK_MOVES / 4 )
+#define BODY_OFFSET ( 2 * SAVE_SLOT_BYTES )
+
+struct save_game {
+	mapped_file file;
+	int n;
+	size_t chunk_bytes;					// keyframe then the moves
+	unsigned long long chunks;	// room for in the file
+	int slot;										// header slot in use
+	unsigned long long sequence; // of that slot
+	std::mutex lock;						 // the mapping, between a resize and a sync
+	std::condition_variable wake;
+	std::atomic<bool> dirty; // written since the last sync
+	bool quit;
+	std::thread syncer;
+};
+
+static unsigned int checksum( const save_header *h ) {
+	// FNV-1a
+	const unsigned char *bytes = (const unsigned char *)h;
+	unsigned int hash = 2166136261u;
+	for ( size_t i = 0; i < offsetof( save_header, checksum ); i++ ) {
+		hash = ( hash ^ bytes[i] ) * 16777619u;
+	}
+	return hash;
+}
+
+static save_header *slot_header( save_game *s, int slot ) {
+	return (save_header *)( (unsigned char *)s->file.writable + slot * SAVE_SLOT_BYTES );
+}
+
+static unsigned char *chunk( save_game *s, unsigned long long k ) {
+	return (unsigned char *)s->file.writable + BODY_OFFSET + k * s->chunk_bytes;
+}
+
+static bool slot_valid( save_game *s, int slot ) {
+	const save_header *h = slot_header( s, slot );
+	return 0 == memcmp( h->magic, SAVE_MAGIC, sizeof( SAVE_MAGIC ) ) && h->checksum == checksum( h );
+}
+
+static void syncer_main( save_game *s ) {
+	std::unique_lock<std::mutex> guard( s->lock );
+	while ( !s->quit ) {
+		s->wake.wait_for( guard, std::chrono::duration<double>( SAVE_FLUSH_SECONDS ) );
+		if ( s->dirty.exchange( false ) ) {
+			mapped_file_flush( &s->file );
+		}
+	}
+}
+
+save_game *save_open( const char *file_name ) {
+	save_game *s = new save_game;
+	if ( !mapped_file_open_write( &s->file, file_name, BODY_OFFSET ) ) {
+		delete s;
+		return NULL;
+	}
+	s->n = 0;
+	s->chunk_bytes = 0;
+	s->chunks = 0;
+	s->slot = 0;
+	s->sequence = 0;
+	s->dirty = false;
+	s->quit = false;
+	s->syncer = std::thread( syncer_main, s );
+	return s;
+}
+
+void save_close( save_game *s ) {
+	{
+		std::lock_guard<std::mutex> guard( s->lock );
+		s->quit = true;
+	}
+	s->wake.notify_one();
+	s->syncer.join();
+	if ( s->dirty ) {
+		mapped_file_flush( &s->file );
+	}
+	mapped_file_close( &s->file );
+	delete s;
+}
+
+/* the chunk layout for n cell boards, and how many chunks the file holds */
+static void set_layout( save_game *s, int n ) {
+	s->n = n;
+	s->chunk_bytes = n + CHUNK_MOVE_BYTES;
+	s->chunks = s->file.size > BODY_OFFSET ? ( s->file.size - BODY_OFFSET ) / s->chunk_bytes : 0;
+}
+
+/* room for chunk 'k', doubling the file as needed */
+static bool reserve_chunk( save_game *s, unsigned long long k ) {
+	if ( k < s->chunks ) {
+		return true;
+	}
+	unsigned long long chunks = s->chunks > SAVE_INITIAL_CHUNKS ? s->chunks : SAVE_INITIAL_CHUNKS;
+	while ( chunks <= k ) {
+		chunks *= 2;
+	}
+	std::lock_guard<std::mutex> guard( s->lock );
+	if ( !mapped_file_resize( &s->file, BODY_OFFSET + chunks * s->chunk_bytes ) ) {
+		fprintf( stderr, "ERROR: could not grow the save to %llu moves\n", chunks * CHUNK_MOVES );
+		return false;
+	}
+	s->chunks = chunks;
+	return true;
+}
+
+bool save_resume( save_game *s, game *g, const char *record_file ) {
+	bool valid[2] = { slot_valid( s, 0 ), slot_valid( s, 1 ) };
+	if ( !valid[0] && !valid[1] ) {
+		return false;
+	}
+	int slot = !valid[0] || ( valid[1] && slot_header( s, 1 )->sequence > slot_header( s, 0 )->sequence );
+	const save_header *h = slot_header( s, slot );
+	int n = h->rows * h->cols;
+	if ( h->rows < 2 || h->cols < 2 || n > GAME_MAX_CELLS || h->position > h->length ) {
+		return false;
+	}
+	set_layout( s, n );
+	unsigned long long length = h->length;
+	if ( !valid[1 - slot] ) {
+		// the other slot was cut short, and the update it was part of had
+		// already stored its moves. those after this one's position are the
+		// redo tail at best, so only keep what was played. an undo below this
+		// position and a new move lower where the update starts storing, so
+		// moves and keyframes before it may be the newer game's too: then the
+		// history does not lead to the board and the check below drops it
+		length = h->position;
+	}
+	if ( length / CHUNK_MOVES >= s->chunks ) {
+		return false;
+	}
+	int tiles[GAME_MAX_CELLS];
+	for ( int i = 0; i < n; i++ ) {
+		tiles[i] = h->tiles[i];
+	}
+	if ( !game_init( g, h->rows, h->cols, tiles, record_file ) ) {
+		return false;
+	}
+	if ( !game_check( g ) || board_is_solved( &g->b ) ) {
+		game_free( g );
+		return false;
+	}
+	// the history straight from the chunks
+	history *hist = &g->hist;
+	if ( history_reserve( hist, length ) ) {
+		for ( unsigned long long k = 0; k <= length / CHUNK_MOVES; k++ ) {
+			memcpy( hist->keyframes + k * n, chunk( s, k ), n );
+			memcpy( hist->moves + k * CHUNK_MOVE_BYTES, chunk( s, k ) + n, CHUNK_MOVE_BYTES );
+		}
+		hist->length = length;
+	}
+	// the history must lead to the saved board. after a crash of the whole
+	// machine the disk may have the header without the moves it came with
+	int check[GAME_MAX_CELLS];
+	if ( !history_seek( hist, h->position, check ) || 0 != memcmp( check, tiles, n * sizeof( int ) ) ) {
+		fprintf( stderr, "the history in the save does not lead to its board, starting it afresh\n" );
+		history_free( hist );
+		history_init( hist, &g->b );
+	}
+	hist->clean = hist->length;
+	g->moves = h->moves;
+	g->solves = h->solves;
+	g->play_seconds = h->play_seconds;
+	s->slot = slot;
+	s->sequence = h->sequence;
+	return true;
+}
+
+void save_update( save_game *s, game *g ) {
+	history *h = &g->hist;
+	if ( !reserve_chunk( s, h->length / CHUNK_MOVES ) ) {
+		return;
+	}
+	// the move bytes and keyframes after the last unchanged move
+	for ( unsigned long long byte = h->clean / 4; byte < ( h->length + 3 ) / 4; byte++ ) {
+		chunk( s, byte / CHUNK_MOVE_BYTES )[s->n + byte % CHUNK_MOVE_BYTES] = h->moves[byte];
+	}
+	for ( unsigned long long k = h->clean / CHUNK_MOVES + 1; k <= h->length / CHUNK_MOVES; k++ ) {
+		memcpy( chunk( s, k ), h->keyframes + k * s->n, s->n );
+	}
+	h->clean = h->length;
+
+	// the whole header into the other slot, checksum last
+	int slot = 1 - s->slot;
+	save_header *header = slot_header( s, slot );
+	memcpy( header->magic, SAVE_MAGIC, sizeof( SAVE_MAGIC ) );
+	header->sequence = s->sequence + 1;
+	header->rows = g->b.rows;
+	header->cols = g->b.cols;
+	header->position = h->position;
+	header->length = h->length;
+	header->moves = g->moves;
+	header->solves = g->solves;
+	header->play_seconds = g->play_seconds;
+	for ( int i = 0; i < g->b.n; i++ ) {
+		header->tiles[i] = (unsigned char)g->b.tiles[i];
+	}
+	unsigned int sum = checksum( header );
+	// a crash can only leave a header without its checksum, not the reverse
+	std::atomic_signal_fence( std::memory_order_seq_cst );
+	header->checksum = sum;
+	s->slot = slot;
+	s->sequence++;
+	s->dirty = true;
+}
+
+bool save_start( save_game *s, game *g ) {
+	set_layout( s, g->b.n );
+	if ( !reserve_chunk( s, SAVE_INITIAL_CHUNKS - 1 ) ) {
+		return false;
+	}
+	memcpy( chunk( s, 0 ), g->hist.keyframes, s->n );
+	g->hist.clean = 0;
+	// both slots, so a crash in the next update falls back to this game
+	save_update( s, g );
+	save_update( s, g );
+	return true;
+}
+
+void save_clear( save_game *s ) {
+	memset( slot_header( s, 0 )->magic, 0, sizeof( SAVE_MAGIC ) );
+	memset( slot_header( s, 1 )->magic, 0, sizeof( SAVE_MAGIC ) );
+	s->dirty = true;
+}
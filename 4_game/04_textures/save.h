@@ -0,0 +1,63 @@
+/******************************************************************************\
+| Crash-safe save game in a memory mapped file.                               |
+| The file is two header slots and then the move history in fixed size       |
+| chunks like the move log: chunk k is the keyframe after k * 64 moves, one  |
+| byte per slot, then those 64 moves at 2 bits each. Saving is stores into   |
+| the mapping and nothing else: the moves and keyframes changed since the    |
+| last save, then a whole header (board, history position, counters, play    |
+| time) into the slot *not* in use, its checksum last. A crash part way      |
+| leaves the other slot as it was, so loading takes the newest slot whose   |
+| checksum holds. A background thread syncs the file to disk now and then,   |
+| so the render loop never waits on it. Resuming is one map and a copy of    |
+| the chunks into the history, nothing is parsed.                            |
+\******************************************************************************/
+#ifndef _SAVE_H_
+#define _SAVE_H_
+
+#include "game.h"
+
+#define SAVE_FILE "puzzle.save"
+#define SAVE_MAGIC "PUZSAV1"
+#define SAVE_FLUSH_SECONDS 1.0
+#define SAVE_SLOT_BYTES 512
+#define SAVE_INITIAL_CHUNKS 1024 // 64K moves before the file first grows
+
+struct save_header {
+	char magic[8];
+	unsigned long long sequence; // the valid slot with the higher one is current
+	int rows;
+	int cols;
+	unsigned long long position; // history position, the board is 'tiles'
+	unsigned long long length;	 // history length, the redo tail included
+	unsigned long long moves;
+	unsigned long long solves;
+	double play_seconds;
+	unsigned char tiles[GAME_MAX_CELLS];
+	unsigned int checksum; // of every byte before it, written last
+	unsigned int reserved;
+};
+
+struct save_game;
+
+/* maps 'file_name', creating it if it is not there, and starts the thread
+that syncs it. NULL if it can not be opened */
+save_game *save_open( const char *file_name );
+
+/* syncs what is left and closes the file */
+void save_close( save_game *s );
+
+/* initialises 'g' from the saved game, like game_init(). false, with 'g'
+untouched, if there is no saved game or it does not check out */
+bool save_resume( save_game *s, game *g, const char *record_file );
+
+/* saves 'g' from scratch as the game in the file, for a new game */
+bool save_start( save_game *s, game *g );
+
+/* saves what changed in 'g' since the last save or start: stores into the
+mapping only, except when the history outgrows the file and it is grown */
+void save_update( save_game *s, game *g );
+
+/* the game is over: the next run starts a new one */
+void save_clear( save_game *s );
+
+#endif
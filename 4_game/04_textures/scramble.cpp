@@ -0,0 +1,221 @@
+#include "scramble.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXACT_SEARCH_SAMPLES 256 // fewer samples when every one is a search
+#define EXACT_SEARCH_MAX_CELLS 12 // past 3x4 random boards take too long to solve
+
+unsigned long long scramble_inversions( const int *perm, int n ) {
+	int stack_tree[SCRAMBLE_STACK_CELLS + 1];
+	int *tree = stack_tree;
+	if ( n > SCRAMBLE_STACK_CELLS ) {
+		tree = (int *)malloc( ( n + 1 ) * sizeof( int ) );
+		if ( !tree ) {
+			fprintf( stderr, "ERROR: could not allocate a Fenwick tree for %i cells\n", n );
+			unsigned long long inversions = 0;
+			for ( int i = 0; i < n; i++ ) {
+				for ( int j = i + 1; j < n; j++ ) {
+					inversions += perm[j] < perm[i];
+				}
+			}
+			return inversions;
+		}
+	}
+	memset( tree, 0, ( n + 1 ) * sizeof( int ) );
+	// right to left, counting the values already seen that are smaller
+	unsigned long long inversions = 0;
+	for ( int i = n - 1; i >= 0; i-- ) {
+		for ( int k = perm[i]; k > 0; k -= k & -k ) {
+			inversions += tree[k];
+		}
+		for ( int k = perm[i] + 1; k <= n; k += k & -k ) {
+			tree[k]++;
+		}
+	}
+	if ( tree != stack_tree ) {
+		free( tree );
+	}
+	return inversions;
+}
+
+/* blank's Manhattan distance from its goal, the last slot */
+static int blank_distance( const int *tiles, int rows, int cols ) {
+	int n = rows * cols;
+	int blank = 0;
+	while ( blank < n && tiles[blank] != n - 1 ) {
+		blank++;
+	}
+	return ( rows - 1 - blank / cols ) + ( cols - 1 - blank % cols );
+}
+
+bool scramble_is_solvable( const int *tiles, int rows, int cols ) {
+	// every move swaps the blank with a tile, flipping the parity of the whole
+	// permutation and of the blank's distance from its goal slot together
+	int n = rows * cols;
+	return ( scramble_inversions( tiles, n ) & 1 ) == (unsigned long long)( blank_distance( tiles, rows, cols ) & 1 );
+}
+
+void scramble_uniform( rng *r, int rows, int cols, int *tiles ) {
+	int n = rows * cols;
+	for ( int s = 0; s < n; s++ ) {
+		tiles[s] = s;
+	}
+	for ( int s = n - 1; s > 0; s-- ) {
+		int j = (int)rng_below( r, (unsigned int)( s + 1 ) );
+		int t = tiles[s];
+		tiles[s] = tiles[j];
+		tiles[j] = t;
+	}
+	// half of all permutations can not be solved. swapping the first two tiles
+	// that are not the blank pairs each of those with a solvable one, so the
+	// result stays uniform over the solvable boards
+	if ( !scramble_is_solvable( tiles, rows, cols ) ) {
+		int a = n - 1 == tiles[0] ? 1 : 0;
+		int b = n - 1 == tiles[a + 1] ? a + 2 : a + 1;
+		int t = tiles[a];
+		tiles[a] = tiles[b];
+		tiles[b] = t;
+	}
+}
+
+static scramble_band band_of( const scramble_generator *g, int distance ) {
+	if ( distance <= g->easy_max ) {
+		return SCRAMBLE_EASY;
+	}
+	return distance >= g->hard_min ? SCRAMBLE_HARD : SCRAMBLE_MEDIUM;
+}
+
+/* is 'tiles' in 'band'? writes the distance when it is known */
+static bool in_band( const scramble_generator *g, const int *tiles, scramble_band band,
+										 int *distance ) {
+	*distance = -1;
+	if ( SCRAMBLE_EXACT == g->measure && g->dist ) {
+		*distance = distance_table_lookup( g->dist, tiles );
+		return SCRAMBLE_ANY == band || band_of( g, *distance ) == band;
+	}
+	if ( SCRAMBLE_EXACT == g->measure && SCRAMBLE_ANY == band ) {
+		return true; // not worth a full solve
+	}
+	int h = solver_heuristic( g->s, tiles );
+	if ( SCRAMBLE_HEURISTIC == g->measure ) {
+		*distance = h;
+		return SCRAMBLE_ANY == band || band_of( g, h ) == band;
+	}
+	// exact by search. the heuristic never overestimates, so it settles some
+	// boards straight away, and every other search stops at the band's edge
+	int d;
+	switch ( band ) {
+	case SCRAMBLE_EASY:
+		if ( h > g->easy_max ) {
+			return false;
+		}
+		d = solver_distance( g->s, tiles, g->easy_max );
+		if ( d > g->easy_max ) {
+			return false;
+		}
+		*distance = d;
+		return true;
+	case SCRAMBLE_MEDIUM:
+		if ( h >= g->hard_min ) {
+			return false;
+		}
+		d = solver_distance( g->s, tiles, g->hard_min - 1 );
+		if ( d >= g->hard_min || d <= g->easy_max ) {
+			return false;
+		}
+		*distance = d;
+		return true;
+	default:
+		return h >= g->hard_min || solver_distance( g->s, tiles, g->hard_min - 1 ) >= g->hard_min;
+	}
+}
+
+static int compare_ints( const void *a, const void *b ) { return *(const int *)a - *(const int *)b; }
+
+/* band edges at the thirds of the distances of random boards */
+static void default_edges( scramble_generator *g ) {
+	bool search = SCRAMBLE_EXACT == g->measure && !g->dist;
+	if ( search && 4 == g->rows && 4 == g->cols ) {
+		g->easy_max = SCRAMBLE_4X4_EASY_MAX;
+		g->hard_min = SCRAMBLE_4X4_HARD_MIN;
+		return;
+	}
+	// boards too big to solve by the hundred get heuristic edges, which makes
+	// the easy band rare and the hard band common
+	int samples = search && g->n <= EXACT_SEARCH_MAX_CELLS ? EXACT_SEARCH_SAMPLES
+																												 : SCRAMBLE_EDGE_SAMPLES;
+	int *distances = (int *)malloc( samples * sizeof( int ) );
+	if ( !distances ) {
+		g->easy_max = 0;
+		g->hard_min = SOLVER_MAX_MOVES;
+		return;
+	}
+	// same edges whatever the seed
+	rng r;
+	rng_seed( &r, 1 );
+	int tiles[SOLVER_MAX_CELLS];
+	for ( int i = 0; i < samples; i++ ) {
+		scramble_uniform( &r, g->rows, g->cols, tiles );
+		if ( SCRAMBLE_EXACT == g->measure && g->dist ) {
+			distances[i] = distance_table_lookup( g->dist, tiles );
+		} else if ( search && g->n <= EXACT_SEARCH_MAX_CELLS ) {
+			distances[i] = solver_distance( g->s, tiles, SOLVER_MAX_MOVES );
+		} else {
+			distances[i] = solver_heuristic( g->s, tiles );
+		}
+	}
+	qsort( distances, samples, sizeof( int ), compare_ints );
+	g->easy_max = distances[samples / 3];
+	g->hard_min = distances[2 * samples / 3];
+	if ( g->hard_min < g->easy_max + 2 ) {
+		g->hard_min = g->easy_max + 2; // keep medium from being empty
+	}
+	free( distances );
+}
+
+bool scramble_init( scramble_generator *g, int rows, int cols, unsigned long long seed,
+										scramble_measure measure, const solver *s, const distance_table *dist ) {
+	memset( g, 0, sizeof( scramble_generator ) );
+	if ( !s || s->rows != rows || s->cols != cols ) {
+		fprintf( stderr, "ERROR: scramble generator needs a solver for %ix%i boards\n", rows, cols );
+		return false;
+	}
+	if ( dist && ( dist->rows != rows || dist->cols != cols ) ) {
+		fprintf( stderr, "ERROR: distance table is %ix%i, not %ix%i\n", dist->rows, dist->cols, rows,
+						 cols );
+		return false;
+	}
+	g->rows = rows;
+	g->cols = cols;
+	g->n = rows * cols;
+	g->measure = measure;
+	g->s = s;
+	g->dist = dist;
+	rng_seed( &g->r, seed );
+	default_edges( g );
+	return true;
+}
+
+void scramble_next( scramble_generator *g, scramble_band band, int *tiles, int *distance ) {
+	int d;
+	do {
+		scramble_uniform( &g->r, g->rows, g->cols, tiles );
+		g->drawn++;
+	} while ( !in_band( g, tiles, band, &d ) );
+	g->kept++;
+	if ( distance ) {
+		*distance = d;
+	}
+}
+
+bool scramble_band_from_name( const char *name, scramble_band *band ) {
+	const char *names[] = { "any", "easy", "medium", "hard" };
+	for ( int i = 0; i < 4; i++ ) {
+		if ( 0 == strcmp( name, names[i] ) ) {
+			*band = (scramble_band)i;
+			return true;
+		}
+	}
+	return false;
+}
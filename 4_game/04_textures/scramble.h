@@ -0,0 +1,73 @@
+/******************************************************************************\
+| Random start layouts.                                                        |
+| scramble_uniform() shuffles the tiles with Fisher-Yates from a seeded rng    |
+| and fixes the parity of the half of the permutations that can not be solved,|
+| so every solvable board is equally likely. The parity comes from an         |
+| O(n log n) Fenwick tree inversion count, cheap for any board size.          |
+| A scramble_generator adds difficulty bands on top by rejection sampling:     |
+| boards are drawn uniformly and kept if their distance is in the band, so the |
+| boards of a band are still uniform over that band. The distance is either   |
+| the solver's heuristic or the exact optimal distance, looked up in a         |
+| distance table or bounded by the solver: only whether the board is inside   |
+| the band is searched for, never a full solution unless that is needed.      |
+\******************************************************************************/
+#ifndef _SCRAMBLE_H_
+#define _SCRAMBLE_H_
+
+#include "distance_table.h"
+#include "rng.h"
+#include "solver.h"
+
+#define SCRAMBLE_STACK_CELLS 256	// bigger boards count inversions in heap memory
+#define SCRAMBLE_EDGE_SAMPLES 4096 // boards measured to find the default band edges
+// default exact band edges for 4x4, where sampling optimal distances is slow.
+// each band holds about a third of all boards
+#define SCRAMBLE_4X4_EASY_MAX 48
+#define SCRAMBLE_4X4_HARD_MIN 57
+
+enum scramble_band { SCRAMBLE_ANY = 0, SCRAMBLE_EASY, SCRAMBLE_MEDIUM, SCRAMBLE_HARD };
+
+enum scramble_measure {
+	SCRAMBLE_HEURISTIC, // solver_heuristic(): instant, but only a lower bound
+	SCRAMBLE_EXACT			// optimal number of moves
+};
+
+struct scramble_generator {
+	int rows;
+	int cols;
+	int n;
+	rng r;
+	scramble_measure measure;
+	const solver *s;					 // heuristic, and exact distances by search
+	const distance_table *dist; // exact distances by lookup, NULL to search
+	// easy is a distance up to easy_max, hard from hard_min, medium in between
+	int easy_max;
+	int hard_min;
+	unsigned long long drawn; // boards tried, kept or not
+	unsigned long long kept;
+};
+
+/* number of pairs i < j with perm[i] > perm[j] */
+unsigned long long scramble_inversions( const int *perm, int n );
+
+/* can the permutation in 'tiles' (blank n - 1) be slid back to solved? */
+bool scramble_is_solvable( const int *tiles, int rows, int cols );
+
+/* uniformly random solvable rows x cols board into 'tiles' */
+void scramble_uniform( rng *r, int rows, int cols, int *tiles );
+
+/* generator for rows x cols boards. 's' must be built for that size, 'dist'
+may be NULL and is only used for SCRAMBLE_EXACT. the band edges default to
+the thirds of the distances of random boards and can be changed afterwards */
+bool scramble_init( scramble_generator *g, int rows, int cols, unsigned long long seed,
+										scramble_measure measure, const solver *s, const distance_table *dist );
+
+/* draws boards until one is in 'band' and writes it to 'tiles'. 'distance'
+(may be NULL) gets its distance by the generator's measure, or -1 where an
+exact band check did not need the exact value */
+void scramble_next( scramble_generator *g, scramble_band band, int *tiles, int *distance );
+
+/* "easy", "medium", "hard" or "any" to a band. false for anything else */
+bool scramble_band_from_name( const char *name, scramble_band *band );
+
+#endif
@@ -0,0 +1,608 @@
+#include "solver.h"
+#include "thread_pool.h"
+#include "transposition_table.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// moving the same tile straight back never helps, so skip the reverse move
+static const int reverse_dir[4] = { BOARD_DOWN, BOARD_UP, BOARD_RIGHT, BOARD_LEFT };
+
+struct parallel_shared;
+
+/* state of one IDA* search. moves are made and unmade in place */
+struct search {
+	const solver *s;
+	parallel_shared *shared; // NULL for a plain single threaded search
+	unsigned long long hash; // Zobrist key of tiles, kept up to date when shared
+	unsigned char tiles[SOLVER_MAX_CELLS];
+	int blank;
+	int md; // sum of Manhattan distances
+	int lc; // sum of the linear conflict counts of all rows and columns
+	unsigned char lc_row[SOLVER_MAX_SIDE];
+	unsigned char lc_col[SOLVER_MAX_SIDE];
+	// pattern database state, only kept up to date when s->pdb is set
+	int pos_of[SOLVER_MAX_CELLS];
+	unsigned char pdb_entry[PDB_MAX_PATTERNS];
+	int pdb_sum;
+	int threshold;
+	int next_threshold;
+	int length; // of the solution once dfs() returns true
+	unsigned long long nodes;
+	board_dir path[SOLVER_MAX_MOVES];
+};
+
+/* everything the tasks of a parallel search share */
+struct parallel_shared {
+	const solver *s;
+	transposition_table tt;
+	unsigned int iteration; // bumped every threshold so old entries read as misses
+	int threshold;
+	std::atomic<int> next_threshold;
+	std::atomic<bool> stop; // someone found a solution at this threshold
+	std::atomic<unsigned long long> nodes;
+	std::mutex result_lock;
+	solver_result *result;
+	search *workers; // one scratch search per pool thread
+};
+
+/* a subtree hanging off the frontier at the split depth */
+struct parallel_task {
+	parallel_shared *shared;
+	unsigned char tiles[SOLVER_MAX_CELLS];
+	int blank;
+	int depth;
+	int prev_dir;
+	board_dir prefix[SOLVER_MAX_MOVES];
+};
+
+static double now_seconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >( steady_clock::now().time_since_epoch() ).count();
+}
+
+/* splitmix64, only used to fill the Zobrist keys */
+static unsigned long long next_key( unsigned long long *state ) {
+	unsigned long long z = ( *state += 0x9E3779B97F4A7C15ULL );
+	z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+	return z ^ ( z >> 31 );
+}
+
+/* number of tiles that have to leave the line so the rest are in goal order.
+'goals' holds the goal index along the line of every tile that belongs to it */
+static int line_conflicts( const int *goals, int count ) {
+	if ( count < 2 ) {
+		return 0;
+	}
+	// count - longest increasing subsequence. lines are at most 5 long
+	int lis[SOLVER_MAX_SIDE];
+	int longest = 0;
+	for ( int i = 0; i < count; i++ ) {
+		lis[i] = 1;
+		for ( int j = 0; j < i; j++ ) {
+			if ( goals[j] < goals[i] && lis[j] + 1 > lis[i] ) {
+				lis[i] = lis[j] + 1;
+			}
+		}
+		if ( lis[i] > longest ) {
+			longest = lis[i];
+		}
+	}
+	return count - longest;
+}
+
+static int row_conflicts( const solver *s, const unsigned char *tiles, int row ) {
+	int goals[SOLVER_MAX_SIDE];
+	int count = 0;
+	for ( int col = 0; col < s->cols; col++ ) {
+		int tile = tiles[row * s->cols + col];
+		if ( tile != s->n - 1 && tile / s->cols == row ) {
+			goals[count++] = tile % s->cols;
+		}
+	}
+	return line_conflicts( goals, count );
+}
+
+static int col_conflicts( const solver *s, const unsigned char *tiles, int col ) {
+	int goals[SOLVER_MAX_SIDE];
+	int count = 0;
+	for ( int row = 0; row < s->rows; row++ ) {
+		int tile = tiles[row * s->cols + col];
+		if ( tile != s->n - 1 && tile % s->cols == col ) {
+			goals[count++] = tile / s->cols;
+		}
+	}
+	return line_conflicts( goals, count );
+}
+
+bool solver_init( solver *s, int rows, int cols ) {
+	memset( s, 0, sizeof( solver ) );
+	if ( rows < 2 || cols < 2 || rows > SOLVER_MAX_SIDE || cols > SOLVER_MAX_SIDE ) {
+		return false;
+	}
+	s->rows = rows;
+	s->cols = cols;
+	s->n = rows * cols;
+	s->pdb = NULL;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		int row = pos / cols;
+		int col = pos % cols;
+		s->from[pos][BOARD_UP] = row < rows - 1 ? pos + cols : -1;
+		s->from[pos][BOARD_DOWN] = row > 0 ? pos - cols : -1;
+		s->from[pos][BOARD_LEFT] = col < cols - 1 ? pos + 1 : -1;
+		s->from[pos][BOARD_RIGHT] = col > 0 ? pos - 1 : -1;
+		for ( int tile = 0; tile < s->n - 1; tile++ ) {
+			s->md[tile][pos] = abs( tile / cols - row ) + abs( tile % cols - col );
+		}
+		s->md[s->n - 1][pos] = 0; // the blank does not count
+	}
+	unsigned long long seed = 0x5EED;
+	for ( int tile = 0; tile < SOLVER_MAX_CELLS; tile++ ) {
+		for ( int pos = 0; pos < SOLVER_MAX_CELLS; pos++ ) {
+			s->zobrist[tile][pos] = next_key( &seed );
+		}
+	}
+	return true;
+}
+
+bool solver_set_pdb( solver *s, const pdb_set *pdb ) {
+	if ( pdb && ( pdb->rows != s->rows || pdb->cols != s->cols ) ) {
+		return false;
+	}
+	s->pdb = pdb;
+	return true;
+}
+
+int solver_heuristic( const solver *s, const int *tiles ) {
+	unsigned char t[SOLVER_MAX_CELLS];
+	int md = 0;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		t[pos] = (unsigned char)tiles[pos];
+		md += s->md[tiles[pos]][pos];
+	}
+	int lc = 0;
+	for ( int row = 0; row < s->rows; row++ ) {
+		lc += row_conflicts( s, t, row );
+	}
+	for ( int col = 0; col < s->cols; col++ ) {
+		lc += col_conflicts( s, t, col );
+	}
+	int h = md + 2 * lc;
+	if ( s->pdb ) {
+		int h_pdb = pdb_heuristic( s->pdb, tiles );
+		if ( h_pdb > h ) {
+			h = h_pdb;
+		}
+	}
+	return h;
+}
+
+bool solver_is_solvable( const solver *s, const int *tiles ) {
+	// every move swaps the blank with a tile, flipping the parity of the whole
+	// permutation and of the blank's distance from its goal slot together
+	bool seen[SOLVER_MAX_CELLS] = { false };
+	int transpositions = 0;
+	int blank = -1;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		if ( tiles[pos] < 0 || tiles[pos] >= s->n || seen[tiles[pos]] ) {
+			return false; // not a permutation
+		}
+		seen[tiles[pos]] = true;
+		if ( tiles[pos] == s->n - 1 ) {
+			blank = pos;
+		}
+	}
+	memset( seen, 0, sizeof( seen ) );
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		int len = 0;
+		for ( int p = pos; !seen[p]; p = tiles[p] ) {
+			seen[p] = true;
+			len++;
+		}
+		if ( len > 0 ) {
+			transpositions += len - 1;
+		}
+	}
+	int blank_distance = ( s->rows - 1 - blank / s->cols ) + ( s->cols - 1 - blank % s->cols );
+	return ( transpositions & 1 ) == ( blank_distance & 1 );
+}
+
+/* both estimates count the moves on top of Manhattan distance, take the larger */
+static inline int extra_moves( const search *st ) {
+	return st->lc > st->pdb_sum ? st->lc : st->pdb_sum;
+}
+
+static bool dfs( search *st, int g, int prev_dir ) {
+	const solver *s = st->s;
+	int f = g + st->md + 2 * extra_moves( st );
+	if ( f > st->threshold ) {
+		if ( f < st->next_threshold ) {
+			st->next_threshold = f;
+		}
+		return false;
+	}
+	if ( 0 == st->md ) {
+		st->length = g; // Manhattan distance 0 means every tile is home
+		return true;
+	}
+	if ( st->shared ) {
+		parallel_shared *shared = st->shared;
+		if ( shared->stop.load( std::memory_order_relaxed ) ||
+				 tt_visit( &shared->tt, st->hash, shared->iteration, (unsigned int)g ) ) {
+			return false;
+		}
+	}
+	st->nodes++;
+	for ( int dir = 0; dir < 4; dir++ ) {
+		if ( prev_dir >= 0 && dir == reverse_dir[prev_dir] ) {
+			continue;
+		}
+		int from = s->from[st->blank][dir];
+		if ( from < 0 ) {
+			continue;
+		}
+		int to = st->blank;
+		int tile = st->tiles[from];
+		int old_md = st->md;
+		int old_lc = st->lc;
+		unsigned long long old_hash = st->hash;
+		if ( st->shared ) {
+			const int blank_tile = s->n - 1;
+			st->hash ^= s->zobrist[tile][from] ^ s->zobrist[tile][to] ^ s->zobrist[blank_tile][to] ^
+									s->zobrist[blank_tile][from];
+		}
+		st->tiles[to] = (unsigned char)tile;
+		st->tiles[from] = (unsigned char)( s->n - 1 );
+		st->blank = from;
+		st->md += s->md[tile][to] - s->md[tile][from];
+		// a vertical move changes which rows the tile is in, a horizontal one
+		// which columns. the order within the other line is untouched
+		int line_a, line_b;
+		unsigned char old_a, old_b;
+		unsigned char *lines;
+		if ( dir == BOARD_UP || dir == BOARD_DOWN ) {
+			lines = st->lc_row;
+			line_a = from / s->cols;
+			line_b = to / s->cols;
+			old_a = lines[line_a];
+			old_b = lines[line_b];
+			lines[line_a] = (unsigned char)row_conflicts( s, st->tiles, line_a );
+			lines[line_b] = (unsigned char)row_conflicts( s, st->tiles, line_b );
+		} else {
+			lines = st->lc_col;
+			line_a = from % s->cols;
+			line_b = to % s->cols;
+			old_a = lines[line_a];
+			old_b = lines[line_b];
+			lines[line_a] = (unsigned char)col_conflicts( s, st->tiles, line_a );
+			lines[line_b] = (unsigned char)col_conflicts( s, st->tiles, line_b );
+		}
+		st->lc += lines[line_a] + lines[line_b] - old_a - old_b;
+		int pattern = -1;
+		unsigned char old_entry = 0;
+		if ( s->pdb ) {
+			// only the pattern the moved tile belongs to changes
+			st->pos_of[tile] = to;
+			pattern = s->pdb->pattern_of[tile];
+			if ( pattern >= 0 ) {
+				old_entry = st->pdb_entry[pattern];
+				st->pdb_entry[pattern] = (unsigned char)pdb_lookup( s->pdb, pattern, st->pos_of );
+				st->pdb_sum += st->pdb_entry[pattern] - old_entry;
+			}
+		}
+		st->path[g] = (board_dir)dir;
+
+		if ( g + 1 < SOLVER_MAX_MOVES && dfs( st, g + 1, dir ) ) {
+			return true;
+		}
+
+		if ( s->pdb ) {
+			if ( pattern >= 0 ) {
+				st->pdb_sum -= st->pdb_entry[pattern] - old_entry;
+				st->pdb_entry[pattern] = old_entry;
+			}
+			st->pos_of[tile] = from;
+		}
+		lines[line_a] = old_a;
+		lines[line_b] = old_b;
+		st->hash = old_hash;
+		st->lc = old_lc;
+		st->md = old_md;
+		st->blank = to;
+		st->tiles[from] = (unsigned char)tile;
+		st->tiles[to] = (unsigned char)( s->n - 1 );
+	}
+	return false;
+}
+
+/* sets up 'st' at the position in 'tiles', heuristic parts and all */
+static void search_start( search *st, const solver *s, const unsigned char *tiles, int blank ) {
+	st->s = s;
+	st->shared = NULL;
+	st->md = 0;
+	st->lc = 0;
+	st->nodes = 0;
+	st->hash = 0;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		st->tiles[pos] = tiles[pos];
+		st->md += s->md[tiles[pos]][pos];
+		st->hash ^= s->zobrist[tiles[pos]][pos];
+	}
+	st->blank = blank;
+	for ( int row = 0; row < s->rows; row++ ) {
+		st->lc_row[row] = (unsigned char)row_conflicts( s, st->tiles, row );
+		st->lc += st->lc_row[row];
+	}
+	for ( int col = 0; col < s->cols; col++ ) {
+		st->lc_col[col] = (unsigned char)col_conflicts( s, st->tiles, col );
+		st->lc += st->lc_col[col];
+	}
+
+	st->pdb_sum = 0;
+	if ( s->pdb ) {
+		for ( int pos = 0; pos < s->n; pos++ ) {
+			st->pos_of[st->tiles[pos]] = pos;
+		}
+		for ( int i = 0; i < s->pdb->pattern_count; i++ ) {
+			st->pdb_entry[i] = (unsigned char)pdb_lookup( s->pdb, i, st->pos_of );
+			st->pdb_sum += st->pdb_entry[i];
+		}
+	}
+}
+
+static bool check_board( const solver *s, const board *b, solver_result *result ) {
+	result->length = 0;
+	result->nodes = 0;
+	result->seconds = 0.0;
+	result->solved = false;
+	return b->rows == s->rows && b->cols == s->cols && solver_is_solvable( s, b->tiles );
+}
+
+/* iterative deepening from the heuristic up to threshold 'limit' */
+static bool deepen( search *st, int limit ) {
+	st->threshold = st->md + 2 * extra_moves( st );
+	while ( st->threshold <= limit ) {
+		st->next_threshold = SOLVER_MAX_MOVES;
+		if ( dfs( st, 0, -1 ) ) {
+			return true;
+		}
+		st->threshold = st->next_threshold;
+	}
+	return false;
+}
+
+bool solver_solve( const solver *s, const board *b, solver_result *result ) {
+	double start = now_seconds();
+	if ( !check_board( s, b, result ) ) {
+		return false;
+	}
+
+	search *st = (search *)malloc( sizeof( search ) );
+	if ( !st ) {
+		return false;
+	}
+	unsigned char tiles[SOLVER_MAX_CELLS];
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		tiles[pos] = (unsigned char)b->tiles[pos];
+	}
+	search_start( st, s, tiles, b->blank );
+	if ( deepen( st, SOLVER_MAX_MOVES - 1 ) ) {
+		result->solved = true;
+		result->length = st->length;
+		memcpy( result->moves, st->path, st->length * sizeof( board_dir ) );
+	}
+	result->nodes = st->nodes;
+	result->seconds = now_seconds() - start;
+	free( st );
+	return result->solved;
+}
+
+int solver_distance( const solver *s, const int *tiles, int limit ) {
+	if ( !solver_is_solvable( s, tiles ) ) {
+		return -1;
+	}
+	search *st = (search *)malloc( sizeof( search ) );
+	if ( !st ) {
+		return -1;
+	}
+	unsigned char t[SOLVER_MAX_CELLS];
+	int blank = 0;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		t[pos] = (unsigned char)tiles[pos];
+		if ( tiles[pos] == s->n - 1 ) {
+			blank = pos;
+		}
+	}
+	search_start( st, s, t, blank );
+	if ( limit > SOLVER_MAX_MOVES - 1 ) {
+		limit = SOLVER_MAX_MOVES - 1;
+	}
+	int distance = deepen( st, limit ) ? st->length : limit + 1;
+	free( st );
+	return distance;
+}
+
+/* searches one frontier subtree at the current threshold */
+static void run_task( void *arg, int worker ) {
+	parallel_task *task = (parallel_task *)arg;
+	parallel_shared *shared = task->shared;
+	if ( shared->stop.load( std::memory_order_relaxed ) ) {
+		return;
+	}
+	search *st = &shared->workers[worker];
+	search_start( st, shared->s, task->tiles, task->blank );
+	st->shared = shared;
+	st->threshold = shared->threshold;
+	st->next_threshold = SOLVER_MAX_MOVES;
+	memcpy( st->path, task->prefix, task->depth * sizeof( board_dir ) );
+	bool found = dfs( st, task->depth, task->prev_dir );
+	shared->nodes += st->nodes;
+	int seen = shared->next_threshold.load( std::memory_order_relaxed );
+	while ( st->next_threshold < seen &&
+					!shared->next_threshold.compare_exchange_weak( seen, st->next_threshold ) ) {
+	}
+	if ( found ) {
+		// every solution at this threshold is optimal, keep the first one
+		std::lock_guard<std::mutex> guard( shared->result_lock );
+		if ( !shared->result->solved ) {
+			shared->result->solved = true;
+			shared->result->length = st->length;
+			memcpy( shared->result->moves, st->path, st->length * sizeof( board_dir ) );
+		}
+		shared->stop = true;
+	}
+}
+
+/* the frontier at the split depth, grown as it is walked */
+struct task_list {
+	parallel_task **tasks;
+	int count;
+	int capacity;
+	bool failed; // out of memory, the list is short
+};
+
+/* appends a copy of 'at', doubling the list when it is full */
+static bool add_task( task_list *list, const parallel_task *at ) {
+	if ( list->count == list->capacity ) {
+		int capacity = list->capacity > 0 ? 2 * list->capacity : 64;
+		parallel_task **tasks =
+			(parallel_task **)realloc( list->tasks, capacity * sizeof( parallel_task * ) );
+		if ( !tasks ) {
+			return false;
+		}
+		list->tasks = tasks;
+		list->capacity = capacity;
+	}
+	parallel_task *task = (parallel_task *)malloc( sizeof( parallel_task ) );
+	if ( !task ) {
+		return false;
+	}
+	*task = *at;
+	list->tasks[list->count++] = task;
+	return true;
+}
+
+/* walks every move sequence of length 'depth' from the root, skipping
+immediate reversals, and turns each end point into a task. every one of them
+must be searched or the solution may not be optimal, so running out of memory
+marks the list failed. returns false if it runs into the goal on the way, the
+caller then just solves serially */
+static bool split( parallel_shared *shared, parallel_task *at, int depth, task_list *list ) {
+	const solver *s = shared->s;
+	bool solved = true;
+	for ( int pos = 0; pos < s->n; pos++ ) {
+		if ( at->tiles[pos] != pos ) {
+			solved = false;
+		}
+	}
+	if ( solved ) {
+		return false;
+	}
+	if ( at->depth == depth ) {
+		if ( !list->failed && !add_task( list, at ) ) {
+			list->failed = true;
+		}
+		return true;
+	}
+	for ( int dir = 0; dir < 4; dir++ ) {
+		if ( at->prev_dir >= 0 && dir == reverse_dir[at->prev_dir] ) {
+			continue;
+		}
+		int from = s->from[at->blank][dir];
+		if ( from < 0 ) {
+			continue;
+		}
+		parallel_task next = *at;
+		next.tiles[next.blank] = next.tiles[from];
+		next.tiles[from] = (unsigned char)( s->n - 1 );
+		next.blank = from;
+		next.prefix[next.depth++] = (board_dir)dir;
+		next.prev_dir = dir;
+		if ( !split( shared, &next, depth, list ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool solver_solve_parallel( const solver *s, const board *b, const solver_parallel_options *options,
+														solver_result *result ) {
+	double start = now_seconds();
+	if ( !check_board( s, b, result ) ) {
+		return false;
+	}
+	int split_depth = options->split_depth;
+	if ( split_depth < 1 || split_depth >= SOLVER_MAX_MOVES ) {
+		split_depth = 1;
+	}
+
+	parallel_shared *shared = new parallel_shared;
+	shared->s = s;
+	shared->result = result;
+	if ( !tt_init( &shared->tt, options->tt_log2_slots > 0 ? options->tt_log2_slots : 22 ) ) {
+		delete shared;
+		return false;
+	}
+	thread_pool *pool = thread_pool_create( options->threads );
+	shared->workers = (search *)malloc( thread_pool_size( pool ) * sizeof( search ) );
+
+	task_list list = { NULL, 0, 0, false };
+	parallel_task *root = (parallel_task *)malloc( sizeof( parallel_task ) );
+	bool ok = true;
+	if ( shared->workers && root ) {
+		root->shared = shared;
+		root->blank = b->blank;
+		root->depth = 0;
+		root->prev_dir = -1;
+		for ( int pos = 0; pos < s->n; pos++ ) {
+			root->tiles[pos] = (unsigned char)b->tiles[pos];
+		}
+		ok = split( shared, root, split_depth, &list );
+	} else {
+		list.failed = true;
+	}
+	int count = list.count;
+	parallel_task **tasks = list.tasks;
+
+	if ( ok && !list.failed && count > 0 ) {
+		shared->nodes = 0;
+		shared->iteration = 0;
+		shared->threshold = solver_heuristic( s, b->tiles );
+		while ( shared->threshold < SOLVER_MAX_MOVES && !result->solved ) {
+			shared->iteration++;
+			shared->next_threshold = SOLVER_MAX_MOVES;
+			shared->stop = false;
+			for ( int i = 0; i < count; i++ ) {
+				thread_pool_submit( pool, run_task, tasks[i] );
+			}
+			thread_pool_wait( pool );
+			shared->threshold = shared->next_threshold;
+		}
+		result->nodes = shared->nodes;
+	}
+
+	for ( int i = 0; i < count; i++ ) {
+		free( tasks[i] );
+	}
+	free( tasks );
+	free( root );
+	free( shared->workers );
+	thread_pool_destroy( pool );
+	tt_free( &shared->tt );
+	delete shared;
+
+	if ( ok && list.failed ) {
+		fprintf( stderr, "ERROR: out of memory splitting the search %i moves deep\n", split_depth );
+		return false;
+	}
+	if ( !ok || 0 == count ) {
+		// the goal is within the split depth, nothing worth spreading out
+		return solver_solve( s, b, result );
+	}
+	result->seconds = now_seconds() - start;
+	return result->solved;
+}
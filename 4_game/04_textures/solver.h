@@ -0,0 +1,83 @@
+/******************************************************************************\
+| Optimal sliding puzzle solver.                                               |
+| IDA* with Manhattan distance plus linear conflicts as the heuristic. The     |
+| per-board-size tables (neighbour slot of every blank position, Manhattan    |
+| distance of every tile in every slot) are built once in solver_init() and    |
+| the heuristic is updated incrementally as the search makes and unmakes       |
+| moves, so a node costs a few table lookups.                                  |
+| Good for boards up to 5x5, but anything past 4x4 needs the pattern databases |
+| from pdb_build (see solver_set_pdb) to finish in reasonable time.           |
+\******************************************************************************/
+#ifndef _SOLVER_H_
+#define _SOLVER_H_
+
+#include "board.h"
+#include "pdb.h"
+
+#define SOLVER_MAX_SIDE 5
+#define SOLVER_MAX_CELLS ( SOLVER_MAX_SIDE * SOLVER_MAX_SIDE )
+#define SOLVER_MAX_MOVES 256
+
+struct solver {
+	int rows;
+	int cols;
+	int n;
+	// from[pos][dir] = slot of the tile that slides in direction 'dir' into a
+	// blank sitting at 'pos', or -1 if there is none
+	signed char from[SOLVER_MAX_CELLS][4];
+	// md[tile][pos] = Manhattan distance of 'tile' sitting in slot 'pos'
+	unsigned char md[SOLVER_MAX_CELLS][SOLVER_MAX_CELLS];
+	// Zobrist keys for the parallel search's transposition table
+	unsigned long long zobrist[SOLVER_MAX_CELLS][SOLVER_MAX_CELLS];
+	// optional pattern databases. the search uses whichever of them and the
+	// linear conflicts gives the larger estimate
+	const pdb_set *pdb;
+};
+
+struct solver_parallel_options {
+	int threads;			 // 0 for one per hardware thread
+	int split_depth;	 // frontier depth the tree is cut into tasks at
+	int tt_log2_slots; // transposition table size, 0 for the default 2^22
+};
+
+struct solver_result {
+	board_dir moves[SOLVER_MAX_MOVES]; // feed these to board_move() in order
+	int length;
+	unsigned long long nodes; // nodes expanded over all iterations
+	double seconds;						// wall clock
+	bool solved;
+};
+
+/* builds the move and distance tables for rows x cols boards */
+bool solver_init( solver *s, int rows, int cols );
+
+/* use the pattern databases in 'pdb' (opened for this board size) on top of
+Manhattan distance and linear conflicts. NULL switches them off again */
+bool solver_set_pdb( solver *s, const pdb_set *pdb );
+
+/* heuristic estimate of the moves left for 'tiles' (Manhattan + linear
+conflicts or pattern databases). never more than the true distance */
+int solver_heuristic( const solver *s, const int *tiles );
+
+/* is the permutation in 'tiles' reachable from the solved board? */
+bool solver_is_solvable( const solver *s, const int *tiles );
+
+/* finds a shortest move sequence that solves 'b'. returns false if the board
+is not solvable or has a different size than the solver was built for */
+bool solver_solve( const solver *s, const board *b, solver_result *result );
+
+/* number of moves an optimal solution of 'tiles' takes if that is at most
+'limit', otherwise limit + 1, and -1 if 'tiles' can not be solved. the search
+stops after the iteration at 'limit', so asking whether a board is within some
+distance is much cheaper than solving it when the answer is no */
+int solver_distance( const solver *s, const int *tiles, int limit );
+
+/* same as solver_solve() on a work-stealing thread pool. the tree is cut into
+tasks at options->split_depth and every threshold iteration runs all of them,
+sharing a lock-free transposition table keyed by the boards' Zobrist hash.
+a path is only cut off when the same board was reached at no greater cost
+in the same iteration, so the solution is still optimal */
+bool solver_solve_parallel( const solver *s, const board *b, const solver_parallel_options *options,
+														solver_result *result );
+
+#endif
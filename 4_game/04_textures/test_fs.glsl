@@ -1,8 +1,8 @@
 #version 330 core
 out vec4 FragColor;
 
-in vec3 ourColor;
 in vec2 TexCoord;
+in float Highlight;	// 1 on the hinted tile
 
 // texture sampler
 uniform sampler2D texture1;
@@ -10,4 +10,5 @@ uniform sampler2D texture1;
 void main()
 {
 	FragColor = texture(texture1, TexCoord);
-}
\ No newline at end of file
+	FragColor.rgb = mix(FragColor.rgb, vec3(1.0, 0.85, 0.2), 0.35 * Highlight);
+}
@@ -1,14 +1,49 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
-layout (location = 2) in vec2 aTexCoord;
+layout (location = 0) in vec2 aCorner;	// unit quad corner, y down
+layout (location = 1) in ivec2 aSlide;	// slot the tile gl_InstanceID slides from, to
+layout (location = 2) in float aStart;	// time that slide starts
+
+uniform ivec2 board_size;	// cols, rows
+uniform bool reveal_blank;
+uniform float time;
+uniform float slide_seconds;
+uniform int highlight_tile;	// tile id to tint for a hint, -1 for none
+uniform vec2 atlas_origin;	// texture coords of tile 0's top left corner
+uniform vec2 atlas_step;	// from one tile's corner to the next across, down
+uniform vec2 atlas_tile;	// size of a tile, without the atlas gutters
 
-out vec3 ourColor;
 out vec2 TexCoord;
+out float Highlight;
+
+// the board fills this much of the -1..1 clip space square
+const float board_extent = 0.9;
+
+vec2 slot_xy(int slot, int cols)
+{
+	return vec2(slot % cols, slot / cols);
+}
 
 void main()
 {
-	gl_Position = vec4(aPos, 1.0);
-	ourColor = aColor;
-	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-}
\ No newline at end of file
+	int cols = board_size.x;
+	int rows = board_size.y;
+	int tile = gl_InstanceID;
+	bool is_blank = tile == cols * rows - 1;
+
+	// eased 0..1 along the slide, 1 once it is over
+	float t = clamp((time - aStart) / slide_seconds, 0.0, 1.0);
+	t = t * t * (3.0 - 2.0 * t);
+	vec2 slot_pos = mix(slot_xy(aSlide.x, cols), slot_xy(aSlide.y, cols), t) + aCorner;
+	vec2 pos = slot_pos / vec2(cols, rows) * (2.0 * board_extent) - board_extent;
+	// the blank goes behind the tile sliding over it
+	float depth = is_blank && !reveal_blank ? 0.5 : 0.0;
+	gl_Position = vec4(pos.x, -pos.y, depth, 1.0);
+
+	// texture coords come from the tile, wherever it is on the board
+	TexCoord = atlas_origin + slot_xy(tile, cols) * atlas_step + aCorner * atlas_tile;
+	Highlight = tile == highlight_tile ? 1.0 : 0.0;
+	if (is_blank && !reveal_blank) {
+		// blank is drawn as a single texel from the middle of the image
+		TexCoord = vec2(0.5, 0.5);
+	}
+}
@@ -0,0 +1,135 @@
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct task {
+	task_fn fn;
+	void *arg;
+};
+
+struct worker_queue {
+	std::mutex lock;
+	std::deque<task> tasks;
+};
+
+struct thread_pool {
+	std::vector<std::thread> threads;
+	std::vector<worker_queue *> queues;
+	std::atomic<int> next_queue;
+	std::atomic<int> pending;						// submitted and not finished yet
+	std::atomic<unsigned int> submitted; // bumped under sleep_lock on every submit
+	std::atomic<bool> quit;
+	std::mutex sleep_lock;
+	std::condition_variable work_ready;
+	std::condition_variable all_done;
+};
+
+static bool pop_own( worker_queue *q, task *t ) {
+	std::lock_guard<std::mutex> guard( q->lock );
+	if ( q->tasks.empty() ) {
+		return false;
+	}
+	*t = q->tasks.back();
+	q->tasks.pop_back();
+	return true;
+}
+
+static bool steal( thread_pool *pool, int thief, task *t ) {
+	int count = (int)pool->queues.size();
+	for ( int i = 1; i < count; i++ ) {
+		worker_queue *victim = pool->queues[( thief + i ) % count];
+		std::lock_guard<std::mutex> guard( victim->lock );
+		if ( !victim->tasks.empty() ) {
+			*t = victim->tasks.front();
+			victim->tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+static void worker_main( thread_pool *pool, int index ) {
+	worker_queue *own = pool->queues[index];
+	while ( !pool->quit ) {
+		unsigned int seen = pool->submitted;
+		task t;
+		if ( pop_own( own, &t ) || steal( pool, index, &t ) ) {
+			t.fn( t.arg, index );
+			if ( 1 == pool->pending.fetch_sub( 1 ) ) {
+				std::lock_guard<std::mutex> guard( pool->sleep_lock );
+				pool->all_done.notify_all();
+			}
+			continue;
+		}
+		// only sleep if nothing was submitted since we last looked, otherwise a
+		// task pushed between the steal attempt and here would be missed
+		std::unique_lock<std::mutex> guard( pool->sleep_lock );
+		while ( !pool->quit && pool->submitted == seen ) {
+			pool->work_ready.wait( guard );
+		}
+	}
+}
+
+thread_pool *thread_pool_create( int threads ) {
+	if ( threads <= 0 ) {
+		threads = (int)std::thread::hardware_concurrency();
+		if ( threads <= 0 ) {
+			threads = 1;
+		}
+	}
+	thread_pool *pool = new thread_pool;
+	pool->next_queue = 0;
+	pool->pending = 0;
+	pool->submitted = 0;
+	pool->quit = false;
+	for ( int i = 0; i < threads; i++ ) {
+		pool->queues.push_back( new worker_queue );
+	}
+	for ( int i = 0; i < threads; i++ ) {
+		pool->threads.push_back( std::thread( worker_main, pool, i ) );
+	}
+	return pool;
+}
+
+void thread_pool_destroy( thread_pool *pool ) {
+	{
+		std::lock_guard<std::mutex> guard( pool->sleep_lock );
+		pool->quit = true;
+		pool->work_ready.notify_all();
+	}
+	for ( size_t i = 0; i < pool->threads.size(); i++ ) {
+		pool->threads[i].join();
+	}
+	for ( size_t i = 0; i < pool->queues.size(); i++ ) {
+		delete pool->queues[i];
+	}
+	delete pool;
+}
+
+int thread_pool_size( const thread_pool *pool ) { return (int)pool->threads.size(); }
+
+void thread_pool_submit( thread_pool *pool, task_fn fn, void *arg ) {
+	task t = { fn, arg };
+	// counted before it is visible, so a fast worker can never take pending below 0
+	pool->pending++;
+	int index = pool->next_queue.fetch_add( 1 ) % (int)pool->queues.size();
+	worker_queue *q = pool->queues[index];
+	{
+		std::lock_guard<std::mutex> guard( q->lock );
+		q->tasks.push_back( t );
+	}
+	std::lock_guard<std::mutex> guard( pool->sleep_lock );
+	pool->submitted++;
+	pool->work_ready.notify_one();
+}
+
+void thread_pool_wait( thread_pool *pool ) {
+	std::unique_lock<std::mutex> guard( pool->sleep_lock );
+	while ( pool->pending > 0 ) {
+		pool->all_done.wait( guard );
+	}
+}
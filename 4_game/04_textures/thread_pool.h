@@ -0,0 +1,28 @@
+/******************************************************************************\
+| Small work-stealing thread pool.                                             |
+| Every worker has its own task deque. It pops its own work from the back and |
+| when that runs dry steals from the front of another worker's deque, so a    |
+| worker that drew a big subtree does not leave the others idle.               |
+\******************************************************************************/
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+typedef void ( *task_fn )( void *arg, int worker );
+
+struct thread_pool;
+
+/* starts 'threads' workers. 0 means one per hardware thread */
+thread_pool *thread_pool_create( int threads );
+
+void thread_pool_destroy( thread_pool *pool );
+
+int thread_pool_size( const thread_pool *pool );
+
+/* queue fn( arg, worker ). tasks are dealt round-robin over the workers'
+deques, stealing evens it out from there */
+void thread_pool_submit( thread_pool *pool, task_fn fn, void *arg );
+
+/* blocks until every submitted task has finished */
+void thread_pool_wait( thread_pool *pool );
+
+#endif
@@ -0,0 +1,202 @@
+#include "tile_atlas.h"
+#include "stb_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long long fnv1a( const unsigned char *bytes, size_t size ) {
+	unsigned long long hash = 14695981039346656037ULL;
+	for ( size_t i = 0; i < size; i++ ) {
+		hash = ( hash ^ bytes[i] ) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+static size_t atlas_bytes( const tile_atlas_header *h ) {
+	return sizeof( tile_atlas_header ) + 4 * sizeof( float ) * h->rows * h->cols +
+				 4 * (size_t)h->width * h->height;
+}
+
+/* points the atlas at the uvs and pixels after header 'h' */
+static void set_from( tile_atlas *a, const tile_atlas_header *h ) {
+	a->rows = h->rows;
+	a->cols = h->cols;
+	a->tile_px = h->tile_px;
+	a->cell_px = h->cell_px;
+	a->width = h->width;
+	a->height = h->height;
+	a->uvs = (const float *)( h + 1 );
+	a->pixels = (const unsigned char *)( a->uvs + 4 * h->rows * h->cols );
+}
+
+/* maps the cache if there is one and it was made from these image bytes */
+static bool open_cache( tile_atlas *a, const char *cache_name, const tile_atlas_header *want ) {
+	// a missing cache is the usual first run, not an error
+	FILE *probe = fopen( cache_name, "rb" );
+	if ( !probe ) {
+		return false;
+	}
+	fclose( probe );
+	if ( !mapped_file_open_read( &a->file, cache_name ) ) {
+		return false;
+	}
+	const tile_atlas_header *h = (const tile_atlas_header *)a->file.data;
+	if ( a->file.size < sizeof( tile_atlas_header ) ||
+			 0 != memcmp( h->magic, TILE_ATLAS_MAGIC, sizeof( TILE_ATLAS_MAGIC ) ) ||
+			 h->rows != want->rows || h->cols != want->cols || h->gutter != want->gutter ||
+			 h->source_bytes != want->source_bytes || h->source_hash != want->source_hash ||
+			 a->file.size != atlas_bytes( h ) ) {
+		mapped_file_close( &a->file );
+		return false;
+	}
+	set_from( a, h );
+	return true;
+}
+
+/* crops 'image' to cols:rows about its middle and copies every tile into its
+cell, the gutter repeating the tile's edge pixels */
+static void slice( const tile_atlas_header *h, const unsigned char *image, int image_width,
+									 int left, int top, float *uvs, unsigned char *pixels ) {
+	int g = h->gutter;
+	for ( int tile = 0; tile < h->rows * h->cols; tile++ ) {
+		int row = tile / h->cols;
+		int col = tile % h->cols;
+		for ( int y = 0; y < h->cell_px; y++ ) {
+			int sy = y - g < 0 ? 0 : ( y - g >= h->tile_px ? h->tile_px - 1 : y - g );
+			size_t src_y = top + row * h->tile_px + sy;
+			const unsigned char *src_row = image + 4 * ( src_y * image_width + left + col * h->tile_px );
+			unsigned char *dst_row =
+				pixels + 4 * ( (size_t)( row * h->cell_px + y ) * h->width + col * h->cell_px );
+			for ( int x = 0; x < h->cell_px; x++ ) {
+				int sx = x - g < 0 ? 0 : ( x - g >= h->tile_px ? h->tile_px - 1 : x - g );
+				memcpy( dst_row + 4 * x, src_row + 4 * sx, 4 );
+			}
+		}
+		float *uv = uvs + 4 * tile;
+		uv[0] = (float)( col * h->cell_px + g ) / h->width;
+		uv[1] = (float)( row * h->cell_px + g ) / h->height;
+		uv[2] = (float)( col * h->cell_px + g + h->tile_px ) / h->width;
+		uv[3] = (float)( row * h->cell_px + g + h->tile_px ) / h->height;
+	}
+}
+
+/* the whole atlas file written beside and renamed over the old one, so a
+crash never leaves half a cache that could pass for a whole one */
+static bool write_cache( const char *cache_name, const unsigned char *bytes, size_t size ) {
+	char temp_name[1024 + 8];
+	sprintf( temp_name, "%s.tmp", cache_name );
+	FILE *file = fopen( temp_name, "wb" );
+	if ( !file ) {
+		fprintf( stderr, "ERROR: could not open %s for writing\n", temp_name );
+		return false;
+	}
+	bool ok = fwrite( bytes, 1, size, file ) == size;
+	ok = 0 == fclose( file ) && ok;
+#ifdef _WIN32
+	remove( cache_name ); // rename() does not replace on Windows
+#endif
+	if ( !ok || 0 != rename( temp_name, cache_name ) ) {
+		fprintf( stderr, "ERROR: could not write %s\n", cache_name );
+		remove( temp_name );
+		return false;
+	}
+	return true;
+}
+
+bool tile_atlas_load( tile_atlas *a, const char *image_file, int rows, int cols ) {
+	a->built = NULL;
+	a->from_cache = false;
+	mapped_file source;
+	if ( !mapped_file_open_read( &source, image_file ) ) {
+		return false;
+	}
+	tile_atlas_header want;
+	memset( &want, 0, sizeof( want ) );
+	memcpy( want.magic, TILE_ATLAS_MAGIC, sizeof( TILE_ATLAS_MAGIC ) );
+	want.rows = rows;
+	want.cols = cols;
+	want.gutter = TILE_ATLAS_GUTTER;
+	want.source_bytes = source.size;
+	want.source_hash = fnv1a( (const unsigned char *)source.data, source.size );
+	char cache_name[1024];
+	sprintf( cache_name, "%s.%ix%i.atlas", image_file, rows, cols );
+	if ( open_cache( a, cache_name, &want ) ) {
+		mapped_file_close( &source );
+		a->from_cache = true;
+		return true;
+	}
+
+	int width, height, channels;
+	unsigned char *image = stbi_load_from_memory( (const stbi_uc *)source.data, (int)source.size,
+																							 &width, &height, &channels, 4 );
+	mapped_file_close( &source );
+	if ( !image ) {
+		fprintf( stderr, "ERROR: could not decode %s: %s\n", image_file, stbi_failure_reason() );
+		return false;
+	}
+	// the biggest square tiles that fit, the crop centred on the image
+	int tile_px = width / cols < height / rows ? width / cols : height / rows;
+	if ( tile_px < 1 ) {
+		fprintf( stderr, "ERROR: %s is %ix%i, too small for a %ix%i board\n", image_file, width,
+						 height, rows, cols );
+		stbi_image_free( image );
+		return false;
+	}
+	int align = 1 << TILE_ATLAS_MIP_LEVELS;
+	want.tile_px = tile_px;
+	want.cell_px = ( tile_px + 2 * TILE_ATLAS_GUTTER + align - 1 ) / align * align;
+	want.width = cols * want.cell_px;
+	want.height = rows * want.cell_px;
+	size_t bytes = atlas_bytes( &want );
+	a->built = (unsigned char *)malloc( bytes );
+	if ( !a->built ) {
+		fprintf( stderr, "ERROR: could not allocate a %ix%i atlas\n", want.width, want.height );
+		stbi_image_free( image );
+		return false;
+	}
+	memcpy( a->built, &want, sizeof( want ) );
+	const tile_atlas_header *h = (const tile_atlas_header *)a->built;
+	float *uvs = (float *)( a->built + sizeof( tile_atlas_header ) );
+	unsigned char *pixels = (unsigned char *)( uvs + 4 * rows * cols );
+	slice( h, image, width, ( width - cols * tile_px ) / 2, ( height - rows * tile_px ) / 2, uvs,
+				 pixels );
+	stbi_image_free( image );
+	set_from( a, h );
+	// no cache only costs the next run the decode again
+	write_cache( cache_name, a->built, bytes );
+	return true;
+}
+
+void tile_atlas_free( tile_atlas *a ) {
+	if ( a->built ) {
+		free( a->built );
+		a->built = NULL;
+	} else {
+		mapped_file_close( &a->file );
+	}
+	a->uvs = NULL;
+	a->pixels = NULL;
+}
+
+GLuint tile_atlas_upload( const tile_atlas *a ) {
+	GLint max_size = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+	if ( a->width > max_size || a->height > max_size ) {
+		fprintf( stderr, "ERROR: the %ix%i atlas is over the GL's %i texture size\n", a->width,
+						 a->height, max_size );
+		return 0;
+	}
+	GLuint texture;
+	glGenTextures( 1, &texture );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, a->width, a->height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+								a->pixels );
+	// mip levels past the last the gutters keep clean would mix tiles
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, TILE_ATLAS_MIP_LEVELS );
+	glGenerateMipmap( GL_TEXTURE_2D );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	return texture;
+}
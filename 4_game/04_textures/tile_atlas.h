@@ -0,0 +1,65 @@
+/******************************************************************************\
+| The board's picture, cut into tiles.                                         |
+| Any image stb_image reads is cropped about its middle to the board's        |
+| cols:rows, so tiles are square and the whole crop is used, and each tile is |
+| copied into its own cell of an atlas with a TILE_ATLAS_GUTTER pixel border  |
+| repeating the tile's edge. Cells are a multiple of 2^TILE_ATLAS_MIP_LEVELS  |
+| pixels, so down to that mip level a texel never mixes two tiles and a tile  |
+| sampled at its edge reads its own gutter, not the neighbour's picture. The |
+| uv table (where every tile id is in the atlas) comes with it.              |
+| The result goes to a cache file next to the image, keyed on a hash of the  |
+| image file's bytes: the next run maps it and skips the decode and the      |
+| slicing.                                                                   |
+\******************************************************************************/
+#ifndef _TILE_ATLAS_H_
+#define _TILE_ATLAS_H_
+
+#include "mapped_file.h"
+#include <GL/glew.h>
+
+#define TILE_ATLAS_MAGIC "PUZATL1"
+#define TILE_ATLAS_GUTTER 8		 // pixels around every tile
+#define TILE_ATLAS_MIP_LEVELS 3 // mip levels past 0 the gutter keeps clean, log2 of it
+
+/* on-disk layout: this header, then the uv table, then the pixels */
+struct tile_atlas_header {
+	char magic[8];
+	int rows;
+	int cols;
+	int gutter;
+	int tile_px; // tile width and height in pixels
+	int cell_px; // tile plus gutters, rounded up
+	int width;
+	int height;
+	int reserved;
+	unsigned long long source_bytes;
+	unsigned long long source_hash; // FNV-1a of the image file
+};
+
+struct tile_atlas {
+	int rows;
+	int cols;
+	int tile_px;
+	int cell_px;
+	int width;
+	int height;
+	const float *uvs;						 // u0, v0, u1, v1 per tile id, v0 at the top
+	const unsigned char *pixels; // RGBA, top row first
+	mapped_file file;						 // the cache, when it is read from there
+	unsigned char *built;				 // else the header, uvs and pixels built this run
+	bool from_cache;
+};
+
+/* the atlas of 'image_file' for a rows x cols board: from the cache
+'image_file'.RxC.atlas if it is there and still matches the image, else built
+and written to it. false if the image can not be read or is smaller than a
+pixel per tile */
+bool tile_atlas_load( tile_atlas *a, const char *image_file, int rows, int cols );
+
+void tile_atlas_free( tile_atlas *a );
+
+/* a mipmapped GL_TEXTURE_2D of the atlas, bound on the current unit. 0 if it
+is too big for the GL */
+GLuint tile_atlas_upload( const tile_atlas *a );
+
+#endif
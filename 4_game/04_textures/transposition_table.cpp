@@ -0,0 +1,23 @@
+#include "transposition_table.h"
+#include <new>
+#include <stddef.h>
+
+bool tt_init( transposition_table *tt, int log2_slots ) {
+	unsigned long long count = 1ULL << log2_slots;
+	tt->slots = new ( std::nothrow ) tt_slot[count];
+	if ( !tt->slots ) {
+		return false;
+	}
+	tt->mask = count - 1;
+	for ( unsigned long long i = 0; i < count; i++ ) {
+		// iteration 0 is never used by a search, so these all read as misses
+		tt->slots[i].data.store( 0, std::memory_order_relaxed );
+		tt->slots[i].check.store( 0, std::memory_order_relaxed );
+	}
+	return true;
+}
+
+void tt_free( transposition_table *tt ) {
+	delete[] tt->slots;
+	tt->slots = NULL;
+}
@@ -0,0 +1,47 @@
+/******************************************************************************\
+| Lock-free transposition table for the parallel solver.                       |
+| Each slot is two 64 bit words: the data (search iteration and the cost the  |
+| state was reached at) and the Zobrist key xor'd with the data. A reader only |
+| trusts a slot if the two words agree, so a slot half written by another      |
+| thread just reads as a miss and no locks are needed. Slots are overwritten   |
+| freely: losing an entry only ever costs some pruning, never a solution.      |
+\******************************************************************************/
+#ifndef _TRANSPOSITION_TABLE_H_
+#define _TRANSPOSITION_TABLE_H_
+
+#include <atomic>
+
+struct tt_slot {
+	std::atomic<unsigned long long> check; // key ^ data
+	std::atomic<unsigned long long> data;	 // iteration << 32 | g
+};
+
+struct transposition_table {
+	tt_slot *slots;
+	unsigned long long mask;
+};
+
+/* 2^log2_slots slots, 16 bytes each */
+bool tt_init( transposition_table *tt, int log2_slots );
+
+void tt_free( transposition_table *tt );
+
+/* true if 'key' was already reached during 'iteration' with a cost of at most
+'g' -- whoever got there first searches the subtree with at least as much
+budget left, so this path can stop. otherwise records ( iteration, g ) */
+inline bool tt_visit( transposition_table *tt, unsigned long long key, unsigned int iteration,
+											unsigned int g ) {
+	tt_slot *slot = &tt->slots[key & tt->mask];
+	unsigned long long data = slot->data.load( std::memory_order_relaxed );
+	unsigned long long check = slot->check.load( std::memory_order_relaxed );
+	if ( ( check ^ data ) == key && ( data >> 32 ) == iteration &&
+			 ( data & 0xFFFFFFFFULL ) <= g ) {
+		return true;
+	}
+	data = ( (unsigned long long)iteration << 32 ) | g;
+	slot->data.store( data, std::memory_order_relaxed );
+	slot->check.store( key ^ data, std::memory_order_relaxed );
+	return false;
+}
+
+#endif
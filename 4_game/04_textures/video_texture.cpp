@@ -0,0 +1,221 @@
+#include "video_texture.h"
+#include "y4m.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+enum buffer_state { BUFFER_FREE, BUFFER_QUEUED, BUFFER_CONVERTING, BUFFER_READY };
+
+struct video_buffer {
+	GLuint pbo;
+	unsigned char *mapped;		// while queued, converting or ready
+	unsigned long long frame; // since the start, the video looping
+	buffer_state state;				// under the lock
+};
+
+struct video_texture {
+	y4m_video video;
+	GLuint texture;
+	size_t frame_bytes; // RGBA
+	video_buffer buffers[VIDEO_PBO_RING];
+	bool started;
+	double start_time;
+	unsigned long long next_frame; // the next to queue
+	long long shown_frame;				 // -1 before the first
+	std::mutex lock;
+	std::condition_variable wake;
+	bool quit;
+	std::thread worker;
+	video_stats stats;
+};
+
+static double now_seconds() {
+	return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() )
+		.count();
+}
+
+static void worker_main( video_texture *v ) {
+	std::unique_lock<std::mutex> guard( v->lock );
+	while ( !v->quit ) {
+		// the earliest frame queued
+		video_buffer *b = NULL;
+		for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+			video_buffer *c = &v->buffers[i];
+			if ( BUFFER_QUEUED == c->state && ( !b || c->frame < b->frame ) ) {
+				b = c;
+			}
+		}
+		if ( !b ) {
+			v->wake.wait( guard );
+			continue;
+		}
+		b->state = BUFFER_CONVERTING;
+		int frame = (int)( b->frame % v->video.frame_count );
+		guard.unlock();
+		double start = now_seconds();
+		y4m_frame_rgba( &v->video, frame, b->mapped );
+		double seconds = now_seconds() - start;
+		guard.lock();
+		b->state = BUFFER_READY;
+		v->stats.decoded++;
+		v->stats.decode_seconds += seconds;
+	}
+}
+
+video_texture *video_texture_open( const char *file_name ) {
+	video_texture *v = new video_texture;
+	if ( !y4m_open( &v->video, file_name ) ) {
+		delete v;
+		return NULL;
+	}
+	v->frame_bytes = 4 * (size_t)v->video.width * v->video.height;
+	v->started = false;
+	v->start_time = 0.0;
+	v->next_frame = 0;
+	v->shown_frame = -1;
+	v->quit = false;
+	v->stats.shown = 0;
+	v->stats.dropped = 0;
+	v->stats.decoded = 0;
+	v->stats.uploaded = 0;
+	v->stats.decode_seconds = 0.0;
+	v->stats.play_seconds = 0.0;
+
+	glGenTextures( 1, &v->texture );
+	glBindTexture( GL_TEXTURE_2D, v->texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, v->video.width, v->video.height, 0, GL_RGBA,
+								GL_UNSIGNED_BYTE, NULL );
+	// a new picture every frame, so no mipmaps to rebuild
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+		video_buffer *b = &v->buffers[i];
+		glGenBuffers( 1, &b->pbo );
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, b->pbo );
+		glBufferData( GL_PIXEL_UNPACK_BUFFER, v->frame_bytes, NULL, GL_STREAM_DRAW );
+		b->mapped = NULL;
+		b->frame = 0;
+		b->state = BUFFER_FREE;
+	}
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+	printf( "video %s: %ix%i, %.3f frames/s, %i frames\n", file_name, v->video.width,
+					v->video.height, (double)v->video.rate_num / v->video.rate_den, v->video.frame_count );
+	v->worker = std::thread( worker_main, v );
+	return v;
+}
+
+void video_texture_close( video_texture *v ) {
+	{
+		std::lock_guard<std::mutex> guard( v->lock );
+		v->quit = true;
+	}
+	v->wake.notify_one();
+	v->worker.join();
+	for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+		video_buffer *b = &v->buffers[i];
+		if ( b->mapped ) {
+			glBindBuffer( GL_PIXEL_UNPACK_BUFFER, b->pbo );
+			glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+		}
+		glDeleteBuffers( 1, &b->pbo );
+	}
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+	glDeleteTextures( 1, &v->texture );
+	y4m_close( &v->video );
+	delete v;
+}
+
+/* the buffer back to the ring, after starting the texture copy from it if
+'show' */
+static void release( video_texture *v, video_buffer *b, bool show ) {
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, b->pbo );
+	glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+	b->mapped = NULL;
+	if ( show ) {
+		// from the buffer: returns at once, the driver copies when it can
+		glBindTexture( GL_TEXTURE_2D, v->texture );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, v->video.width, v->video.height, GL_RGBA,
+										 GL_UNSIGNED_BYTE, 0 );
+		v->stats.dropped += b->frame - v->shown_frame - 1;
+		v->stats.shown++;
+		v->stats.uploaded += v->frame_bytes;
+		v->shown_frame = (long long)b->frame;
+	}
+	b->state = BUFFER_FREE;
+}
+
+bool video_texture_update( video_texture *v, double now, double *next_time ) {
+	if ( !v->started ) {
+		v->started = true;
+		v->start_time = now;
+	}
+	double seconds = now - v->start_time;
+	unsigned long long due =
+		(unsigned long long)( seconds * v->video.rate_num / v->video.rate_den );
+	v->stats.play_seconds = seconds;
+	long long shown_before = v->shown_frame;
+	{
+		std::lock_guard<std::mutex> guard( v->lock );
+		video_buffer *newest = NULL;
+		for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+			video_buffer *b = &v->buffers[i];
+			if ( BUFFER_READY == b->state && b->frame <= due ) {
+				newest = !newest || b->frame > newest->frame ? b : newest;
+			}
+		}
+		for ( int i = 0; newest && i < VIDEO_PBO_RING; i++ ) {
+			video_buffer *b = &v->buffers[i];
+			if ( BUFFER_READY == b->state && b->frame < newest->frame ) {
+				release( v, b, false ); // overtaken while it waited
+			}
+		}
+		if ( newest ) {
+			release( v, newest, true );
+		}
+		// the worker is behind: frames not started yet skip to the one due
+		if ( v->next_frame < due ) {
+			v->next_frame = due;
+		}
+		for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+			video_buffer *b = &v->buffers[i];
+			if ( BUFFER_QUEUED == b->state && b->frame < due ) {
+				b->frame = v->next_frame++;
+			}
+		}
+		for ( int i = 0; i < VIDEO_PBO_RING; i++ ) {
+			video_buffer *b = &v->buffers[i];
+			if ( BUFFER_FREE != b->state ) {
+				continue;
+			}
+			// a fresh store, so mapping never waits on a copy still reading the old one
+			glBindBuffer( GL_PIXEL_UNPACK_BUFFER, b->pbo );
+			glBufferData( GL_PIXEL_UNPACK_BUFFER, v->frame_bytes, NULL, GL_STREAM_DRAW );
+			GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+			b->mapped =
+				(unsigned char *)glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, v->frame_bytes, access );
+			if ( !b->mapped ) {
+				fprintf( stderr, "ERROR: could not map video pixel buffer %u\n", b->pbo );
+				continue;
+			}
+			b->frame = v->next_frame++;
+			b->state = BUFFER_QUEUED;
+		}
+	}
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+	v->wake.notify_one();
+	*next_time = v->shown_frame < (long long)due
+								 ? now
+								 : v->start_time + (double)( due + 1 ) * v->video.rate_den / v->video.rate_num;
+	return v->shown_frame != shown_before;
+}
+
+void video_texture_bind( const video_texture *v ) { glBindTexture( GL_TEXTURE_2D, v->texture ); }
+
+void video_texture_get_stats( video_texture *v, video_stats *stats ) {
+	std::lock_guard<std::mutex> guard( v->lock );
+	*stats = v->stats;
+}
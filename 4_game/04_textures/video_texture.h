@@ -0,0 +1,49 @@
+/******************************************************************************\
+| A texture that plays a y4m video.                                           |
+| Frames go through a ring of VIDEO_PBO_RING pixel buffers. The render loop   |
+| maps a free one and hands the pointer to a worker thread, which converts   |
+| the frame's YUV straight into it (y4m_frame_rgba, SSE2); once it is done   |
+| the render loop unmaps it and starts a glTexSubImage2D from it, which the  |
+| driver copies on its own time. So the render loop only ever maps, unmaps   |
+| and starts a copy -- it never converts a frame or waits on a transfer --   |
+| and the worker stays up to VIDEO_PBO_RING - 1 frames ahead.                 |
+| Playback follows the clock at the video's own rate, whatever the frame     |
+| rate of the game: a frame whose time has passed when a later one is ready  |
+| is skipped and counted as dropped. The video loops.                        |
+\******************************************************************************/
+#ifndef _VIDEO_TEXTURE_H_
+#define _VIDEO_TEXTURE_H_
+
+#include <GL/glew.h>
+
+#define VIDEO_PBO_RING 3
+
+struct video_stats {
+	unsigned long long shown;		 // frames put in the texture
+	unsigned long long dropped;	 // frames whose turn passed without being shown
+	unsigned long long decoded;	 // frames converted by the worker
+	unsigned long long uploaded; // bytes through the pixel buffers
+	double decode_seconds;			 // worker time converting
+	double play_seconds;				 // from the first frame to the last update
+};
+
+struct video_texture;
+
+/* maps the y4m file, makes the texture and pixel buffers and starts the
+worker. NULL on failure */
+video_texture *video_texture_open( const char *file_name );
+
+void video_texture_close( video_texture *v );
+
+/* puts the newest converted frame that is due at time 'now' in the texture
+and queues the frames after it. the clock starts at the first call. true if
+the texture changed. 'next_time' is when to call again: when the next frame
+is due, or 'now' while the worker is late with this one */
+bool video_texture_update( video_texture *v, double now, double *next_time );
+
+/* binds the texture on the current unit */
+void video_texture_bind( const video_texture *v );
+
+void video_texture_get_stats( video_texture *v, video_stats *stats );
+
+#endif
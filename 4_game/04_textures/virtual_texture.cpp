@@ -0,0 +1,470 @@
+#include "virtual_texture.h"
+#include "mapped_file.h"
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#define NO_SLOT -1
+#define LOADING_SLOT -2
+#define NO_PAGE 0xFFFFFFFFFFFFFFFFULL
+#define TOP_SLOT 0 // holds the single top level page, never evicted
+
+#define PAGE_TABLE_UNIT 2 // unit 0 is the cache, as it was the picture
+
+enum load_state { LOAD_FREE, LOAD_QUEUED, LOAD_COPYING, LOAD_DONE };
+
+struct vt_load {
+	unsigned long long page;
+	unsigned char *pixels; // VT_SLOT_PX^2 RGBA
+	load_state state;			 // under the lock
+};
+
+struct virtual_texture {
+	mapped_file file;
+	const virtual_texture_header *h;
+	const unsigned char *pages;
+	size_t page_bytes;
+	GLuint programme;
+	GLuint cache_texture;
+	GLuint page_table;
+	GLuint feedback_fbo;
+	GLuint feedback_color;
+	GLuint feedback_depth;
+	GLuint feedback_pbo[2];
+	unsigned long long feedbacks; // passes drawn, the next goes to pbo[feedbacks % 2]
+	int feedback_width;
+	int feedback_height;
+	GLint feedback_loc;
+	GLint lod_bias_loc;
+	unsigned long long frame;
+	// the cache, and where every page is: a slot, NO_SLOT or LOADING_SLOT
+	unsigned long long slot_page[VT_CACHE_SLOTS * VT_CACHE_SLOTS];
+	unsigned long long slot_used[VT_CACHE_SLOTS * VT_CACHE_SLOTS]; // frame last wanted
+	int *page_slot;
+	unsigned long long *page_seen; // frame the feedback last named the page
+	unsigned long long *wanted;		 // missing pages this frame, a feedback pixel each at most
+	int wanted_count;
+	// the loader thread and what it shares with the render loop
+	vt_load loads[VT_LOADS_IN_FLIGHT];
+	std::mutex lock;
+	std::condition_variable wake;
+	bool quit;
+	std::thread loader;
+	virtual_texture_stats stats;
+};
+
+static const unsigned char *page_pixels( const virtual_texture *v, unsigned long long page ) {
+	return v->pages + page * v->page_bytes;
+}
+
+/* level, x and y of page number 'page' */
+static void page_coords( const virtual_texture_header *h, unsigned long long page, int *level,
+												 int *x, int *y ) {
+	int l = h->levels - 1;
+	while ( page < h->first_page[l] ) {
+		l--;
+	}
+	unsigned long long i = page - h->first_page[l];
+	*level = l;
+	*x = (int)( i % h->pages_x[l] );
+	*y = (int)( i / h->pages_x[l] );
+}
+
+/* points the page table entry of 'page' at 'slot', or marks it missing */
+static void set_page_table( virtual_texture *v, unsigned long long page, int slot ) {
+	int level, x, y;
+	page_coords( v->h, page, &level, &x, &y );
+	GLubyte entry[4] = { 0, 0, 0, 0 };
+	if ( slot >= 0 ) {
+		entry[0] = (GLubyte)( slot % VT_CACHE_SLOTS );
+		entry[1] = (GLubyte)( slot / VT_CACHE_SLOTS );
+		entry[2] = 1;
+	}
+	glBindTexture( GL_TEXTURE_2D, v->page_table );
+	glTexSubImage2D( GL_TEXTURE_2D, level, x, y, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entry );
+}
+
+static void upload( virtual_texture *v, int slot, unsigned long long page,
+										const unsigned char *pixels ) {
+	glBindTexture( GL_TEXTURE_2D, v->cache_texture );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, ( slot % VT_CACHE_SLOTS ) * VT_SLOT_PX,
+									 ( slot / VT_CACHE_SLOTS ) * VT_SLOT_PX, VT_SLOT_PX, VT_SLOT_PX, GL_RGBA,
+									 GL_UNSIGNED_BYTE, pixels );
+	v->slot_page[slot] = page;
+	v->slot_used[slot] = v->frame;
+	v->page_slot[page] = slot;
+	set_page_table( v, page, slot );
+}
+
+static void loader_main( virtual_texture *v ) {
+	std::unique_lock<std::mutex> guard( v->lock );
+	while ( !v->quit ) {
+		vt_load *load = NULL;
+		for ( int i = 0; i < VT_LOADS_IN_FLIGHT && !load; i++ ) {
+			if ( LOAD_QUEUED == v->loads[i].state ) {
+				load = &v->loads[i];
+			}
+		}
+		if ( !load ) {
+			v->wake.wait( guard );
+			continue;
+		}
+		load->state = LOAD_COPYING;
+		guard.unlock();
+		// the page faults on the mapping, the disk reads, happen here
+		memcpy( load->pixels, page_pixels( v, load->page ), v->page_bytes );
+		guard.lock();
+		load->state = LOAD_DONE;
+	}
+}
+
+virtual_texture *virtual_texture_open( const char *file_name, GLuint programme, int window_width,
+																			 int window_height ) {
+	virtual_texture *v = new virtual_texture;
+	if ( !mapped_file_open_read( &v->file, file_name ) ) {
+		delete v;
+		return NULL;
+	}
+	v->h = (const virtual_texture_header *)v->file.data;
+	const virtual_texture_header *h = v->h;
+	v->page_bytes = 4 * VT_SLOT_PX * VT_SLOT_PX;
+	// the page numbers from the feedback index arrays sized from the header,
+	// so every count in it has to be the one vt_build would have written
+	bool ok = v->file.size >= VT_DATA_OFFSET &&
+						0 == memcmp( h->magic, VT_MAGIC, sizeof( VT_MAGIC ) ) && VT_PAGE_PX == h->page_px &&
+						VT_BORDER_PX == h->border_px && h->width >= 1 && h->height >= 1 &&
+						h->width <= VT_PAGE_PX << ( VT_MAX_LEVELS - 1 ) &&
+						h->height <= VT_PAGE_PX << ( VT_MAX_LEVELS - 1 );
+	if ( ok ) {
+		virtual_texture_header expected;
+		virtual_texture_layout( &expected, h->width, h->height );
+		ok = h->levels == expected.levels && h->page_count == expected.page_count &&
+				 1 == h->pages_x[h->levels - 1] * h->pages_y[h->levels - 1] &&
+				 v->file.size == VT_DATA_OFFSET + h->page_count * v->page_bytes;
+		for ( int i = 0; ok && i < expected.levels; i++ ) {
+			ok = h->pages_x[i] == expected.pages_x[i] && h->pages_y[i] == expected.pages_y[i] &&
+					 h->first_page[i] == expected.first_page[i];
+		}
+	}
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: %s is not a virtual texture from this vt_build\n", file_name );
+		mapped_file_close( &v->file );
+		delete v;
+		return NULL;
+	}
+	v->pages = (const unsigned char *)v->file.data + VT_DATA_OFFSET;
+	v->programme = programme;
+	v->frame = 1;
+	v->wanted_count = 0;
+	v->quit = false;
+	memset( &v->stats, 0, sizeof( v->stats ) );
+	// nothing made yet, so virtual_texture_close() can clean up from here on
+	v->cache_texture = 0;
+	v->page_table = 0;
+	v->feedback_fbo = 0;
+	v->feedback_color = 0;
+	v->feedback_depth = 0;
+	v->feedback_pbo[0] = 0;
+	v->feedback_pbo[1] = 0;
+	v->page_slot = NULL;
+	v->page_seen = NULL;
+	v->wanted = NULL;
+	for ( int i = 0; i < VT_LOADS_IN_FLIGHT; i++ ) {
+		v->loads[i].pixels = NULL;
+	}
+
+	// the page table is as many texels a side as level 0 has pages
+	int table_px = 1 << ( h->levels - 1 );
+	GLint max_texture_px = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_texture_px );
+	if ( table_px > max_texture_px ) {
+		fprintf( stderr, "ERROR: %s needs a %ix%i page table, GL textures go up to %i\n", file_name,
+						 table_px, table_px, max_texture_px );
+		virtual_texture_close( v );
+		return NULL;
+	}
+	v->feedback_width = ( window_width + VT_FEEDBACK_SCALE - 1 ) / VT_FEEDBACK_SCALE;
+	v->feedback_height = ( window_height + VT_FEEDBACK_SCALE - 1 ) / VT_FEEDBACK_SCALE;
+	v->page_slot = (int *)malloc( h->page_count * sizeof( int ) );
+	v->page_seen = (unsigned long long *)calloc( h->page_count, sizeof( unsigned long long ) );
+	v->wanted = (unsigned long long *)malloc( v->feedback_width * v->feedback_height *
+																						sizeof( unsigned long long ) );
+	unsigned char *zeros = (unsigned char *)calloc( (size_t)table_px * table_px, 4 );
+	bool allocated = v->page_slot && v->page_seen && v->wanted && zeros;
+	for ( int i = 0; i < VT_LOADS_IN_FLIGHT; i++ ) {
+		v->loads[i].pixels = (unsigned char *)malloc( v->page_bytes );
+		v->loads[i].state = LOAD_FREE;
+		allocated = allocated && v->loads[i].pixels;
+	}
+	if ( !allocated ) {
+		fprintf( stderr, "ERROR: out of memory for the page tables of %s\n", file_name );
+		free( zeros );
+		virtual_texture_close( v );
+		return NULL;
+	}
+	for ( unsigned long long i = 0; i < h->page_count; i++ ) {
+		v->page_slot[i] = NO_SLOT;
+	}
+	for ( int i = 0; i < VT_CACHE_SLOTS * VT_CACHE_SLOTS; i++ ) {
+		v->slot_page[i] = NO_PAGE;
+		v->slot_used[i] = 0;
+	}
+
+	// the cache: one texture of page slots, bilinear inside a page
+	glGenTextures( 1, &v->cache_texture );
+	glBindTexture( GL_TEXTURE_2D, v->cache_texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, VT_CACHE_SLOTS * VT_SLOT_PX,
+								VT_CACHE_SLOTS * VT_SLOT_PX, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+	// the page table: level l is 2^(levels-1-l) texels a side, every entry
+	// slot x, slot y and resident, all missing to start
+	glGenTextures( 1, &v->page_table );
+	glBindTexture( GL_TEXTURE_2D, v->page_table );
+	for ( int level = 0; level < h->levels; level++ ) {
+		glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA8UI, table_px >> level, table_px >> level, 0,
+									GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, zeros );
+	}
+	free( zeros );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, h->levels - 1 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+	// the feedback target, and two pixel buffers to read it back a frame late
+	v->feedbacks = 0;
+	glGenRenderbuffers( 1, &v->feedback_color );
+	glBindRenderbuffer( GL_RENDERBUFFER, v->feedback_color );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, v->feedback_width, v->feedback_height );
+	glGenRenderbuffers( 1, &v->feedback_depth );
+	glBindRenderbuffer( GL_RENDERBUFFER, v->feedback_depth );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, v->feedback_width,
+												 v->feedback_height );
+	glGenFramebuffers( 1, &v->feedback_fbo );
+	glBindFramebuffer( GL_FRAMEBUFFER, v->feedback_fbo );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+														 v->feedback_color );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+														 v->feedback_depth );
+	bool complete = GL_FRAMEBUFFER_COMPLETE == glCheckFramebufferStatus( GL_FRAMEBUFFER );
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	glGenBuffers( 2, v->feedback_pbo );
+	for ( int i = 0; i < 2; i++ ) {
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, v->feedback_pbo[i] );
+		glBufferData( GL_PIXEL_PACK_BUFFER, 4 * v->feedback_width * v->feedback_height, NULL,
+									GL_STREAM_READ );
+	}
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+	GLint size_loc = glGetUniformLocation( programme, "vt_size" );
+	GLint levels_loc = glGetUniformLocation( programme, "vt_levels" );
+	GLint page_table_loc = glGetUniformLocation( programme, "page_table" );
+	v->feedback_loc = glGetUniformLocation( programme, "vt_feedback" );
+	v->lod_bias_loc = glGetUniformLocation( programme, "vt_lod_bias" );
+	if ( !complete || size_loc < 0 || page_table_loc < 0 || v->feedback_loc < 0 ) {
+		fprintf( stderr, "ERROR: could not set up the virtual texture of %s\n", file_name );
+		virtual_texture_close( v );
+		return NULL;
+	}
+	glUseProgram( programme );
+	glUniform2f( size_loc, (float)h->width, (float)h->height );
+	glUniform1i( levels_loc, h->levels );
+	glUniform1i( page_table_loc, PAGE_TABLE_UNIT );
+	glUniform1i( v->feedback_loc, 0 );
+	glUniform1f( v->lod_bias_loc, 0.0f );
+
+	// the top page, so every lookup finds something
+	upload( v, TOP_SLOT, h->page_count - 1, page_pixels( v, h->page_count - 1 ) );
+	v->stats.resident = 1;
+	v->loader = std::thread( loader_main, v );
+	return v;
+}
+
+void virtual_texture_close( virtual_texture *v ) {
+	if ( v->loader.joinable() ) {
+		{
+			std::lock_guard<std::mutex> guard( v->lock );
+			v->quit = true;
+		}
+		v->wake.notify_one();
+		v->loader.join();
+	}
+	glDeleteBuffers( 2, v->feedback_pbo );
+	glDeleteFramebuffers( 1, &v->feedback_fbo );
+	glDeleteRenderbuffers( 1, &v->feedback_depth );
+	glDeleteRenderbuffers( 1, &v->feedback_color );
+	glDeleteTextures( 1, &v->page_table );
+	glDeleteTextures( 1, &v->cache_texture );
+	for ( int i = 0; i < VT_LOADS_IN_FLIGHT; i++ ) {
+		free( v->loads[i].pixels );
+	}
+	free( v->wanted );
+	free( v->page_seen );
+	free( v->page_slot );
+	mapped_file_close( &v->file );
+	delete v;
+}
+
+/* the page the feedback pixel names, or NO_PAGE */
+static unsigned long long feedback_page( const virtual_texture_header *h,
+																				 const unsigned char *pixel ) {
+	// r: x bits 0-7, g: x bits 8-11 and y bits 8-11, b: y bits 0-7, a: level + 1
+	int level = pixel[3] - 1;
+	int x = pixel[0] | ( pixel[1] & 15 ) << 8;
+	int y = pixel[2] | ( pixel[1] >> 4 ) << 8;
+	if ( level < 0 || level >= h->levels || x >= h->pages_x[level] || y >= h->pages_y[level] ) {
+		return NO_PAGE;
+	}
+	return h->first_page[level] + (unsigned long long)y * h->pages_x[level] + x;
+}
+
+/* the page one level up that covers 'page', or NO_PAGE at the top */
+static unsigned long long parent_page( const virtual_texture_header *h,
+																			 unsigned long long page ) {
+	int level, x, y;
+	page_coords( h, page, &level, &x, &y );
+	if ( level + 1 >= h->levels ) {
+		return NO_PAGE;
+	}
+	return h->first_page[level + 1] + (unsigned long long)( y / 2 ) * h->pages_x[level + 1] + x / 2;
+}
+
+/* notes everything the last feedback asked for: resident pages, and the
+resident page drawn instead of a missing one, are used this frame */
+static void read_feedback( virtual_texture *v, const unsigned char *pixels ) {
+	const virtual_texture_header *h = v->h;
+	v->wanted_count = 0;
+	for ( int i = 0; i < v->feedback_width * v->feedback_height; i++ ) {
+		unsigned long long page = feedback_page( h, pixels + 4 * i );
+		if ( NO_PAGE == page || v->page_seen[page] == v->frame ) {
+			continue;
+		}
+		v->page_seen[page] = v->frame;
+		v->stats.requested++;
+		if ( NO_SLOT == v->page_slot[page] ) {
+			v->wanted[v->wanted_count++] = page;
+		}
+		while ( NO_PAGE != page && v->page_slot[page] < 0 ) {
+			page = parent_page( h, page );
+		}
+		if ( NO_PAGE != page && TOP_SLOT != v->page_slot[page] ) {
+			v->slot_used[v->page_slot[page]] = v->frame;
+		}
+	}
+}
+
+/* the slot not used this frame that was used longest ago, -1 if all were */
+static int victim_slot( const virtual_texture *v ) {
+	int best = -1;
+	for ( int i = 0; i < VT_CACHE_SLOTS * VT_CACHE_SLOTS; i++ ) {
+		if ( TOP_SLOT != i && v->slot_used[i] < v->frame &&
+				 ( best < 0 || v->slot_used[i] < v->slot_used[best] ) ) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+static int coarser_first( const void *a, const void *b ) {
+	// pages are numbered level by level, so a higher number is coarser
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+	return x < y ? 1 : ( x > y ? -1 : 0 );
+}
+
+bool virtual_texture_update( virtual_texture *v ) {
+	// the older of the two feedback passes in flight: the frame before last,
+	// long since finished on the GPU, so mapping it does not wait
+	if ( v->feedbacks >= 2 ) {
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, v->feedback_pbo[v->feedbacks % 2] );
+		const unsigned char *pixels =
+			(const unsigned char *)glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+		if ( pixels ) {
+			read_feedback( v, pixels );
+			glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+		}
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	}
+	// coarse pages first: one of them stands in for four finer ones
+	qsort( v->wanted, v->wanted_count, sizeof( unsigned long long ), coarser_first );
+
+	int uploads = 0;
+	bool loading = v->wanted_count > 0;
+	{
+		std::lock_guard<std::mutex> guard( v->lock );
+		int next = 0;
+		for ( int i = 0; i < VT_LOADS_IN_FLIGHT; i++ ) {
+			vt_load *load = &v->loads[i];
+			if ( LOAD_DONE == load->state && uploads < VT_UPLOADS_PER_FRAME ) {
+				int slot = victim_slot( v );
+				if ( slot < 0 ) {
+					// the view needs more pages than the cache holds
+					v->page_slot[load->page] = NO_SLOT;
+					v->stats.dropped++;
+				} else {
+					if ( NO_PAGE != v->slot_page[slot] ) {
+						v->page_slot[v->slot_page[slot]] = NO_SLOT;
+						set_page_table( v, v->slot_page[slot], NO_SLOT );
+						v->stats.evicted++;
+					} else {
+						v->stats.resident++;
+					}
+					upload( v, slot, load->page, load->pixels );
+					v->stats.uploaded++;
+					uploads++;
+				}
+				load->state = LOAD_FREE;
+			}
+			if ( LOAD_FREE == load->state && next < v->wanted_count ) {
+				load->page = v->wanted[next++];
+				load->state = LOAD_QUEUED;
+				v->page_slot[load->page] = LOADING_SLOT;
+			}
+			loading |= LOAD_FREE != load->state;
+		}
+		v->wanted_count = 0;
+	}
+	v->wake.notify_one();
+	v->frame++;
+	return loading || uploads > 0;
+}
+
+void virtual_texture_begin_feedback( virtual_texture *v ) {
+	glBindFramebuffer( GL_FRAMEBUFFER, v->feedback_fbo );
+	glViewport( 0, 0, v->feedback_width, v->feedback_height );
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glUseProgram( v->programme );
+	glUniform1i( v->feedback_loc, 1 );
+	// the mip level the full size window will want, not this small one
+	glUniform1f( v->lod_bias_loc, -log2f( (float)VT_FEEDBACK_SCALE ) );
+}
+
+void virtual_texture_end_feedback( virtual_texture *v, int window_width, int window_height ) {
+	// into a pixel buffer: the copy happens on the GPU's time, not ours
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, v->feedback_pbo[v->feedbacks % 2] );
+	glReadPixels( 0, 0, v->feedback_width, v->feedback_height, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	v->feedbacks++;
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	glViewport( 0, 0, window_width, window_height );
+	glUniform1i( v->feedback_loc, 0 );
+	glUniform1f( v->lod_bias_loc, 0.0f );
+}
+
+void virtual_texture_bind( const virtual_texture *v ) {
+	glActiveTexture( GL_TEXTURE0 + PAGE_TABLE_UNIT );
+	glBindTexture( GL_TEXTURE_2D, v->page_table );
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, v->cache_texture );
+}
+
+void virtual_texture_get_stats( const virtual_texture *v, virtual_texture_stats *stats ) {
+	*stats = v->stats;
+}
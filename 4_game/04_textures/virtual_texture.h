@@ -0,0 +1,118 @@
+/******************************************************************************\
+| Sparse virtual texturing, for pictures far too big for one texture.         |
+| vt_build cuts the picture into a mip pyramid of pages on disk: 128x128     |
+| pixels plus a 1 pixel border copied from the neighbours, so bilinear        |
+| filtering never sees a page edge. At run time only a fixed cache of page  |
+| slots lives on the GPU, one texture of VT_CACHE_SLOTS x VT_CACHE_SLOTS     |
+| pages, and a page table (one texel per page, a mip level per pyramid level) |
+| says which slot holds what. The fragment shader walks up from the level it |
+| wants to the first one that is resident, so something is always drawn --  |
+| the single top page is loaded at open and never leaves.                    |
+| Which pages are wanted comes from a feedback pass: the board drawn at      |
+| 1/VT_FEEDBACK_SCALE size with every pixel writing the page it would read,  |
+| read back through a pixel buffer a frame later so the GPU is never waited  |
+| on. Missing pages are copied out of the mapped file on a loader thread and |
+| uploaded a few a frame into the least recently used slot. GPU memory is   |
+| the cache plus the page table whatever the size of the picture (the table |
+| is one 4 byte texel per 16K pixels).                                       |
+\******************************************************************************/
+#ifndef _VIRTUAL_TEXTURE_H_
+#define _VIRTUAL_TEXTURE_H_
+
+#include <GL/glew.h>
+#include <string.h>
+
+#define VT_MAGIC "PUZVTX1"
+#define VT_PAGE_PX 128
+#define VT_BORDER_PX 1
+#define VT_SLOT_PX ( VT_PAGE_PX + 2 * VT_BORDER_PX )
+// pictures up to 128 << 12 = 512K pixels across: the feedback pass has 12
+// bits for a page's x and y, and the page table is 4096 texels a side
+#define VT_MAX_LEVELS 13
+#define VT_HEADER_LEVELS 16 // room in the file header, kept for files already built
+#define VT_DATA_OFFSET 4096
+#define VT_CACHE_SLOTS 16						// a side: 256 pages, 17 MB of cache
+#define VT_FEEDBACK_SCALE 8					// feedback pass at 1/8 of the window
+#define VT_LOADS_IN_FLIGHT 32				// pages queued or loaded, not yet uploaded
+#define VT_UPLOADS_PER_FRAME 8
+
+/* on-disk layout: this header, then from VT_DATA_OFFSET every page of every
+level, level 0 first, each level's pages row by row. a page is VT_SLOT_PX
+rows of VT_SLOT_PX RGBA pixels, the border included */
+struct virtual_texture_header {
+	char magic[8];
+	int width; // level 0 pixels
+	int height;
+	int page_px;
+	int border_px;
+	int levels; // the last is a single page
+	int reserved;
+	int pages_x[VT_HEADER_LEVELS];
+	int pages_y[VT_HEADER_LEVELS];
+	unsigned long long first_page[VT_HEADER_LEVELS];
+	unsigned long long page_count;
+};
+
+struct virtual_texture_stats {
+	int resident; // pages in the cache
+	unsigned long long requested;
+	unsigned long long uploaded;
+	unsigned long long evicted;
+	unsigned long long dropped; // loaded but every slot was in use this frame
+};
+
+struct virtual_texture;
+
+/* fills in the level sizes and page counts of a width x height picture.
+here so vt_build does not need GL */
+inline void virtual_texture_layout( virtual_texture_header *h, int width, int height ) {
+	memset( h, 0, sizeof( virtual_texture_header ) );
+	memcpy( h->magic, VT_MAGIC, sizeof( VT_MAGIC ) );
+	h->width = width;
+	h->height = height;
+	h->page_px = VT_PAGE_PX;
+	h->border_px = VT_BORDER_PX;
+	unsigned long long first = 0;
+	int level = 0;
+	while ( level < VT_MAX_LEVELS ) {
+		// a level is its parent halved, rounding up
+		int level_width = ( width + ( 1 << level ) - 1 ) >> level;
+		int level_height = ( height + ( 1 << level ) - 1 ) >> level;
+		h->pages_x[level] = ( level_width + VT_PAGE_PX - 1 ) / VT_PAGE_PX;
+		h->pages_y[level] = ( level_height + VT_PAGE_PX - 1 ) / VT_PAGE_PX;
+		h->first_page[level] = first;
+		first += (unsigned long long)h->pages_x[level] * h->pages_y[level];
+		level++;
+		if ( 1 == h->pages_x[level - 1] && 1 == h->pages_y[level - 1] ) {
+			break;
+		}
+	}
+	h->levels = level;
+	h->page_count = first;
+}
+
+/* maps a vt_build file, makes the cache, page table and feedback buffers for
+a window of window_width x window_height and starts the loader. 'programme'
+is the linked test_vs.glsl/vt_fs.glsl pair. NULL on failure */
+virtual_texture *virtual_texture_open( const char *file_name, GLuint programme, int window_width,
+																			 int window_height );
+
+void virtual_texture_close( virtual_texture *v );
+
+/* reads the feedback of the frame before last, asks the loader for the missing
+pages and uploads up to VT_UPLOADS_PER_FRAME loaded ones. call once a frame.
+true while pages are on their way: keep drawing frames until it is false,
+then two more for the feedback still in flight */
+bool virtual_texture_update( virtual_texture *v );
+
+/* between these, draw the scene as usual: it goes to the feedback buffer
+and is read back for the update of the next frame */
+void virtual_texture_begin_feedback( virtual_texture *v );
+void virtual_texture_end_feedback( virtual_texture *v, int window_width, int window_height );
+
+/* binds the cache and page table for the real draw */
+void virtual_texture_bind( const virtual_texture *v );
+
+void virtual_texture_get_stats( const virtual_texture *v, virtual_texture_stats *stats );
+
+#endif
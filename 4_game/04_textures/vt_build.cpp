@@ -0,0 +1,163 @@
+/******************************************************************************\
+| Cuts a picture into the page pyramid of a virtual texture.                  |
+|   ./vt_build <image> <output file>                                         |
+|   ./vt_build <raw RGBA file> <width> <height> <output file>                |
+| Any image stb_image reads, or for pictures too big to decode in memory    |
+| (64K x 64K is 16 GB) raw RGBA rows, which are mapped and never read whole. |
+| The output is mapped at its full size up front and filled in place: level  |
+| 0 pages straight from the picture, then every level from the pages of the  |
+| one before, each pixel the average of four. Each page carries a border of  |
+| its neighbours' pixels, the picture's edge repeated at the outside.         |
+\******************************************************************************/
+#include "virtual_texture.h"
+#include "mapped_file.h"
+#include "stb_image.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_STRIDE ( 4 * VT_SLOT_PX )
+#define PAGE_BYTES ( VT_SLOT_PX * LINE_STRIDE )
+
+static double now_seconds() {
+	return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() )
+		.count();
+}
+
+static int clamp( int i, int low, int high ) { return i < low ? low : ( i > high ? high : i ); }
+
+static unsigned char *page_at( unsigned char *pages, const virtual_texture_header *h, int level,
+															 int x, int y ) {
+	return pages +
+				 ( h->first_page[level] + (unsigned long long)y * h->pages_x[level] + x ) * PAGE_BYTES;
+}
+
+/* pixel (x, y) of 'level', already built, from inside its page */
+static const unsigned char *level_pixel( unsigned char *pages, const virtual_texture_header *h,
+																				 int level, int x, int y ) {
+	const unsigned char *page = page_at( pages, h, level, x / VT_PAGE_PX, y / VT_PAGE_PX );
+	return page + ( y % VT_PAGE_PX + VT_BORDER_PX ) * LINE_STRIDE +
+				 4 * ( x % VT_PAGE_PX + VT_BORDER_PX );
+}
+
+static void build_level_0( unsigned char *pages, const virtual_texture_header *h,
+													 const unsigned char *picture ) {
+	size_t stride = 4 * (size_t)h->width;
+	for ( int py = 0; py < h->pages_y[0]; py++ ) {
+		for ( int px = 0; px < h->pages_x[0]; px++ ) {
+			unsigned char *page = page_at( pages, h, 0, px, py );
+			for ( int y = 0; y < VT_SLOT_PX; y++ ) {
+				int sy = clamp( py * VT_PAGE_PX + y - VT_BORDER_PX, 0, h->height - 1 );
+				const unsigned char *row = picture + sy * stride;
+				for ( int x = 0; x < VT_SLOT_PX; x++ ) {
+					int sx = clamp( px * VT_PAGE_PX + x - VT_BORDER_PX, 0, h->width - 1 );
+					memcpy( page + y * LINE_STRIDE + 4 * x, row + 4 * sx, 4 );
+				}
+			}
+		}
+	}
+}
+
+static void build_level( unsigned char *pages, const virtual_texture_header *h, int level ) {
+	int below = level - 1;
+	int below_width = ( h->width + ( 1 << below ) - 1 ) >> below;
+	int below_height = ( h->height + ( 1 << below ) - 1 ) >> below;
+	int width = ( h->width + ( 1 << level ) - 1 ) >> level;
+	int height = ( h->height + ( 1 << level ) - 1 ) >> level;
+	for ( int py = 0; py < h->pages_y[level]; py++ ) {
+		for ( int px = 0; px < h->pages_x[level]; px++ ) {
+			unsigned char *page = page_at( pages, h, level, px, py );
+			for ( int y = 0; y < VT_SLOT_PX; y++ ) {
+				int ly = clamp( py * VT_PAGE_PX + y - VT_BORDER_PX, 0, height - 1 );
+				int y0 = clamp( 2 * ly, 0, below_height - 1 );
+				int y1 = clamp( 2 * ly + 1, 0, below_height - 1 );
+				for ( int x = 0; x < VT_SLOT_PX; x++ ) {
+					int lx = clamp( px * VT_PAGE_PX + x - VT_BORDER_PX, 0, width - 1 );
+					int x0 = clamp( 2 * lx, 0, below_width - 1 );
+					int x1 = clamp( 2 * lx + 1, 0, below_width - 1 );
+					const unsigned char *a = level_pixel( pages, h, below, x0, y0 );
+					const unsigned char *b = level_pixel( pages, h, below, x1, y0 );
+					const unsigned char *c = level_pixel( pages, h, below, x0, y1 );
+					const unsigned char *d = level_pixel( pages, h, below, x1, y1 );
+					unsigned char *out = page + y * LINE_STRIDE + 4 * x;
+					for ( int i = 0; i < 4; i++ ) {
+						out[i] = (unsigned char)( ( a[i] + b[i] + c[i] + d[i] + 2 ) / 4 );
+					}
+				}
+			}
+		}
+	}
+}
+
+int main( int argc, char **argv ) {
+	if ( 3 != argc && 5 != argc ) {
+		fprintf( stderr, "usage: %s <image> <output file>\n"
+										 "       %s <raw RGBA file> <width> <height> <output file>\n",
+						 argv[0], argv[0] );
+		return 1;
+	}
+	const char *output = argv[argc - 1];
+	double start = now_seconds();
+	int width, height;
+	unsigned char *decoded = NULL;
+	mapped_file raw;
+	const unsigned char *picture;
+	if ( 5 == argc ) {
+		width = atoi( argv[2] );
+		height = atoi( argv[3] );
+		if ( width < 1 || height < 1 || !mapped_file_open_read( &raw, argv[1] ) ) {
+			return 1;
+		}
+		if ( raw.size != 4 * (size_t)width * height ) {
+			fprintf( stderr, "ERROR: %s is %zu bytes, not %ix%i RGBA\n", argv[1], raw.size, width,
+							 height );
+			return 1;
+		}
+		picture = (const unsigned char *)raw.data;
+	} else {
+		int channels;
+		decoded = stbi_load( argv[1], &width, &height, &channels, 4 );
+		if ( !decoded ) {
+			fprintf( stderr, "ERROR: could not decode %s: %s\n", argv[1], stbi_failure_reason() );
+			return 1;
+		}
+		picture = decoded;
+	}
+
+	virtual_texture_header h;
+	virtual_texture_layout( &h, width, height );
+	if ( 1 != h.pages_x[h.levels - 1] * h.pages_y[h.levels - 1] ) {
+		fprintf( stderr, "ERROR: %ix%i is too big for %i levels of %i pixel pages\n", width, height,
+						 VT_MAX_LEVELS, VT_PAGE_PX );
+		return 1;
+	}
+	// a file from an earlier, bigger picture would keep its tail
+	remove( output );
+	mapped_file out;
+	size_t size = VT_DATA_OFFSET + h.page_count * PAGE_BYTES;
+	if ( !mapped_file_open_write( &out, output, size ) ) {
+		return 1;
+	}
+	unsigned char *pages = (unsigned char *)out.writable + VT_DATA_OFFSET;
+	build_level_0( pages, &h, picture );
+	if ( decoded ) {
+		stbi_image_free( decoded );
+	} else {
+		mapped_file_close( &raw );
+	}
+	for ( int level = 1; level < h.levels; level++ ) {
+		build_level( pages, &h, level );
+	}
+	// the header last, so a build cut short is not a valid file
+	memcpy( out.writable, &h, sizeof( h ) );
+	bool ok = mapped_file_flush( &out );
+	mapped_file_close( &out );
+	if ( !ok ) {
+		fprintf( stderr, "ERROR: could not write %s\n", output );
+		return 1;
+	}
+	printf( "%s: %ix%i, %i levels, %llu pages, %.1f MB in %.2f s\n", output, width, height, h.levels,
+					h.page_count, size / ( 1024.0 * 1024.0 ), now_seconds() - start );
+	return 0;
+}
@@ -0,0 +1,60 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in float Highlight;	// 1 on the hinted tile
+
+// the page cache, VT_CACHE_SLOTS x VT_CACHE_SLOTS slots of bordered pages
+uniform sampler2D texture1;
+// per pyramid level, one texel per page: slot x, slot y, resident
+uniform usampler2D page_table;
+uniform vec2 vt_size;	// level 0 pixels
+uniform int vt_levels;
+uniform bool vt_feedback;	// write the page wanted instead of the colour
+uniform float vt_lod_bias;	// makes up for the feedback pass's smaller size
+
+// must match virtual_texture.h
+const float page_px = 128.0;
+const float border_px = 1.0;
+const float slot_px = page_px + 2.0 * border_px;
+const float cache_slots = 16.0;
+
+ivec2 page_at(vec2 texel, int level)
+{
+	// a level is its parent halved rounding up, and the last page may be part full
+	vec2 level_size = ceil(vt_size / exp2(float(level)));
+	vec2 last = floor((level_size - 1.0) / page_px);
+	return ivec2(min(floor(texel / exp2(float(level)) / page_px), last));
+}
+
+void main()
+{
+	vec2 texel = clamp(TexCoord, 0.0, 1.0) * vt_size;
+	// the mip level the texture hardware would pick
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vt_lod_bias;
+	int level = clamp(int(floor(lod)), 0, vt_levels - 1);
+
+	if (vt_feedback) {
+		// r: x bits 0-7, g: x bits 8-11 and y bits 8-11, b: y bits 0-7, a: level + 1
+		ivec2 page = page_at(texel, level);
+		ivec4 bytes = ivec4(page.x & 255, ((page.x >> 8) & 15) | (((page.y >> 8) & 15) << 4),
+			page.y & 255, level + 1);
+		FragColor = vec4(bytes) / 255.0;
+		return;
+	}
+
+	// the finest resident page covering the texel, at worst the top one
+	ivec2 page = page_at(texel, level);
+	uvec4 entry = texelFetch(page_table, page, level);
+	while (entry.b == 0u && level < vt_levels - 1) {
+		level++;
+		page = page_at(texel, level);
+		entry = texelFetch(page_table, page, level);
+	}
+	vec2 in_page = texel / exp2(float(level)) - vec2(page) * page_px;
+	vec2 cache_texel = vec2(entry.rg) * slot_px + border_px + in_page;
+	FragColor = textureLod(texture1, cache_texel / (cache_slots * slot_px), 0.0);
+	FragColor.rgb = mix(FragColor.rgb, vec3(1.0, 0.85, 0.2), 0.35 * Highlight);
+}
@@ -0,0 +1,245 @@
+#include "wall_renderer.h"
+#include "board_renderer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INFO_TEXTURE_UNIT 1 // unit 0 is the picture
+
+bool wall_renderer_init( wall_renderer *r, const board *boards, int count, GLuint programme ) {
+	// the same unit quad as board_renderer, y down
+	float quad[] = {
+		0.0f, 0.0f, // top left
+		1.0f, 0.0f, // top right
+		1.0f, 1.0f, // bottom right
+		0.0f, 1.0f	// bottom left
+	};
+	unsigned int indices[] = {
+		0, 1, 2, // first triangle
+		0, 2, 3	 // second triangle
+	};
+
+	if ( !GLEW_VERSION_4_3 && !GLEW_ARB_multi_draw_indirect ) {
+		fprintf( stderr, "ERROR: the wall renderer needs GL 4.3 or ARB_multi_draw_indirect\n" );
+		return false;
+	}
+	GLint max_texels = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels );
+	if ( count > max_texels ) {
+		fprintf( stderr, "ERROR: %i boards, but buffer textures only hold %i\n", count, max_texels );
+		return false;
+	}
+	r->programme = programme;
+	r->board_count = count;
+	r->wall_cols = (int)ceil( sqrt( (double)count ) );
+	r->wall_rows = ( count + r->wall_cols - 1 ) / r->wall_cols;
+	r->slide_seconds = (float)BOARD_RENDERER_SLIDE_SECONDS;
+	r->changed_first = count;
+	r->changed_last = -1;
+	r->bytes_uploaded = 0;
+
+	int total = 0;
+	for ( int i = 0; i < count; i++ ) {
+		total += boards[i].n;
+	}
+	r->first_instance = (int *)malloc( ( count + 1 ) * sizeof( int ) );
+	r->instances = (wall_instance *)malloc( total * sizeof( wall_instance ) );
+	r->commands = (wall_command *)malloc( count * sizeof( wall_command ) );
+	GLint *info = (GLint *)malloc( 2 * count * sizeof( GLint ) );
+	if ( !r->first_instance || !r->instances || !r->commands || !info ) {
+		fprintf( stderr, "ERROR: could not allocate %i boards of %i tiles\n", count, total );
+		free( info );
+		return false;
+	}
+	// every tile at rest in its slot, and one command per board
+	int first = 0;
+	for ( int i = 0; i < count; i++ ) {
+		const board *b = &boards[i];
+		r->first_instance[i] = first;
+		for ( int slot = 0; slot < b->n; slot++ ) {
+			wall_instance *t = &r->instances[first + b->tiles[slot]];
+			t->from_slot = slot;
+			t->to_slot = slot;
+			t->start_time = -r->slide_seconds;
+			t->board = i;
+		}
+		wall_command *c = &r->commands[i];
+		c->count = 6;
+		c->instance_count = (GLuint)b->n;
+		c->first_index = 0;
+		c->base_vertex = 0;
+		c->base_instance = (GLuint)first;
+		info[2 * i] = b->cols;
+		info[2 * i + 1] = b->rows;
+		first += b->n;
+	}
+	r->first_instance[count] = total;
+
+	glGenVertexArrays( 1, &r->vao );
+	glGenBuffers( 1, &r->quad_vbo );
+	glGenBuffers( 1, &r->quad_ebo );
+	glGenBuffers( 1, &r->tile_vbo );
+	glGenBuffers( 1, &r->command_buffer );
+	glGenBuffers( 1, &r->info_buffer );
+	glGenTextures( 1, &r->info_texture );
+	glBindVertexArray( r->vao );
+
+	glBindBuffer( GL_ARRAY_BUFFER, r->quad_vbo );
+	glBufferData( GL_ARRAY_BUFFER, sizeof( quad ), quad, GL_STATIC_DRAW );
+	// corner attribute
+	glVertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof( float ), (void *)0 );
+	glEnableVertexAttribArray( 0 );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, r->quad_ebo );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( indices ), indices, GL_STATIC_DRAW );
+
+	// the instances of every board. the command's base instance is where a
+	// board's tiles start, gl_InstanceID counts its tiles from 0
+	glBindBuffer( GL_ARRAY_BUFFER, r->tile_vbo );
+	glBufferData( GL_ARRAY_BUFFER, total * sizeof( wall_instance ), r->instances, GL_DYNAMIC_DRAW );
+	// from and to slot attribute
+	glVertexAttribIPointer( 1, 2, GL_INT, sizeof( wall_instance ), (void *)0 );
+	glVertexAttribDivisor( 1, 1 );
+	glEnableVertexAttribArray( 1 );
+	// start time attribute
+	glVertexAttribPointer( 2, 1, GL_FLOAT, GL_FALSE, sizeof( wall_instance ),
+												 (void *)( 2 * sizeof( GLint ) ) );
+	glVertexAttribDivisor( 2, 1 );
+	glEnableVertexAttribArray( 2 );
+	// board attribute
+	glVertexAttribIPointer( 3, 1, GL_INT, sizeof( wall_instance ),
+													(void *)( 2 * sizeof( GLint ) + sizeof( GLfloat ) ) );
+	glVertexAttribDivisor( 3, 1 );
+	glEnableVertexAttribArray( 3 );
+
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, r->command_buffer );
+	glBufferData( GL_DRAW_INDIRECT_BUFFER, count * sizeof( wall_command ), r->commands,
+								GL_DYNAMIC_DRAW );
+
+	glBindBuffer( GL_TEXTURE_BUFFER, r->info_buffer );
+	glBufferData( GL_TEXTURE_BUFFER, 2 * count * sizeof( GLint ), info, GL_STATIC_DRAW );
+	glBindTexture( GL_TEXTURE_BUFFER, r->info_texture );
+	glTexBuffer( GL_TEXTURE_BUFFER, GL_RG32I, r->info_buffer );
+	free( info );
+
+	r->time_loc = glGetUniformLocation( programme, "time" );
+	r->slide_seconds_loc = glGetUniformLocation( programme, "slide_seconds" );
+	r->wall_size_loc = glGetUniformLocation( programme, "wall_size" );
+	r->board_info_loc = glGetUniformLocation( programme, "board_info" );
+	if ( r->time_loc < 0 || r->wall_size_loc < 0 || r->board_info_loc < 0 ) {
+		fprintf( stderr, "ERROR: wall uniforms not found in shader programme %u\n", programme );
+		return false;
+	}
+	glUseProgram( programme );
+	glUniform2i( r->wall_size_loc, r->wall_cols, r->wall_rows );
+	glUniform1f( r->slide_seconds_loc, r->slide_seconds );
+	glUniform1i( r->board_info_loc, INFO_TEXTURE_UNIT );
+	return true;
+}
+
+void wall_renderer_free( wall_renderer *r ) {
+	glDeleteTextures( 1, &r->info_texture );
+	glDeleteBuffers( 1, &r->info_buffer );
+	glDeleteBuffers( 1, &r->command_buffer );
+	glDeleteBuffers( 1, &r->tile_vbo );
+	glDeleteBuffers( 1, &r->quad_ebo );
+	glDeleteBuffers( 1, &r->quad_vbo );
+	glDeleteVertexArrays( 1, &r->vao );
+	free( r->first_instance );
+	free( r->instances );
+	free( r->commands );
+	r->first_instance = NULL;
+	r->instances = NULL;
+	r->commands = NULL;
+}
+
+/* queue a slide of instance 'i' to 'slot' and upload it */
+static void slide_instance( wall_renderer *r, int i, int slot, double start ) {
+	wall_instance *t = &r->instances[i];
+	t->from_slot = t->to_slot;
+	t->to_slot = slot;
+	t->start_time = (float)start;
+	glBufferSubData( GL_ARRAY_BUFFER, i * sizeof( wall_instance ), sizeof( wall_instance ), t );
+	r->bytes_uploaded += sizeof( wall_instance );
+}
+
+void wall_renderer_update( wall_renderer *r, int index, board *b, double now ) {
+	if ( !b->dirty_all && 0 == b->dirty_count ) {
+		return;
+	}
+	int first = r->first_instance[index];
+	glBindBuffer( GL_ARRAY_BUFFER, r->tile_vbo );
+	if ( b->dirty_all ) {
+		// every tile of this board straight where it is
+		for ( int slot = 0; slot < b->n; slot++ ) {
+			wall_instance *t = &r->instances[first + b->tiles[slot]];
+			t->from_slot = slot;
+			t->to_slot = slot;
+			t->start_time = (float)( now - r->slide_seconds );
+		}
+		glBufferSubData( GL_ARRAY_BUFFER, first * sizeof( wall_instance ),
+										 b->n * sizeof( wall_instance ), &r->instances[first] );
+		r->bytes_uploaded += b->n * sizeof( wall_instance );
+		board_clear_dirty( b );
+		return;
+	}
+	int moved_tile = -1;
+	int moved_count = 0;
+	for ( int i = 0; i < b->dirty_count; i++ ) {
+		int slot = b->dirty[i];
+		int tile = b->tiles[slot];
+		if ( tile == b->n - 1 || r->instances[first + tile].to_slot == slot ) {
+			continue;
+		}
+		// a tile still sliding goes on from where that slide ends
+		double start = r->instances[first + tile].start_time + r->slide_seconds;
+		slide_instance( r, first + tile, slot, start > now ? start : now );
+		moved_tile = tile;
+		moved_count++;
+	}
+	int blank = b->n - 1;
+	if ( r->instances[first + blank].to_slot != b->blank ) {
+		// the blank slides the other way with the tile, as in board_renderer
+		double start = now;
+		if ( 1 == moved_count ) {
+			start = r->instances[first + moved_tile].start_time;
+		}
+		slide_instance( r, first + blank, b->blank, start );
+	}
+	board_clear_dirty( b );
+}
+
+void wall_renderer_show( wall_renderer *r, int index, bool visible ) {
+	int tiles = r->first_instance[index + 1] - r->first_instance[index];
+	GLuint instance_count = visible ? (GLuint)tiles : 0;
+	if ( r->commands[index].instance_count == instance_count ) {
+		return;
+	}
+	r->commands[index].instance_count = instance_count;
+	if ( index < r->changed_first ) {
+		r->changed_first = index;
+	}
+	if ( index > r->changed_last ) {
+		r->changed_last = index;
+	}
+}
+
+void wall_renderer_draw( wall_renderer *r, double now ) {
+	glUseProgram( r->programme );
+	glUniform1f( r->time_loc, (float)now );
+	glBindVertexArray( r->vao );
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, r->command_buffer );
+	if ( r->changed_first <= r->changed_last ) {
+		// only the commands patched since the last frame
+		glBufferSubData( GL_DRAW_INDIRECT_BUFFER, r->changed_first * sizeof( wall_command ),
+										 ( r->changed_last - r->changed_first + 1 ) * sizeof( wall_command ),
+										 &r->commands[r->changed_first] );
+		r->bytes_uploaded += ( r->changed_last - r->changed_first + 1 ) * sizeof( wall_command );
+		r->changed_first = r->board_count;
+		r->changed_last = -1;
+	}
+	glActiveTexture( GL_TEXTURE0 + INFO_TEXTURE_UNIT );
+	glBindTexture( GL_TEXTURE_BUFFER, r->info_texture );
+	glActiveTexture( GL_TEXTURE0 );
+	glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, 0, r->board_count, 0 );
+}
@@ -0,0 +1,78 @@
+/******************************************************************************\
+| Draws thousands of boards at once, a wall of them, in one call.             |
+| Every tile of every board is one instance in a single shared buffer, the   |
+| boards one after another, and every board is one command of a              |
+| glMultiDrawElementsIndirect() draw: the unit quad, as many instances as   |
+| the board has tiles, starting at the board's first one. The commands are   |
+| built once and only the ones that change (a board hidden or shown) are     |
+| uploaded again. Tiles slide on the GPU as in board_renderer, so a move     |
+| uploads two 16 byte instances and a frame costs the same few GL calls      |
+| whether the wall has one board or a hundred thousand. Boards may all be   |
+| different sizes: their rows and columns sit in a buffer texture.           |
+| Needs GL 4.3 or ARB_multi_draw_indirect.                                   |
+\******************************************************************************/
+#ifndef _WALL_RENDERER_H_
+#define _WALL_RENDERER_H_
+
+#include "board.h"
+#include <GL/glew.h>
+
+// per-instance vertex data, one per tile of every board
+struct wall_instance {
+	GLint from_slot;
+	GLint to_slot;
+	GLfloat start_time;
+	GLint board; // index of the board on the wall
+};
+
+// layout fixed by GL for glMultiDrawElementsIndirect
+struct wall_command {
+	GLuint count;
+	GLuint instance_count; // 0 hides the board
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+struct wall_renderer {
+	GLuint vao;
+	GLuint quad_vbo;
+	GLuint quad_ebo;
+	GLuint tile_vbo;			// every board's wall_instances, divisor 1
+	GLuint command_buffer; // GL_DRAW_INDIRECT_BUFFER, one wall_command per board
+	GLuint info_buffer;		// cols, rows per board, read through info_texture
+	GLuint info_texture;
+	GLuint programme;
+	GLint time_loc;
+	GLint slide_seconds_loc;
+	GLint wall_size_loc;
+	GLint board_info_loc;
+	int board_count;
+	int wall_cols; // boards across, wall_rows down
+	int wall_rows;
+	int *first_instance;		 // of every board in the instances, the total last
+	wall_instance *instances; // copy of tile_vbo
+	wall_command *commands;		 // copy of command_buffer
+	int changed_first;				 // commands to upload before the next draw,
+	int changed_last;					 // first > last for none
+	float slide_seconds;
+	unsigned long long bytes_uploaded;
+};
+
+/* uploads 'count' boards at rest, laid out in a near square grid. 'programme'
+is the linked wall_vs.glsl/test_fs.glsl pair */
+bool wall_renderer_init( wall_renderer *r, const board *boards, int count, GLuint programme );
+
+void wall_renderer_free( wall_renderer *r );
+
+/* starts the slides of board 'index' like board_renderer_update(): one small
+upload per tile that moved, and clears the board's dirty list */
+void wall_renderer_update( wall_renderer *r, int index, board *b, double now );
+
+/* hides or shows board 'index'. patches its command only */
+void wall_renderer_show( wall_renderer *r, int index, bool visible );
+
+/* the whole wall as it looks at time 'now': one multi-draw */
+void wall_renderer_draw( wall_renderer *r, double now );
+
+#endif
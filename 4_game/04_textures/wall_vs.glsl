@@ -0,0 +1,54 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;	// unit quad corner, y down
+layout (location = 1) in ivec2 aSlide;	// slot the tile gl_InstanceID slides from, to
+layout (location = 2) in float aStart;	// time that slide starts
+layout (location = 3) in int aBoard;		// which board of the wall the tile is on
+
+uniform isamplerBuffer board_info;	// cols, rows of every board
+uniform ivec2 wall_size;	// boards across, down
+uniform float time;
+uniform float slide_seconds;
+
+out vec2 TexCoord;
+out float Highlight;
+
+// the wall fills this much of the -1..1 clip space square
+const float wall_extent = 0.95;
+// a board fills this much of its cell on the wall, the rest is the gap
+const float board_fill = 0.9;
+
+vec2 slot_xy(int slot, int cols)
+{
+	return vec2(slot % cols, slot / cols);
+}
+
+void main()
+{
+	ivec2 size = texelFetch(board_info, aBoard).xy;
+	int cols = size.x;
+	int rows = size.y;
+	// every board is its own draw command, so this counts its tiles from 0
+	int tile = gl_InstanceID;
+	bool is_blank = tile == cols * rows - 1;
+
+	// eased 0..1 along the slide, 1 once it is over
+	float t = clamp((time - aStart) / slide_seconds, 0.0, 1.0);
+	t = t * t * (3.0 - 2.0 * t);
+	vec2 slot_pos = mix(slot_xy(aSlide.x, cols), slot_xy(aSlide.y, cols), t) + aCorner;
+	// 0..1 on the board, then into the board's cell of the wall
+	vec2 on_board = slot_pos / vec2(cols, rows);
+	vec2 cell = vec2(aBoard % wall_size.x, aBoard / wall_size.x);
+	vec2 on_wall = (cell + 0.5 + (on_board - 0.5) * board_fill) / vec2(wall_size);
+	vec2 pos = on_wall * (2.0 * wall_extent) - wall_extent;
+	// the blank goes behind the tile sliding over it
+	float depth = is_blank ? 0.5 : 0.0;
+	gl_Position = vec4(pos.x, -pos.y, depth, 1.0);
+
+	// texture coords come from the tile, wherever it is on the board
+	TexCoord = (slot_xy(tile, cols) + aCorner) / vec2(cols, rows);
+	Highlight = 0.0;
+	if (is_blank) {
+		// blank is drawn as a single texel from the middle of the image
+		TexCoord = vec2(0.5, 0.5);
+	}
+}
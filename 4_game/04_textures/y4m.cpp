@@ -0,0 +1,242 @@
+#include "y4m.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef Y4M_SIMD
+#include <emmintrin.h>
+#endif
+
+// BT.601 to RGB, times 64
+struct yuv_coeffs {
+	int y_offset;
+	int y;
+	int v_r;
+	int u_g;
+	int v_g;
+	int u_b;
+};
+static const yuv_coeffs studio_range = { 16, 75, 102, 25, 52, 129 };
+static const yuv_coeffs full_range = { 0, 64, 90, 22, 46, 113 };
+
+/* 16 bit lanes as in the SSE2 path: saturating sums, then >> 6 */
+static inline int saturate16( int x ) { return x < -32768 ? -32768 : ( x > 32767 ? 32767 : x ); }
+static inline unsigned char to_byte( int x ) {
+	x >>= 6;
+	return (unsigned char)( x < 0 ? 0 : ( x > 255 ? 255 : x ) );
+}
+
+static void row_scalar( const unsigned char *y, const unsigned char *u, const unsigned char *v,
+												int shift, int begin, int end, const yuv_coeffs *c, unsigned char *out ) {
+	for ( int x = begin; x < end; x++ ) {
+		int luma = saturate16( ( y[x] - c->y_offset ) * c->y + 32 ); // rounded
+		int cb = u[x >> shift] - 128;
+		int cr = v[x >> shift] - 128;
+		out[4 * x + 0] = to_byte( saturate16( luma + c->v_r * cr ) );
+		out[4 * x + 1] = to_byte( saturate16( saturate16( luma - c->u_g * cb ) - c->v_g * cr ) );
+		out[4 * x + 2] = to_byte( saturate16( luma + c->u_b * cb ) );
+		out[4 * x + 3] = 255;
+	}
+}
+
+#ifdef Y4M_SIMD
+/* 8 pixels of 16 bit Y, Cb, Cr (offsets taken off) to 8 of R, G, B */
+static inline void pixels8( __m128i luma, __m128i cb, __m128i cr, const yuv_coeffs *c, __m128i *r,
+														__m128i *g, __m128i *b ) {
+	const __m128i round = _mm_set1_epi16( 32 );
+	luma = _mm_adds_epi16( _mm_mullo_epi16( luma, _mm_set1_epi16( (short)c->y ) ), round );
+	*r = _mm_adds_epi16( luma, _mm_mullo_epi16( cr, _mm_set1_epi16( (short)c->v_r ) ) );
+	*g = _mm_subs_epi16( luma, _mm_mullo_epi16( cb, _mm_set1_epi16( (short)c->u_g ) ) );
+	*g = _mm_subs_epi16( *g, _mm_mullo_epi16( cr, _mm_set1_epi16( (short)c->v_g ) ) );
+	*b = _mm_adds_epi16( luma, _mm_mullo_epi16( cb, _mm_set1_epi16( (short)c->u_b ) ) );
+	*r = _mm_srai_epi16( *r, 6 );
+	*g = _mm_srai_epi16( *g, 6 );
+	*b = _mm_srai_epi16( *b, 6 );
+}
+
+/* 16 pixels a step, the tail in scalar code */
+static void row_simd( const unsigned char *y, const unsigned char *u, const unsigned char *v,
+											int shift, int width, const yuv_coeffs *c, unsigned char *out ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i y_offset = _mm_set1_epi16( (short)c->y_offset );
+	const __m128i chroma_offset = _mm_set1_epi16( 128 );
+	const __m128i alpha = _mm_set1_epi8( -1 );
+	int x = 0;
+	for ( ; x + 16 <= width; x += 16 ) {
+		__m128i y16 = _mm_loadu_si128( (const __m128i *)( y + x ) );
+		__m128i u16, v16;
+		if ( shift ) {
+			// 8 chroma samples, each for two pixels
+			__m128i u8 = _mm_loadl_epi64( (const __m128i *)( u + ( x >> 1 ) ) );
+			__m128i v8 = _mm_loadl_epi64( (const __m128i *)( v + ( x >> 1 ) ) );
+			u16 = _mm_unpacklo_epi8( u8, u8 );
+			v16 = _mm_unpacklo_epi8( v8, v8 );
+		} else {
+			u16 = _mm_loadu_si128( (const __m128i *)( u + x ) );
+			v16 = _mm_loadu_si128( (const __m128i *)( v + x ) );
+		}
+		__m128i r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+		pixels8( _mm_sub_epi16( _mm_unpacklo_epi8( y16, zero ), y_offset ),
+						 _mm_sub_epi16( _mm_unpacklo_epi8( u16, zero ), chroma_offset ),
+						 _mm_sub_epi16( _mm_unpacklo_epi8( v16, zero ), chroma_offset ), c, &r_lo, &g_lo,
+						 &b_lo );
+		pixels8( _mm_sub_epi16( _mm_unpackhi_epi8( y16, zero ), y_offset ),
+						 _mm_sub_epi16( _mm_unpackhi_epi8( u16, zero ), chroma_offset ),
+						 _mm_sub_epi16( _mm_unpackhi_epi8( v16, zero ), chroma_offset ), c, &r_hi, &g_hi,
+						 &b_hi );
+		__m128i r = _mm_packus_epi16( r_lo, r_hi );
+		__m128i g = _mm_packus_epi16( g_lo, g_hi );
+		__m128i b = _mm_packus_epi16( b_lo, b_hi );
+		// interleave to RGBA
+		__m128i rg_lo = _mm_unpacklo_epi8( r, g );
+		__m128i rg_hi = _mm_unpackhi_epi8( r, g );
+		__m128i ba_lo = _mm_unpacklo_epi8( b, alpha );
+		__m128i ba_hi = _mm_unpackhi_epi8( b, alpha );
+		__m128i *dst = (__m128i *)( out + 4 * x );
+		_mm_storeu_si128( dst + 0, _mm_unpacklo_epi16( rg_lo, ba_lo ) );
+		_mm_storeu_si128( dst + 1, _mm_unpackhi_epi16( rg_lo, ba_lo ) );
+		_mm_storeu_si128( dst + 2, _mm_unpacklo_epi16( rg_hi, ba_hi ) );
+		_mm_storeu_si128( dst + 3, _mm_unpackhi_epi16( rg_hi, ba_hi ) );
+	}
+	row_scalar( y, u, v, shift, x, width, c, out );
+}
+#endif
+
+static void frame_rgba( const y4m_video *v, int i, unsigned char *rgba, bool simd ) {
+	const yuv_coeffs *c = v->full_range ? &full_range : &studio_range;
+	const unsigned char *y_plane = v->frames[i];
+	const unsigned char *u_plane = y_plane + (size_t)v->width * v->height;
+	const unsigned char *v_plane = u_plane + (size_t)v->chroma_width * v->chroma_height;
+	int shift = v->half_chroma ? 1 : 0;
+	for ( int row = 0; row < v->height; row++ ) {
+		const unsigned char *y = y_plane + (size_t)row * v->width;
+		const unsigned char *u = u_plane + (size_t)( row >> shift ) * v->chroma_width;
+		const unsigned char *vv = v_plane + (size_t)( row >> shift ) * v->chroma_width;
+		unsigned char *out = rgba + 4 * (size_t)row * v->width;
+#ifdef Y4M_SIMD
+		if ( simd ) {
+			row_simd( y, u, vv, shift, v->width, c, out );
+			continue;
+		}
+#endif
+		row_scalar( y, u, vv, shift, 0, v->width, c, out );
+	}
+}
+
+void y4m_frame_rgba( const y4m_video *v, int i, unsigned char *rgba ) {
+	frame_rgba( v, i, rgba, true );
+}
+
+void y4m_frame_rgba_scalar( const y4m_video *v, int i, unsigned char *rgba ) {
+	frame_rgba( v, i, rgba, false );
+}
+
+/* is the C parameter, 'length' bytes at 'chroma', exactly 'tag'? */
+static bool chroma_is( const char *chroma, size_t length, const char *tag ) {
+	return strlen( tag ) == length && 0 == strncmp( chroma, tag, length );
+}
+
+/* the header's parameters, each a letter and a value up to the next space */
+static bool parse_header( y4m_video *v, const char *line, const char *end, const char *file_name ) {
+	const char *chroma = "420";
+	size_t chroma_length = 3;
+	v->width = 0;
+	v->height = 0;
+	v->rate_num = 25;
+	v->rate_den = 1;
+	v->full_range = false;
+	for ( const char *p = line; p < end; ) {
+		const char *word_end = p;
+		while ( word_end < end && ' ' != *word_end ) {
+			word_end++;
+		}
+		char value[64];
+		size_t length = word_end - p - 1;
+		if ( word_end > p && length < sizeof( value ) ) {
+			memcpy( value, p + 1, length );
+			value[length] = '\0';
+			switch ( *p ) {
+			case 'W': v->width = atoi( value ); break;
+			case 'H': v->height = atoi( value ); break;
+			case 'F': sscanf( value, "%d:%d", &v->rate_num, &v->rate_den ); break;
+			case 'C':
+				chroma = p + 1;
+				chroma_length = length;
+				break;
+			case 'X':
+				// other X tags (XYSCSS and such) leave the range as it is
+				if ( 0 == strcmp( value, "COLORRANGE=FULL" ) ) {
+					v->full_range = true;
+				} else if ( 0 == strcmp( value, "COLORRANGE=LIMITED" ) ) {
+					v->full_range = false;
+				}
+				break;
+			default: break; // interlacing, aspect ratio: a puzzle does not care
+			}
+		}
+		p = word_end + 1;
+	}
+	// the 8 bit ones only: 420p10 and the like have 2 byte samples
+	v->half_chroma = chroma_is( chroma, chroma_length, "420" ) ||
+									 chroma_is( chroma, chroma_length, "420jpeg" ) ||
+									 chroma_is( chroma, chroma_length, "420paldv" ) ||
+									 chroma_is( chroma, chroma_length, "420mpeg2" );
+	bool chroma_ok = v->half_chroma || chroma_is( chroma, chroma_length, "444" );
+	if ( v->width < 1 || v->height < 1 || v->rate_num < 1 || v->rate_den < 1 || !chroma_ok ) {
+		fprintf( stderr, "ERROR: %s is not 8 bit 4:2:0 or 4:4:4 y4m with a size and frame rate\n",
+						 file_name );
+		return false;
+	}
+	v->chroma_width = v->half_chroma ? ( v->width + 1 ) / 2 : v->width;
+	v->chroma_height = v->half_chroma ? ( v->height + 1 ) / 2 : v->height;
+	v->frame_bytes = (size_t)v->width * v->height + 2 * (size_t)v->chroma_width * v->chroma_height;
+	return true;
+}
+
+bool y4m_open( y4m_video *v, const char *file_name ) {
+	if ( !mapped_file_open_read( &v->file, file_name ) ) {
+		return false;
+	}
+	const char *data = (const char *)v->file.data;
+	const char *end = data + v->file.size;
+	const char *line_end = (const char *)memchr( data, '\n', v->file.size );
+	size_t magic_length = sizeof( Y4M_MAGIC ) - 1;
+	if ( !line_end || v->file.size < magic_length || 0 != memcmp( data, Y4M_MAGIC, magic_length ) ) {
+		fprintf( stderr, "ERROR: %s is not a YUV4MPEG2 file\n", file_name );
+		mapped_file_close( &v->file );
+		return false;
+	}
+	if ( !parse_header( v, data + magic_length, line_end, file_name ) ) {
+		mapped_file_close( &v->file );
+		return false;
+	}
+	// every frame: FRAME, maybe parameters, a newline, the planes
+	int capacity = 64;
+	v->frames = (const unsigned char **)malloc( capacity * sizeof( const unsigned char * ) );
+	v->frame_count = 0;
+	const char *p = line_end + 1;
+	while ( p + 5 <= end && 0 == memcmp( p, "FRAME", 5 ) ) {
+		const char *frame_line_end = (const char *)memchr( p, '\n', end - p );
+		if ( !frame_line_end || (size_t)( end - frame_line_end - 1 ) < v->frame_bytes ) {
+			break; // cut short, keep the frames before
+		}
+		if ( v->frame_count == capacity ) {
+			capacity *= 2;
+			v->frames =
+				(const unsigned char **)realloc( v->frames, capacity * sizeof( const unsigned char * ) );
+		}
+		v->frames[v->frame_count++] = (const unsigned char *)frame_line_end + 1;
+		p = frame_line_end + 1 + v->frame_bytes;
+	}
+	if ( 0 == v->frame_count ) {
+		fprintf( stderr, "ERROR: %s has no whole frames\n", file_name );
+		y4m_close( v );
+		return false;
+	}
+	return true;
+}
+
+void y4m_close( y4m_video *v ) {
+	free( v->frames );
+	v->frames = NULL;
+	mapped_file_close( &v->file );
+}
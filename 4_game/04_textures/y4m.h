@@ -0,0 +1,50 @@
+/******************************************************************************\
+| Uncompressed YUV4MPEG2 (.y4m) video, read straight from a mapped file.      |
+| The header gives the size, the frame rate and the chroma layout (4:2:0 in  |
+| any siting, or 4:4:4); every frame is a FRAME line and then the Y, U and V |
+| planes. The frames are found once at open, so any one of them is a pointer |
+| into the mapping. Conversion to RGBA is BT.601, studio range unless the    |
+| file says XCOLORRANGE=FULL, 16 pixels at a time with SSE2 (fixed point,    |
+| 6 fraction bits, saturating) and the same sums in scalar code for the rest |
+| of a row or without SSE2.                                                  |
+\******************************************************************************/
+#ifndef _Y4M_H_
+#define _Y4M_H_
+
+#include "mapped_file.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define Y4M_SIMD 1
+#endif
+
+#define Y4M_MAGIC "YUV4MPEG2 "
+
+struct y4m_video {
+	mapped_file file;
+	int width;
+	int height;
+	int rate_num; // frames a second is rate_num / rate_den
+	int rate_den;
+	bool half_chroma; // 4:2:0, else 4:4:4
+	bool full_range;
+	int chroma_width;
+	int chroma_height;
+	size_t frame_bytes; // the three planes
+	int frame_count;
+	const unsigned char **frames; // Y plane of every frame, in the mapping
+};
+
+/* maps 'file_name' and finds every frame. false, with an ERROR, for anything
+that is not 8 bit 4:2:0 or 4:4:4 */
+bool y4m_open( y4m_video *v, const char *file_name );
+
+void y4m_close( y4m_video *v );
+
+/* frame 'i' as RGBA rows, top first, 4 * width bytes each. safe to call from
+any thread */
+void y4m_frame_rgba( const y4m_video *v, int i, unsigned char *rgba );
+
+/* the same without SSE2, to check it against */
+void y4m_frame_rgba_scalar( const y4m_video *v, int i, unsigned char *rgba );
+
+#endif